@@ -0,0 +1,124 @@
+// Benchmark de varios documentos abiertos: una docena de registros
+// grandes, la mitad con ediciones, recorridos en ronda. Mide cuánto
+// tarda cambiar de documento (estacionar el activo, reconstruir el
+// siguiente y desalojar con trim) y cuánta memoria queda residente,
+// con y sin presupuesto.
+// Uso: ./build/bench_buffers [documentos] [MiB cada uno] [presupuesto MiB]
+//      (por defecto 12 documentos de 64 MiB y 256 MiB de presupuesto;
+//       presupuesto 0 = sin límite)
+
+#include "bufferlist.h"
+#include "editor.h"
+#include "journal.h"
+#include <ncurses.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// VmRSS del proceso, en MiB
+static double rssMiB() {
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    while (std::getline(in, line))
+        if (line.compare(0, 6, "VmRSS:") == 0) return atof(line.c_str() + 6) / 1024.0;
+    return 0;
+}
+
+static void writeLog(const std::string& path, size_t bytes, int seed) {
+    std::ofstream out(path, std::ios::binary);
+    std::string chunk;
+    for (size_t n = 0, i = 0; n < bytes; ++i) {
+        chunk += "2024-03-0" + std::to_string(seed % 9 + 1) + " 12:00:" + std::to_string(i % 60) +
+                 " INFO worker-" + std::to_string(i % 16) + " petición atendida en " +
+                 std::to_string(i % 977) + " ms\n";
+        if (chunk.size() >= (1u << 20)) {
+            out << chunk;
+            n += chunk.size();
+            chunk.clear();
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int    docs   = argc > 1 ? atoi(argv[1]) : 12;
+    size_t mib    = argc > 2 ? (size_t)atoi(argv[2]) : 64;
+    size_t budget = argc > 3 ? (size_t)atoi(argv[3]) : 256;
+    const int rows = 40;
+
+    const char* dir = getenv("TMPDIR");
+    std::string base = std::string(dir && *dir ? dir : "/tmp") + "/bench_buffers_" + std::to_string(getpid());
+    std::vector<std::string> paths;
+    for (int i = 0; i < docs; ++i) {
+        paths.push_back(base + "_" + std::to_string(i) + ".log");
+        writeLog(paths.back(), mib << 20, i);
+    }
+
+    FILE* devnull = fopen("/dev/null", "w");
+    newterm("xterm", devnull, stdin);
+    Editor ed(1, 0, rows, 120);
+    BufferList list;
+    list.setBudget(budget ? budget << 20 : SIZE_MAX);
+    printf("%d documentos de %zu MiB, presupuesto %s\n", docs, mib,
+           budget ? (std::to_string(budget) + " MiB").c_str() : "sin límite");
+
+    std::vector<size_t> idx;
+    for (const auto& p : paths) idx.push_back(list.add(p, "txt"));
+
+    // Primera pasada: abrir cada uno, leerlo entero y editar los pares
+    // (al principio, en el medio y al final)
+    size_t recovered;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < docs; ++i) {
+        list.activate(idx[i], ed, rows, recovered);
+        ed.loadAll();
+        if (i % 2 == 0) {
+            size_t size = ed.buffer().size();
+            for (size_t at : { size, size / 2, (size_t)0 }) {
+                ed.setCursorOffset(at);
+                ed.insertText("editado\n");
+            }
+        }
+        list.trim(ed);
+    }
+    printf("  %-34s: %8.3f s  RSS %7.1f MiB  contado %7.1f MiB\n", "abrir, leer y editar",
+           seconds(t0), rssMiB(), list.memoryBytes(ed) / 1048576.0);
+
+    // Ronda: cambiar al siguiente (con trim, como hace la aplicación)
+    // y moverse un poco por él
+    const int rounds = 3;
+    double worst = 0, total = 0, peak = 0;
+    for (int r = 0; r < rounds; ++r)
+        for (int i = 0; i < docs; ++i) {
+            auto t1 = std::chrono::steady_clock::now();
+            list.activate(idx[i], ed, rows, recovered);
+            list.trim(ed);
+            double s = seconds(t1);
+            worst = std::max(worst, s);
+            total += s;
+            ed.setCursorOffset(ed.buffer().size() / 3);
+            ed.insertText("x");
+            ed.undo();
+            peak = std::max(peak, rssMiB());
+        }
+    char what[64];
+    snprintf(what, sizeof what, "cambiar de documento (%d)", rounds * docs);
+    printf("  %-34s: %8.3f ms medio, %8.3f ms peor\n", what,
+           total / (rounds * docs) * 1e3, worst * 1e3);
+    printf("  %-34s: RSS %7.1f MiB máx, %7.1f MiB al final, contado %7.1f MiB\n", "memoria en la ronda",
+           peak, rssMiB(), list.memoryBytes(ed) / 1048576.0);
+
+    endwin();
+    for (const auto& p : paths) {
+        Journal::discard(p);
+        unlink(p.c_str());
+    }
+    return 0;
+}
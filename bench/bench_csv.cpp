@@ -0,0 +1,93 @@
+// Benchmark de la vista de tabla: indexar un CSV, ordenar por una
+// columna numérica y filtrar por una de texto, frente a la ruta
+// ingenua (partir cada fila en std::string por campo).
+// Uso: ./build/bench_csv [MiB]   (por defecto 1024 MiB)
+
+#include "csvtable.h"
+#include "textbuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Parte del CSV que se prueba con la ruta ingenua
+static const size_t kNaiveMiB = 128;
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t mib = argc > 1 ? (size_t)atoi(argv[1]) : 1024;
+
+    // Ventas sintéticas: algunas ciudades entre comillas (con coma)
+    static const char* kCities[] = { "Lima", "\"Buenos Aires, AR\"", "Quito", "Bogotá",
+                                     "\"La Paz, BO\"", "Santiago", "Montevideo" };
+    TextBuffer buf;
+    std::string text = "id,cliente,ciudad,monto,fecha\n";
+    for (unsigned i = 0; text.size() < (mib << 20); ++i) {
+        text += std::to_string(i) + ",cliente-" + std::to_string(i * 7919 % 100000) + "," +
+                kCities[i % 7] + "," + std::to_string((i * 2654435761u) % 100000 / 100.0) +
+                ",2024-" + std::to_string(1 + i % 12) + "-" + std::to_string(1 + i % 28) + "\n";
+    }
+    buf.insert(0, text);
+    double gb = text.size() / 1e9;
+    TextSnapshot snap = buf.snapshot(true);
+    printf("%.2f GB\n", gb);
+
+    // Ruta ingenua: todas las celdas como std::string (sin comillas).
+    // Sólo sobre los primeros kNaiveMiB: entera no entra en memoria.
+    const size_t naiveBytes = std::min(text.size(), kNaiveMiB << 20);
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::vector<std::string>> cells;
+    size_t cellBytes = 0;
+    {
+        std::vector<std::string> row;
+        std::string cur;
+        bool quoted = false;
+        for (size_t i = 0; i < naiveBytes; ++i) {
+            char c = text[i];
+            if (c == '"') { quoted = !quoted; continue; }
+            if (!quoted && c == ',') { row.push_back(cur); cur.clear(); continue; }
+            if (!quoted && c == '\n') {
+                row.push_back(cur);
+                for (const std::string& cell : row) cellBytes += sizeof(std::string) + cell.capacity();
+                cur.clear();
+                cells.push_back(std::move(row));
+                row.clear();
+                continue;
+            }
+            cur += c;
+        }
+    }
+    double naive = seconds(t0);
+    printf("  partir en std::string : %7.3f s  %6.2f GB/s  %zu filas, %.1f MiB  (primeros %zu MiB)\n",
+           naive, naiveBytes / 1e9 / naive, cells.size(), cellBytes / 1048576.0, kNaiveMiB);
+    cells.clear();
+    cells.shrink_to_fit();
+    text.clear();
+    text.shrink_to_fit();
+
+    CsvTable table;
+    t0 = std::chrono::steady_clock::now();
+    table.build(snap, CsvTable::detectDelimiter(snap));
+    double built = seconds(t0);
+    printf("  CsvTable::build       : %7.3f s  %6.2f GB/s  %zu filas, %zu columnas, %.1f MiB\n",
+           built, gb / built, table.rowCount(), table.columnCount(),
+           table.rowCount() * sizeof(uint64_t) / 1048576.0);
+
+    t0 = std::chrono::steady_clock::now();
+    table.sortBy(3, true);
+    double sorted = seconds(t0);
+    CsvTable::Field f;
+    table.field(table.viewRow(0), 3, f);
+    printf("  ordenar por monto     : %7.3f s  (mayor: %s)\n", sorted, table.text(f).c_str());
+
+    t0 = std::chrono::steady_clock::now();
+    table.filterBy(2, "buenos aires");
+    double filtered = seconds(t0);
+    printf("  filtrar ciudad        : %7.3f s  %zu filas\n", filtered, table.viewCount());
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Benchmark de la etapa de codificación al cargar y guardar: validar
+// UTF-8 (texto latino y texto CJK), deducir la codificación, pasar
+// Latin-1 / UTF-16 a UTF-8 y de vuelta, frente a memcpy (el ancho de
+// banda de la memoria) y a validar decodificando byte a byte.
+// Uso: ./build/bench_encoding [MiB]   (por defecto 256 MiB)
+
+#include "transcoder.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Validación anterior: decodificar cada carácter (como mbrtowc)
+static bool validNaive(const std::string& s) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(s.data());
+    size_t n = s.size();
+    for (size_t i = 0; i < n;) {
+        unsigned c = p[i];
+        int need = c < 0x80 ? 1 : c >= 0xC2 && c < 0xE0 ? 2 : c >= 0xE0 && c < 0xF0 ? 3 :
+                   c >= 0xF0 && c < 0xF5 ? 4 : 0;
+        if (need == 0 || i + need > n) return false;
+        uint32_t cp = need == 1 ? c : c & (0x7F >> need);
+        for (int k = 1; k < need; ++k) {
+            if ((p[i + k] & 0xC0) != 0x80) return false;
+            cp = (cp << 6) | (p[i + k] & 0x3F);
+        }
+        if ((need == 3 && (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF))) ||
+            (need == 4 && (cp < 0x10000 || cp > 0x10FFFF)))
+            return false;
+        i += need;
+    }
+    return true;
+}
+
+static std::string makeText(size_t bytes, const char* line) {
+    std::string s;
+    s.reserve(bytes + 256);
+    while (s.size() < bytes) s += line;
+    return s;
+}
+
+// bytes = 0: no recorre el texto entero (sólo se informa el tiempo)
+static void report(const char* what, double secs, size_t bytes, const char* extra = "") {
+    if (bytes == 0) printf("  %-30s: %8.3f s               %s\n", what, secs, extra);
+    else printf("  %-30s: %8.3f s  %6.2f GB/s  %s\n", what, secs, bytes / 1e9 / secs, extra);
+}
+
+int main(int argc, char* argv[]) {
+    size_t mib   = argc > 1 ? (size_t)atoi(argv[1]) : 256;
+    size_t bytes = mib << 20;
+
+    std::string latin = makeText(bytes, "Informe anual: la producción creció un 4,5 % en el año — fin.\n");
+    std::string cjk   = makeText(bytes, "漢字かな交じり文の行、そして😀絵文字。\n");
+    printf("%zu MiB por muestra, validador %s\n", mib, Transcoder::backend());
+
+    std::unique_ptr<char[]> out(new char[3 * bytes + 64]);
+    memset(out.get(), 0, 3 * bytes + 64);   // que las páginas ya existan
+
+    auto t0 = std::chrono::steady_clock::now();
+    memcpy(out.get(), latin.data(), latin.size());
+    report("memcpy (referencia)", seconds(t0), latin.size());
+
+    t0 = std::chrono::steady_clock::now();
+    bool ok = validNaive(latin);
+    report("validar byte a byte", seconds(t0), latin.size(), ok ? "" : "(inválido)");
+
+    t0 = std::chrono::steady_clock::now();
+    ok = Transcoder::validUtf8(latin.data(), latin.size());
+    report("validar UTF-8 (latino)", seconds(t0), latin.size(), ok ? "" : "(inválido)");
+
+    t0 = std::chrono::steady_clock::now();
+    ok = Transcoder::validUtf8(cjk.data(), cjk.size());
+    report("validar UTF-8 (CJK)", seconds(t0), cjk.size(), ok ? "" : "(inválido)");
+
+    // Lo que guardaría un programa en Latin-1 y en UTF-16
+    size_t written;
+    std::string l1(latin.size(), '\0');
+    t0 = std::chrono::steady_clock::now();
+    Transcoder::fromUtf8(Charset::Latin1, latin.data(), latin.size(), &l1[0], written, true);
+    report("UTF-8 -> Latin-1 (guardar)", seconds(t0), latin.size());
+    l1.resize(written);
+
+    std::string u16(2 * latin.size(), '\0');
+    t0 = std::chrono::steady_clock::now();
+    Transcoder::fromUtf8(Charset::UTF16LE, latin.data(), latin.size(), &u16[0], written, true);
+    report("UTF-8 -> UTF-16 (guardar)", seconds(t0), latin.size());
+    u16.resize(written);
+
+    t0 = std::chrono::steady_clock::now();
+    TextEncoding enc = Transcoder::detect(l1.data(), l1.size());
+    report("detectar (Latin-1)", seconds(t0), l1.size(), Transcoder::name(enc));
+
+    t0 = std::chrono::steady_clock::now();
+    size_t len = Transcoder::toUtf8(enc, l1.data(), l1.size(), out.get());
+    report("Latin-1 -> UTF-8 (cargar)", seconds(t0), l1.size(),
+           len == latin.size() && memcmp(out.get(), latin.data(), len) == 0 ? "" : "(NO coincide)");
+
+    t0 = std::chrono::steady_clock::now();
+    enc = Transcoder::detect(u16.data(), u16.size());
+    report("detectar (UTF-16, muestra)", seconds(t0), 0, Transcoder::name(enc));
+
+    t0 = std::chrono::steady_clock::now();
+    len = Transcoder::toUtf8(enc, u16.data(), u16.size(), out.get());
+    report("UTF-16 -> UTF-8 (cargar)", seconds(t0), u16.size(),
+           len == latin.size() && memcmp(out.get(), latin.data(), len) == 0 ? "" : "(NO coincide)");
+    return 0;
+}
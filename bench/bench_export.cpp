@@ -0,0 +1,122 @@
+// Benchmark de exportación: ruta anterior (una std::string por línea,
+// escape carácter a carácter) frente a los exportadores en streaming,
+// con el volcado del texto plano como referencia de velocidad de disco.
+// Uso: ./build/bench_export [MiB] [archivo]   (por defecto 1024 MiB, /tmp/bench_export.out)
+
+#include "exporter.h"
+#include "filemanager.h"
+#include "textbuffer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Ruta anterior: línea a línea, copiada y escapada en una std::string
+static bool oldExport(const TextSnapshot& snap, FileFormat fmt, int fd) {
+    std::string out, cur, row;
+    auto line = [&](const std::string& l) {
+        row.clear();
+        if (fmt == FileFormat::HTML) {
+            for (char c : l) {
+                if      (c == '&') row += "&amp;";
+                else if (c == '<') row += "&lt;";
+                else if (c == '>') row += "&gt;";
+                else if (c == '"') row += "&quot;";
+                else               row += c;
+            }
+            row += "<br>\n";
+        } else {
+            bool q = l.find(',') != std::string::npos || l.find('"') != std::string::npos;
+            if (q) row += '"';
+            for (char c : l) {
+                if (q && c == '"') row += '"';
+                row += c;
+            }
+            if (q) row += '"';
+            row += '\n';
+        }
+        out += row;
+        if (out.size() >= (8u << 20)) {
+            if (write(fd, out.data(), out.size()) != (ssize_t)out.size()) return false;
+            out.clear();
+        }
+        return true;
+    };
+    bool ok = snap.forEachSpanWhile(0, snap.size(), [&](const char* p, size_t n) {
+        size_t pos = 0;
+        while (pos < n) {
+            const char* nl = (const char*)memchr(p + pos, '\n', n - pos);
+            if (!nl) break;
+            cur.append(p + pos, nl - (p + pos));
+            if (!cur.empty() && cur.back() == '\r') cur.pop_back();
+            if (!line(cur)) return false;
+            cur.clear();
+            pos = nl - p + 1;
+        }
+        cur.append(p + pos, n - pos);
+        return true;
+    });
+    ok = ok && line(cur);
+    return ok && write(fd, out.data(), out.size()) == (ssize_t)out.size();
+}
+
+int main(int argc, char* argv[]) {
+    size_t mib = argc > 1 ? (size_t)atoi(argv[1]) : 1024;
+    std::string path = argc > 2 ? argv[2] : "/tmp/bench_export.out";
+
+    // Documento sintético tipo log con algo que escapar cada tanto
+    TextBuffer buf;
+    std::string text;
+    for (unsigned i = 0; text.size() < (mib << 20); ++i) {
+        text += "2024-01-01 12:00:00 [worker-" + std::to_string(i % 97) +
+                "] request handled in " + std::to_string(i % 1000) + " ms";
+        if (i % 20 == 0) text += ", status=\"<timeout>\" & retry";
+        text += '\n';
+    }
+    buf.insert(0, text);
+    double gb = text.size() / 1e9;
+    text.clear();
+    text.shrink_to_fit();
+    TextSnapshot snap = buf.snapshot(true);
+    printf("%.2f GB, destino %s\n", gb, path.c_str());
+
+    auto run = [&](const char* label, const std::function<bool(int)>& fn) {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            perror(path.c_str());
+            exit(1);
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = fn(fd);
+        double s = seconds(t0);
+        off_t out = lseek(fd, 0, SEEK_END);
+        ::close(fd);
+        printf("  %-22s %7.3f s  %6.2f GB/s de entrada  (%.2f GB escritos)%s\n",
+               label, s, gb / s, out / 1e9, ok ? "" : "  ERROR");
+    };
+    auto stream = [&](FileFormat fmt) {
+        return [&snap, fmt](int fd) {
+            ExportSink sink(fd);
+            return ExporterRegistry::create(fmt)->write(snap, sink, nullptr) && sink.finish();
+        };
+    };
+
+    run("texto plano",          stream(FileFormat::TXT));
+    run("HTML (anterior)",      [&](int fd) { return oldExport(snap, FileFormat::HTML, fd); });
+    run("HTML (streaming)",     stream(FileFormat::HTML));
+    run("CSV (anterior)",       [&](int fd) { return oldExport(snap, FileFormat::CSV, fd); });
+    run("CSV (streaming)",      stream(FileFormat::CSV));
+    // Sólo se borra si es un archivo común (no /dev/null)
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) ::unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,109 @@
+// Benchmark del resaltado incremental sobre un Markdown grande: costo
+// de un fotograma (50 filas) al abrir, tras saltar al final, al teclear
+// y al abrir / cerrar un bloque de código arriba, frente a tokenizar
+// desde el inicio del documento en cada fotograma.
+// Uso: ./build/bench_highlight [MiB]   (por defecto 256 MiB)
+
+#include "highlighter.h"
+#include "textbuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static const int kRows = 50;
+static const std::chrono::microseconds kFrame(400);
+static const std::chrono::microseconds kIdle(4000);
+
+static double millis(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t mib = argc > 1 ? (size_t)atoi(argv[1]) : 256;
+
+    static const char* kLines[] = {
+        "# Capítulo", "", "Texto con *énfasis*, **negrita** y `código` en línea.",
+        "- elemento de lista con [un enlace](https://example.com)", "```", "int x = 0;",
+        "```", "> una cita <!-- con comentario -->", "1. otro elemento", "Párrafo común." };
+    std::string text;
+    for (unsigned i = 0; text.size() < (mib << 20); ++i) {
+        text += kLines[i % 10];
+        text += '\n';
+    }
+    TextBuffer buf;
+    buf.insert(0, text);
+    int lines = buf.lineCount();
+    printf("%.0f MiB, %d líneas\n", text.size() / 1048576.0, lines);
+
+    Highlighter hl(buf);
+    hl.setGrammar(GrammarRegistry::create("md"));
+    std::vector<uint32_t> states;
+
+    auto frame = [&](const char* label, int row) {
+        auto t0 = std::chrono::steady_clock::now();
+        bool exact = hl.states(row, kRows, lines, kFrame, states);
+        printf("  %-34s: %8.3f ms%s\n", label, millis(t0), exact ? "" : "  (provisorio)");
+        return exact;
+    };
+
+    frame("abrir (fila 0)", 0);
+
+    int last = lines - kRows;
+    auto t0 = std::chrono::steady_clock::now();
+    bool exact = frame("saltar al final", last);
+    int idle = 0;
+    while (!exact) {
+        hl.settle(last, lines, kIdle);
+        ++idle;
+        exact = hl.states(last, kRows, lines, kFrame, states);
+    }
+    printf("  %-34s: %8.3f ms  (%d vueltas ociosas)\n", "  hasta el estado exacto", millis(t0), idle);
+    frame("repintar al final", last);
+
+    // Teclear en medio de la pantalla del final
+    uint64_t at = buf.lineStart(last + kRows / 2);
+    double worst = 0, total = 0;
+    for (int i = 0; i < 100; ++i) {
+        auto t1 = std::chrono::steady_clock::now();
+        buf.insert(at + i, "x");
+        hl.noteEdit(last + kRows / 2, 0);
+        hl.states(last, kRows, lines, kFrame, states);
+        double ms = millis(t1);
+        worst = std::max(worst, ms);
+        total += ms;
+    }
+    printf("  %-34s: %8.3f ms  (peor %.3f ms, incluye el insert)\n", "teclear al final (x100)",
+           total / 100, worst);
+
+    // Abrir un bloque de código arriba: todo lo que sigue cambia de estado
+    frame("volver a la fila 0", 0);
+    t0 = std::chrono::steady_clock::now();
+    buf.insert(buf.lineStart(2), "```\n");
+    hl.noteEdit(2, 1);
+    lines = buf.lineCount();
+    hl.states(0, kRows, lines, kFrame, states);
+    printf("  %-34s: %8.3f ms\n", "abrir ``` en la fila 2", millis(t0));
+    t0 = std::chrono::steady_clock::now();
+    buf.erase(buf.lineStart(2), 4);
+    hl.noteEdit(2, -1);
+    lines = buf.lineCount();
+    hl.states(0, kRows, lines, kFrame, states);
+    printf("  %-34s: %8.3f ms\n", "cerrarlo (converge)", millis(t0));
+    frame("saltar al final otra vez", last);
+
+    // Referencia: tokenizar desde el inicio hasta la pantalla del final
+    std::unique_ptr<Grammar> g = GrammarRegistry::create("md");
+    t0 = std::chrono::steady_clock::now();
+    uint32_t state = 0;
+    size_t pos = 0;
+    for (int row = 0; row < last && pos < text.size(); ++row) {
+        size_t nl = text.find('\n', pos);
+        state = g->tokenize(text.data() + pos, nl - pos, state, nullptr);
+        pos = nl + 1;
+    }
+    printf("  %-34s: %8.3f ms  (estado %u)\n", "desde el inicio, cada fotograma", millis(t0), state);
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Benchmark de inserción masiva: Editor::insertText (un único insert en
+// la tabla de piezas) frente al recorrido tecla a tecla que hacía antes
+// (insertChar / insertNewline por cada byte, vía handleInput).
+// Uso: ./build/bench_insert [MiB...]   (por defecto 1 y 100 MiB)
+//
+// El Editor necesita ncurses: se abre una terminal contra /dev/null.
+
+#include "editor.h"
+#include <ncurses.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Tecla a tecla es muy lento: se mide sólo hasta este tamaño
+static const size_t kPerKeyMaxBytes = 1 << 20;
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Bloque generado tipo log, como el que insertaría un plugin
+static std::string makeText(size_t bytes) {
+    std::string text;
+    text.reserve(bytes + 128);
+    for (unsigned i = 0; text.size() < bytes; ++i) {
+        text += "2024-01-01 12:00:00 [plugin] línea generada " + std::to_string(i) +
+                " con algo de texto de relleno";
+        text += '\n';
+    }
+    text.resize(bytes);
+    return text;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) sizes.push_back((size_t)atoi(argv[i]));
+    if (sizes.empty()) sizes = { 1, 100 };
+
+    setenv("TERM", "xterm", 0);
+    FILE* devnull = fopen("/dev/null", "w");
+    SCREEN* scr = newterm(nullptr, devnull, stdin);
+    if (!scr) {
+        fprintf(stderr, "no se pudo iniciar ncurses\n");
+        return 1;
+    }
+    start_color();
+
+    std::vector<std::pair<std::string, double>> rows;
+    for (size_t mib : sizes) {
+        std::string text = makeText(mib << 20);
+        std::string label = std::to_string(mib) + " MiB";
+
+        {
+            Editor ed(0, 0, 24, 80);
+            auto t0 = std::chrono::steady_clock::now();
+            ed.insertText(text);
+            double s = seconds(t0);
+            rows.push_back({ "insertText " + label + " (" +
+                             std::to_string(ed.lineCount()) + " líneas)", s });
+        }
+
+        if (text.size() <= kPerKeyMaxBytes) {
+            Editor ed(0, 0, 24, 80);
+            auto t0 = std::chrono::steady_clock::now();
+            for (char c : text) ed.handleInput((unsigned char)c);
+            rows.push_back({ "tecla a tecla " + label, seconds(t0) });
+        }
+    }
+
+    endwin();
+    delscreen(scr);
+    fclose(devnull);
+
+    for (auto& r : rows)
+        printf("  %-40s: %8.3f s\n", r.first.c_str(), r.second);
+    return 0;
+}
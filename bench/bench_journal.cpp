@@ -0,0 +1,123 @@
+// Benchmark del diario de ediciones: costo de registrar cada tecla en
+// el hilo de la interfaz (con y sin diario), la peor tecla, el tamaño
+// por edición en disco y el tiempo de recuperar con Journal::replay.
+// Uso: ./build/bench_journal [teclas]   (por defecto 200000)
+//
+// El Editor necesita ncurses: se abre una terminal contra /dev/null.
+
+#include "editor.h"
+#include "filemanager.h"
+#include "journal.h"
+#include <ncurses.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Teclas de una sesión de escritura: texto, saltos de línea y borrados
+static std::vector<int> makeKeys(size_t n) {
+    static const char kText[] = "el veloz murcielago hindu comia feliz cardillo y kiwi ";
+    std::vector<int> keys;
+    keys.reserve(n);
+    for (size_t i = 0; keys.size() < n; ++i) {
+        char c = kText[i % (sizeof(kText) - 1)];
+        keys.push_back((unsigned char)c);
+        if (i % 61 == 60) keys.push_back('\n');
+        if (i % 17 == 16) keys.push_back(KEY_BACKSPACE);
+    }
+    keys.resize(n);
+    return keys;
+}
+
+struct Run {
+    double      total;
+    double      worst;
+    std::string text;   // documento final
+};
+
+static Run type(const std::string& path, const std::vector<int>& keys, bool journal) {
+    TextBuffer buf;
+    FileManager::load(path, buf);
+    Editor ed(0, 0, 24, 80);
+    ed.setBuffer(std::move(buf));
+    if (journal) ed.journal().open(path);
+
+    Run r = { 0, 0, "" };
+    auto t0 = std::chrono::steady_clock::now();
+    for (int k : keys) {
+        auto t = std::chrono::steady_clock::now();
+        ed.handleInput(k);
+        r.worst = std::max(r.worst, seconds(t));
+    }
+    r.total = seconds(t0);
+    r.text  = ed.getText();
+    // Cierre "sucio": el diario queda en disco como tras un corte
+    if (journal) ed.journal().close(false);
+    return r;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? (size_t)atol(argv[1]) : 200000;
+
+    char path[] = "/tmp/bench_journal_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    std::string seed;
+    for (int i = 0; i < 20000; ++i)
+        seed += "linea " + std::to_string(i) + " del archivo original\n";
+    if (write(fd, seed.data(), seed.size()) != (ssize_t)seed.size()) return 1;
+    close(fd);
+
+    setenv("TERM", "xterm", 0);
+    FILE* devnull = fopen("/dev/null", "w");
+    SCREEN* scr = newterm(nullptr, devnull, stdin);
+    if (!scr) {
+        fprintf(stderr, "no se pudo iniciar ncurses\n");
+        return 1;
+    }
+    start_color();
+
+    std::vector<int> keys = makeKeys(n);
+    Run off = type(path, keys, false);
+    Run on  = type(path, keys, true);
+
+    std::string jpath = Journal::pathFor(path);
+    struct stat st;
+    uint64_t jsize = stat(jpath.c_str(), &st) == 0 ? (uint64_t)st.st_size : 0;
+
+    TextBuffer rec;
+    FileManager::load(path, rec);
+    auto t0 = std::chrono::steady_clock::now();
+    size_t applied = Journal::replay(path, rec);
+    double replay = seconds(t0);
+    std::string recovered = rec.text();
+
+    endwin();
+    delscreen(scr);
+    fclose(devnull);
+    unlink(jpath.c_str());
+    unlink(path);
+
+    printf("  %zu teclas\n", n);
+    printf("  %-34s: %8.3f s  (%6.0f ns/tecla, peor %.3f ms)\n", "sin diario",
+           off.total, off.total * 1e9 / n, off.worst * 1e3);
+    printf("  %-34s: %8.3f s  (%6.0f ns/tecla, peor %.3f ms)\n", "con diario",
+           on.total, on.total * 1e9 / n, on.worst * 1e3);
+    printf("  %-34s: %8.1f %%\n", "sobrecosto", (on.total / off.total - 1) * 100);
+    printf("  %-34s: %8llu B  (%.1f B/edición)\n", "diario en disco",
+           (unsigned long long)jsize, applied ? (double)jsize / applied : 0.0);
+    printf("  %-34s: %8.3f s  (%zu ediciones, %s)\n", "replay", replay, applied,
+           recovered == on.text ? "idéntico" : "DISTINTO");
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Benchmark del indexador de líneas frente al cargador anterior
+// (std::getline + quitar '\r' en un vector<string>).
+// Uso: ./build/bench_lineindex [archivo]   (sin archivo genera 256 MiB)
+
+#include "lineindexer.h"
+#include "mappedfile.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static std::string makeSample(size_t bytes) {
+    std::string path = "/tmp/bench_lineindex.txt";
+    std::ofstream f(path, std::ios::binary);
+    std::string line;
+    size_t written = 0;
+    for (unsigned i = 0; written < bytes; ++i) {
+        // Líneas de largo variable, algunas con CRLF
+        line.assign(20 + (i * 7919) % 120, 'a' + i % 26);
+        line += (i % 5 == 0) ? "\r\n" : "\n";
+        f << line;
+        written += line.size();
+    }
+    return path;
+}
+
+// Cargador anterior de FileManager::load
+static size_t loadGetline(const std::string& path) {
+    std::ifstream f(path);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(f, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        lines.push_back(line);
+    }
+    return lines.size();
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : makeSample(256u << 20);
+    auto file = MappedFile::open(path);
+    if (!file) {
+        fprintf(stderr, "No se pudo abrir %s\n", path.c_str());
+        return 1;
+    }
+    double gb = file->size() / 1e9;
+    printf("%s: %.2f GB, backend %s, %u hilos\n", path.c_str(), gb,
+           LineIndexer::backend(), std::thread::hardware_concurrency());
+
+    // Calentar la caché de páginas
+    volatile char sink = 0;
+    for (size_t i = 0; i < file->size(); i += 4096) sink += file->data()[i];
+
+    auto t0 = std::chrono::steady_clock::now();
+    size_t n0 = loadGetline(path);
+    double s0 = seconds(t0);
+    printf("  getline (anterior) : %8.3f s  %6.2f GB/s  %zu líneas\n", s0, gb / s0, n0);
+
+    std::vector<uint64_t> lfs;
+    lfs.reserve(file->size() / 64);
+    t0 = std::chrono::steady_clock::now();
+    LineIndexer::scan(file->data(), file->size(), 0, lfs);
+    double s1 = seconds(t0);
+    printf("  scan (1 hilo)      : %8.3f s  %6.2f GB/s  %zu saltos\n", s1, gb / s1, lfs.size());
+
+    lfs.clear();
+    lfs.shrink_to_fit();
+    t0 = std::chrono::steady_clock::now();
+    LineIndexer::scanParallel(file->data(), file->size(), 0, lfs);
+    double s2 = seconds(t0);
+    printf("  scanParallel       : %8.3f s  %6.2f GB/s  %zu saltos\n", s2, gb / s2, lfs.size());
+    return 0;
+}
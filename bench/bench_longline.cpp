@@ -0,0 +1,115 @@
+// Benchmark de una línea enorme (JSON minificado en una sola línea, con
+// UTF-8, entre líneas comunes): costo de teclear en el medio y de
+// pintar la ventana visible en distintas columnas (desplazamiento
+// horizontal), con y sin ajuste de línea, frente a copiar y tokenizar
+// la línea entera en cada fotograma.
+// Uso: ./build/bench_longline [MiB]   (por defecto 50 MiB)
+
+#include "columnmap.h"
+#include "highlighter.h"
+#include "textbuffer.h"
+#include "wrapindex.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static const int kWidth = 80;
+static const int kRows  = 50;
+static const int kKeys  = 1000;
+static const std::chrono::microseconds kFrame(400);
+
+static double millis(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t mib = argc > 1 ? (size_t)atoi(argv[1]) : 50;
+
+    std::string text;
+    for (int i = 0; i < 100; ++i) text += "<p>línea común</p>\n";
+    const char* kItem = "{\"id\":12345,\"name\":\"<b>ñandú</b>\",\"tags\":[\"a\",\"漢\"]},";
+    size_t big = text.size();
+    while (text.size() - big < (mib << 20)) text += kItem;
+    text += '\n';
+    for (int i = 0; i < 100; ++i) text += "<p>línea común</p>\n";
+
+    TextBuffer buf;
+    buf.insert(0, text);
+    int lines = buf.lineCount();
+    const int row = 100;
+    printf("línea de %.1f MiB entre %d líneas\n", buf.lineLength(row) / 1048576.0, lines - 1);
+
+    Highlighter hl(buf);
+    hl.setGrammar(GrammarRegistry::create("html"));
+    ColumnMap cols(buf);
+    cols.reset();
+    WrapIndex wrap;
+    wrap.reset(kWidth);
+    std::vector<uint32_t> states;
+
+    // Pintar la ventana: sólo los bytes visibles de cada fila, desde el
+    // carácter que ocupa la columna
+    auto paint = [&](uint64_t col, int rows) {
+        size_t bytes = 0;
+        for (int r = 0; r < rows; ++r) {
+            uint64_t from = cols.byteAt(row, col + (uint64_t)r * kWidth);
+            bytes += buf.substr(buf.lineStart(row) + from, kWidth * 4).size();
+        }
+        return bytes;
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    wrap.measure(cols, lines);
+    hl.states(row - kRows / 2, kRows, lines, kFrame, states);
+    paint(0, 1);
+    printf("  %-34s: %8.3f ms  (%llu columnas)\n", "primer fotograma (medir la línea)",
+           millis(t0), (unsigned long long)cols.width(row));
+
+    // Desplazamiento horizontal por toda la línea
+    uint64_t width = cols.width(row);
+    t0 = std::chrono::steady_clock::now();
+    size_t bytes = 0;
+    for (int i = 0; i < kKeys; ++i) bytes += paint(width / kKeys * i, 1);
+    printf("  %-34s: %8.3f us\n", "ventana en otra columna", millis(t0) * 1000 / kKeys);
+
+    // Con ajuste de línea: toda la pantalla son filas de la misma línea
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kKeys; ++i) {
+        int sub;
+        int64_t vrow = wrap.rowsBefore(row) + wrap.rows(row) / kKeys * i;
+        wrap.lineAtRow(vrow, sub);
+        bytes += paint((uint64_t)sub * kWidth, kRows);
+    }
+    printf("  %-34s: %8.3f us\n", "pantalla ajustada en otra fila", millis(t0) * 1000 / kKeys);
+
+    // Teclear en el medio de la línea
+    uint64_t col = cols.byteAt(row, width / 2);
+    uint64_t at  = buf.lineStart(row) + col;
+    double worst = 0;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kKeys; ++i) {
+        auto t1 = std::chrono::steady_clock::now();
+        buf.insert(at + i, "x");
+        cols.noteEdit(row, col + i, 0, 1, 0);
+        wrap.replaceLines(cols, row, 1, 1);
+        hl.noteEdit(row, 0);
+        hl.states(row - kRows / 2, kRows, lines, kFrame, states);
+        bytes += paint(cols.columnAt(row, col + i + 1), 1);
+        worst = std::max(worst, millis(t1));
+    }
+    printf("  %-34s: %8.3f us  (peor %.3f ms)\n", "teclear en el medio", millis(t0) * 1000 / kKeys,
+           worst);
+
+    // Referencia: copiar y tokenizar la línea entera en cada fotograma
+    std::unique_ptr<Grammar> g = GrammarRegistry::create("html");
+    std::vector<Token> tokens;
+    t0 = std::chrono::steady_clock::now();
+    std::string line = buf.line(row);
+    g->tokenize(line.data(), line.size(), 0, &tokens);
+    printf("  %-34s: %8.1f ms  (%zu tokens)\n", "línea entera, cada fotograma", millis(t0),
+           tokens.size());
+    return bytes == 0;
+}
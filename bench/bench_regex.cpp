@@ -0,0 +1,142 @@
+// Benchmark de búsqueda y reemplazo con expresiones regulares: std::regex
+// línea por línea frente a Regex (DFA perezoso como filtro + máquina de
+// Pike en las líneas candidatas), en un hilo y repartido en el pool como
+// hace Editor::findReplace con "reemplazar todo".
+// Uso: ./build/bench_regex [MiB] [patrón] [reemplazo]
+//      (por defecto 256 MiB, "ERROR (\w+)", "E:$1")
+
+#include "regex.h"
+#include "textbuffer.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <regex>
+#include <string>
+#include <vector>
+
+// std::regex es muy lento: se mide sobre un prefijo y se informa GB/s
+static const size_t kStdRegexMiB = 8;
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t mib = argc > 1 ? (size_t)atoi(argv[1]) : 256;
+    std::string pattern = argc > 2 ? argv[2] : "ERROR (\\w+)";
+    std::string replacement = argc > 3 ? argv[3] : "E:$1";
+
+    std::string error;
+    std::shared_ptr<const Regex> re = Regex::compile(pattern, true, error);
+    if (!re) {
+        fprintf(stderr, "patrón inválido: %s\n", error.c_str());
+        return 1;
+    }
+
+    // Documento sintético tipo log: ~1 coincidencia cada 50 líneas
+    TextBuffer buf;
+    std::string text;
+    size_t lines = 0;
+    for (unsigned i = 0; text.size() < (mib << 20); ++i, ++lines) {
+        text += "2024-01-01 12:00:00 [worker-" + std::to_string(i % 97) +
+                "] request handled in " + std::to_string(i % 1000) + " ms";
+        if (i % 50 == 0) text += " ERROR timeout";
+        text += '\n';
+    }
+    buf.insert(0, text);
+    double gb = text.size() / 1e9;
+    printf("%.2f GB, %zu líneas, patrón \"%s\" → \"%s\", %zu hilos\n",
+           gb, lines, pattern.c_str(), replacement.c_str(),
+           (size_t)ThreadPool::shared().size());
+
+    // std::regex sobre un prefijo
+    {
+        size_t limit = std::min(text.size(), kStdRegexMiB << 20);
+        std::regex sr(pattern);
+        auto t0 = std::chrono::steady_clock::now();
+        size_t count = 0, pos = 0;
+        while (pos < limit) {
+            size_t nl = text.find('\n', pos);
+            std::string line = text.substr(pos, nl - pos);
+            for (auto it = std::sregex_iterator(line.begin(), line.end(), sr);
+                 it != std::sregex_iterator(); ++it)
+                ++count;
+            pos = nl + 1;
+        }
+        double s = seconds(t0);
+        printf("  std::regex (%zu MiB)         : %8.3f s  %6.3f GB/s  %zu coincidencias\n",
+               kStdRegexMiB, s, limit / 1e9 / s, count);
+    }
+    text.clear();
+    text.shrink_to_fit();
+
+    // Todas las coincidencias de una línea candidata como ediciones
+    auto matchLine = [&](RegexMatcher& m, uint64_t start, uint64_t end,
+                         std::vector<TextEdit>& out) {
+        std::string line = buf.substr(start, end - start);
+        std::vector<long> caps;
+        size_t pos = 0;
+        while (pos <= line.size() && m.search(line.data(), line.size(), pos, caps)) {
+            out.push_back({ start + caps[0], (uint64_t)(caps[1] - caps[0]),
+                            re->expand(replacement, line.data(), caps) });
+            pos = caps[1] > caps[0] ? caps[1] : caps[1] + 1;
+        }
+    };
+
+    // Un hilo
+    {
+        RegexMatcher m(re);
+        std::vector<TextEdit> edits;
+        size_t candidates = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        m.scanLines(buf, 0, buf.size(), [&](uint64_t s, uint64_t e) {
+            ++candidates;
+            matchLine(m, s, e, edits);
+            return true;
+        });
+        double s = seconds(t0);
+        printf("  Regex, 1 hilo               : %8.3f s  %6.3f GB/s  %zu coincidencias (%zu líneas candidatas)\n",
+               s, gb / s, edits.size(), candidates);
+    }
+
+    // Pool de hilos + aplicación de las ediciones
+    {
+        ThreadPool& pool = ThreadPool::shared();
+        uint64_t size = buf.size();
+        uint64_t ranges = std::max<uint64_t>(1, std::min<uint64_t>(size >> 20, pool.size() * 8));
+        std::vector<uint64_t> bounds{ 0 };
+        for (uint64_t k = 1; k < ranges; ++k) {
+            uint64_t b = buf.lineStart(buf.lineAt(size * k / ranges));
+            if (b > bounds.back()) bounds.push_back(b);
+        }
+        bounds.push_back(size);
+
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<std::vector<TextEdit>> found(bounds.size() - 1);
+        std::vector<std::future<void>> tasks;
+        for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+            tasks.push_back(pool.submit([&, i] {
+                RegexMatcher m(re);
+                m.scanLines(buf, bounds[i], bounds[i + 1], [&](uint64_t s, uint64_t e) {
+                    matchLine(m, s, e, found[i]);
+                    return true;
+                });
+            }));
+        }
+        for (auto& t : tasks) t.get();
+        double sFind = seconds(t0);
+
+        std::vector<TextEdit> edits;
+        for (auto& f : found)
+            for (auto& e : f) edits.push_back(std::move(e));
+        auto t1 = std::chrono::steady_clock::now();
+        buf.applyEdits(edits);
+        double sApply = seconds(t1);
+        printf("  Regex, pool                 : %8.3f s  %6.3f GB/s  %zu coincidencias\n",
+               sFind, gb / sFind, edits.size());
+        printf("  applyEdits                  : %8.3f s  %zu piezas\n", sApply, buf.pieceCount());
+    }
+    return 0;
+}
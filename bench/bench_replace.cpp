@@ -0,0 +1,101 @@
+// Reemplazar todo durante la carga en segundo plano: se abre un log
+// grande con FileManager::load (queda cargándose en un hilo) y se llama
+// a findReplace(..., replaceAll) enseguida, sin esperar a
+// pollBackgroundLoad. El resultado tiene que ser el reemplazo secuencial
+// sobre el texto completo, por cada camino: en paralelo, secuencial
+// (aguja con salto de línea) y expresión regular.
+// Uso: ./build/bench_replace [MiB]   (por defecto 96 MiB; mínimo el
+//      umbral de carga en segundo plano)
+
+#include "editor.h"
+#include "filemanager.h"
+#include <ncurses.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Reemplazo secuencial de referencia (coincidencias más a la izquierda)
+static std::string replaceSerial(const std::string& text, const std::string& needle,
+                                 const std::string& replacement) {
+    std::string out;
+    out.reserve(text.size());
+    size_t pos = 0, at;
+    while ((at = text.find(needle, pos)) != std::string::npos) {
+        out.append(text, pos, at - pos);
+        out += replacement;
+        pos = at + needle.size();
+    }
+    out.append(text, pos, std::string::npos);
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+    size_t mib = std::max<size_t>(argc > 1 ? (size_t)atoi(argv[1]) : 96,
+                                  FileManager::kLazyThreshold >> 20);
+
+    // Log sintético: ~1 coincidencia cada 50 líneas, también al final
+    std::string text;
+    for (unsigned i = 0; text.size() < (mib << 20); ++i) {
+        text += "2024-01-01 12:00:00 [worker-" + std::to_string(i % 97) +
+                "] request handled in " + std::to_string(i % 1000) + " ms";
+        if (i % 50 == 0) text += " ERROR timeout";
+        text += '\n';
+    }
+    text += "última línea con ERROR\n";
+
+    const char* dir = getenv("TMPDIR");
+    std::string path = std::string(dir && *dir ? dir : "/tmp") + "/bench_replace_" +
+                       std::to_string(getpid()) + ".log";
+    std::ofstream(path, std::ios::binary) << text;
+
+    FILE* devnull = fopen("/dev/null", "w");
+    newterm("xterm", devnull, stdin);
+    Editor ed(1, 0, 40, 120);
+    printf("%zu MiB, reemplazar todo mientras se carga en segundo plano\n", mib);
+
+    struct Case {
+        const char* what;
+        std::string needle, replacement;
+        bool        regex;
+    };
+    const Case cases[] = {
+        { "en paralelo",                "ERROR",           "E",  false },
+        { "secuencial (con salto)",     "timeout\n2024",   "T\n", false },
+        { "expresión regular",          "ERROR",           "E",  true  },
+    };
+    int bad = 0;
+    for (const Case& c : cases) {
+        TextBuffer buf;
+        if (!FileManager::load(path, buf)) {
+            fprintf(stderr, "no se pudo leer %s\n", path.c_str());
+            bad = 1;
+            break;
+        }
+        ed.setBuffer(std::move(buf));
+        bool loading = ed.isLoading();
+
+        auto t0 = std::chrono::steady_clock::now();
+        int count = ed.findReplace(c.needle, c.replacement, true, true, c.regex);
+        double s = seconds(t0);
+
+        std::string expected = replaceSerial(text, c.needle, c.replacement);
+        TextSnapshot snap = ed.buffer().snapshot(true);
+        bool same = !ed.isLoading() && snap.size() == expected.size() &&
+                    snap.substr(0, snap.size()) == expected;
+        if (!same) bad = 1;
+        printf("  %-26s: %8.3f s  %7d reemplazos  %s%s\n", c.what, s, count,
+               loading ? "" : "(ya cargado) ", same ? "coincide" : "NO coincide");
+    }
+
+    endwin();
+    unlink(path.c_str());
+    return bad;
+}
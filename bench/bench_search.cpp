@@ -0,0 +1,77 @@
+// Benchmark de la búsqueda sin distinguir mayúsculas: ruta anterior de
+// Editor::findReplace (copiar y pasar a minúsculas línea y aguja en cada
+// llamada) frente a SearchKernel sobre la tabla de piezas.
+// Uso: ./build/bench_search [MiB] [aguja]   (por defecto 200 MiB, "Error")
+
+#include "searchkernel.h"
+#include "textbuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t mib = argc > 1 ? (size_t)atoi(argv[1]) : 200;
+    std::string needle = argc > 2 ? argv[2] : "Error";
+
+    // Documento sintético tipo log: ~1 coincidencia cada 50 líneas
+    std::vector<std::string> lines;
+    TextBuffer buf;
+    std::string text;
+    size_t total = 0;
+    for (unsigned i = 0; total < (mib << 20); ++i) {
+        std::string line = "2024-01-01 12:00:00 [worker-" + std::to_string(i % 97) +
+                           "] request handled in " + std::to_string(i % 1000) + " ms";
+        if (i % 50 == 0) line += " ERROR timeout";
+        total += line.size() + 1;
+        text += line;
+        text += '\n';
+        lines.push_back(std::move(line));
+    }
+    buf.insert(0, text);
+    text.clear();
+    text.shrink_to_fit();
+    double gb = total / 1e9;
+    printf("%.2f GB, %zu líneas, aguja \"%s\", backend %s\n",
+           gb, lines.size(), needle.c_str(), SearchKernel::backend());
+
+    // Ruta anterior
+    auto strFind = [&](const std::string& haystack, size_t from) -> size_t {
+        std::string h = haystack, n = needle;
+        std::transform(h.begin(), h.end(), h.begin(), ::tolower);
+        std::transform(n.begin(), n.end(), n.begin(), ::tolower);
+        return h.find(n, from);
+    };
+    auto t0 = std::chrono::steady_clock::now();
+    size_t c0 = 0;
+    for (const auto& line : lines) {
+        size_t pos = 0;
+        while ((pos = strFind(line, pos)) != std::string::npos) {
+            ++c0;
+            pos += needle.size();
+        }
+    }
+    double s0 = seconds(t0);
+    printf("  transform + find (anterior): %8.3f s  %6.2f GB/s  %zu coincidencias\n",
+           s0, gb / s0, c0);
+
+    // Núcleo SIMD sobre las piezas
+    SearchKernel kernel(needle, false);
+    t0 = std::chrono::steady_clock::now();
+    size_t c1 = 0;
+    uint64_t pos = 0, at;
+    while ((at = kernel.find(buf, pos, buf.size())) != SearchKernel::npos) {
+        ++c1;
+        pos = at + needle.size();
+    }
+    double s1 = seconds(t0);
+    printf("  SearchKernel               : %8.3f s  %6.2f GB/s  %zu coincidencias\n",
+           s1, gb / s1, c1);
+    return 0;
+}
@@ -0,0 +1,119 @@
+// Benchmark de deshacer: reemplazar todo sobre un documento de N líneas
+// frente a deshacerlo y rehacerlo (literal, sin distinguir mayúsculas y
+// con expresión regular), más el costo del historial al escribir.
+// Uso: ./build/bench_undo [líneas]   (por defecto 1000000)
+//
+// El Editor necesita ncurses: se abre una terminal contra /dev/null.
+
+#include "editor.h"
+#include <ncurses.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static double seconds(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static std::string makeText(int lines) {
+    std::string text;
+    text.reserve((size_t)lines * 48);
+    for (int i = 0; i < lines; ++i) {
+        text += (i % 3 == 0) ? "ERROR" : (i % 3 == 1) ? "error" : "Error";
+        text += " en la línea " + std::to_string(i) + " código " + std::to_string(i % 97) + "\n";
+    }
+    return text;
+}
+
+struct Case {
+    const char* label;
+    const char* needle;
+    const char* replacement;
+    bool        caseSensitive;
+    bool        regex;
+};
+
+int main(int argc, char* argv[]) {
+    int lines = argc > 1 ? atoi(argv[1]) : 1000000;
+
+    setenv("TERM", "xterm", 0);
+    FILE* devnull = fopen("/dev/null", "w");
+    SCREEN* scr = newterm(nullptr, devnull, stdin);
+    if (!scr) {
+        fprintf(stderr, "no se pudo iniciar ncurses\n");
+        return 1;
+    }
+    start_color();
+
+    const std::string original = makeText(lines);
+    const Case cases[] = {
+        { "literal",             "código", "cod",   true,  false },
+        { "sin mayúsculas",      "error",  "AVISO", false, false },
+        { "regex con grupos",    "c\xc3\xb3" "digo ([0-9]+)", "[$1]", true, true },
+    };
+
+    struct Row {
+        std::string label;
+        int    count;
+        double doIt, undo, redo;
+        size_t mem;
+        bool   ok;
+    };
+    std::vector<Row> rows;
+    for (const Case& c : cases) {
+        Editor ed(0, 0, 24, 80);
+        ed.insertText(original);
+        std::string before = ed.getText();
+
+        auto t0 = std::chrono::steady_clock::now();
+        int count = ed.findReplace(c.needle, c.replacement, c.caseSensitive, true, c.regex);
+        double doIt = seconds(t0);
+        std::string after = ed.getText();
+        size_t mem = ed.undoLog().memoryBytes();
+
+        t0 = std::chrono::steady_clock::now();
+        ed.undo();
+        double undo = seconds(t0);
+        bool ok = ed.getText() == before;
+
+        t0 = std::chrono::steady_clock::now();
+        ed.redo();
+        double redo = seconds(t0);
+        ok = ok && ed.getText() == after;
+
+        rows.push_back({ c.label, count, doIt, undo, redo, mem, ok });
+    }
+
+    // Escritura: costo del historial por tecla y pasos resultantes
+    std::vector<int> keys;
+    for (int i = 0; i < 200000; ++i) {
+        keys.push_back("historial de deshacer "[i % 22]);
+        if (i % 50 == 49) keys.push_back('\n');
+        if (i % 13 == 12) keys.push_back(KEY_BACKSPACE);
+    }
+    Editor typing(0, 0, 24, 80);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int k : keys) typing.handleInput(k);
+    double typed = seconds(t0);
+    int steps = 0;
+    t0 = std::chrono::steady_clock::now();
+    while (typing.undo()) ++steps;
+    double undoAll = seconds(t0);
+    bool empty = typing.getText().empty();
+
+    endwin();
+    delscreen(scr);
+    fclose(devnull);
+
+    printf("  %d líneas\n", lines);
+    for (auto& r : rows)
+        printf("  %-18s %7d reempl.: hacer %6.3f s  deshacer %6.3f s  rehacer %6.3f s"
+               "  (%5.1f MiB, %s)\n",
+               r.label.c_str(), r.count, r.doIt, r.undo, r.redo, r.mem / 1048576.0,
+               r.ok ? "ok" : "DISTINTO");
+    printf("  %-18s %7zu teclas: %6.3f s, %d pasos, deshacer todo %6.3f s (%s)\n",
+           "escritura", keys.size(), typed, steps, undoAll, empty ? "ok" : "DISTINTO");
+    return 0;
+}
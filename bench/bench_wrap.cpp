@@ -0,0 +1,106 @@
+// Benchmark del índice de filas visuales (ajuste de línea) sobre un
+// documento con líneas de largo variado: medirlo entero, saltar a una
+// línea / fila visual cualquiera, avanzar página y editar, frente a
+// sumar las filas desde el inicio del documento en cada consulta.
+// Uso: ./build/bench_wrap [MiB]   (por defecto 256 MiB)
+
+#include "wrapindex.h"
+#include "columnmap.h"
+#include "textbuffer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static const int kWidth = 80;
+static const int kRows  = 50;
+static const int kQueries = 100000;
+static const int kEdits   = 1000;
+
+static double millis(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main(int argc, char* argv[]) {
+    size_t mib = argc > 1 ? (size_t)atoi(argv[1]) : 256;
+
+    // Líneas cortas con párrafos largos intercalados
+    std::string text;
+    uint32_t seed = 12345;
+    while (text.size() < (mib << 20)) {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        size_t len = seed % 8 == 0 ? 200 + seed % 600 : seed % 70;
+        text.append(len, 'a');
+        text += '\n';
+    }
+    TextBuffer buf;
+    buf.insert(0, text);
+    int lines = buf.lineCount();
+    printf("%.0f MiB, %d líneas, ancho %d\n", text.size() / 1048576.0, lines, kWidth);
+
+    ColumnMap cols(buf);
+    cols.reset();
+    WrapIndex idx;
+    idx.reset(kWidth);
+    auto t0 = std::chrono::steady_clock::now();
+    idx.measure(cols, lines);
+    printf("  %-34s: %8.1f ms  (%lld filas)\n", "medir todo", millis(t0),
+           (long long)idx.totalRows());
+
+    // Saltar a líneas al azar (Ctrl+G) y a filas visuales al azar
+    t0 = std::chrono::steady_clock::now();
+    int64_t sum = 0;
+    for (int i = 0; i < kQueries; ++i) {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        sum += idx.rowsBefore(seed % lines);
+    }
+    printf("  %-34s: %8.3f us\n", "línea -> fila visual", millis(t0) * 1000 / kQueries);
+
+    t0 = std::chrono::steady_clock::now();
+    int sub;
+    for (int i = 0; i < kQueries; ++i) {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        sum += idx.lineAtRow(seed % idx.totalRows(), sub);
+    }
+    printf("  %-34s: %8.3f us\n", "fila visual -> línea", millis(t0) * 1000 / kQueries);
+
+    // Avanzar página desde el inicio hasta el final
+    t0 = std::chrono::steady_clock::now();
+    int pages = 0;
+    for (int64_t row = 0; row < idx.totalRows(); row += kRows, ++pages)
+        sum += idx.lineAtRow(row, sub);
+    printf("  %-34s: %8.3f us  (%d páginas)\n", "PgDn", millis(t0) * 1000 / pages, pages);
+
+    // Teclear en medio: se vuelve a medir sólo la línea tocada
+    int row = lines / 2;
+    uint64_t at = buf.lineStart(row);
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kEdits; ++i) {
+        buf.insert(at + i, "x");
+        cols.noteEdit(row, i, 0, 1, 0);
+        idx.replaceLines(cols, row, 1, 1);
+    }
+    printf("  %-34s: %8.3f us  (incluye el insert)\n", "teclear en medio (por tecla)", millis(t0) * 1000 / kEdits);
+
+    // Partir y volver a juntar una línea
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kEdits; ++i) {
+        buf.insert(at + 10, "\n");
+        cols.noteEdit(row, 10, 0, 1, 1);
+        idx.replaceLines(cols, row, 1, 2);
+        buf.erase(at + 10, 1);
+        cols.noteEdit(row, 10, 1, 0, -1);
+        idx.replaceLines(cols, row, 2, 1);
+    }
+    printf("  %-34s: %8.3f us\n", "Enter + Retroceso (por par)", millis(t0) * 1000 / kEdits);
+
+    // Referencia: sumar las filas desde el inicio hasta una línea al azar
+    t0 = std::chrono::steady_clock::now();
+    seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+    int target = seed % lines;
+    int64_t acc = 0;
+    for (int l = 0; l < target; ++l) acc += WrapIndex::rowsFor(buf.lineLength(l), kWidth);
+    printf("  %-34s: %8.1f ms  (%s)\n", "desde el inicio, cada consulta", millis(t0),
+           acc == idx.rowsBefore(target) ? "coincide" : "NO coincide");
+    return sum == 42 ? 1 : 0;
+}
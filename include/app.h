@@ -1,11 +1,16 @@
 #pragma once
+#include "bufferlist.h"
 #include "editor.h"
+#include "filemanager.h"
 #include "menubar.h"
 #include "statusbar.h"
 #include "pluginmanager.h"
+#include <chrono>
 #include <string>
 #include <memory>
 
+class CsvTable;
+
 class App {
 public:
     App(int argc, char* argv[]);
@@ -13,15 +18,34 @@ public:
 
     void run();
 
+    // Límite de fotogramas por segundo (0 = sin límite). Las teclas que
+    // llegan entre dos fotogramas se procesan todas antes de pintar.
+    void setMaxFps(int fps) { maxFps_ = fps; }
+
+    // Cuándo se fuerza a disco al guardar (por defecto FsyncPolicy::File)
+    void setFsyncPolicy(FsyncPolicy policy) { fsyncPolicy_ = policy; }
+
+    // Memoria para todos los documentos abiertos (ver BufferList)
+    void setMemoryBudget(size_t bytes) { buffers_.setBudget(bytes); }
+
     // Acciones invocadas desde menús o plugins
     void actionNew();
     void actionOpen();
     void actionSave();
     void actionSaveAs();
     void actionSaveFormat();   // elegir formato al guardar
-    void actionFind();
-    void actionFindReplace();
+    void actionClose();         // cerrar el documento activo
+    void actionNextBuffer();
+    void actionPrevBuffer();
+    void actionBuffers();       // lista de documentos abiertos
+    void actionUndo();
+    void actionRedo();
+    void actionFind();          // búsqueda incremental
+    void actionFindReplace(const std::string& needle = "");
     void actionGotoLine();
+    void actionTable();         // vista de tabla (CSV)
+    void actionWrap();          // ajuste de línea sí / no
+    void actionPaste();         // tras ESC[200~: lee y pega de una vez
     void actionAbout();
     void actionQuit();
 
@@ -33,12 +57,48 @@ private:
     std::unique_ptr<StatusBar>     statusbar_;
     PluginManager                  pluginMgr_;
 
+    // Documentos abiertos; el activo es el del editor
+    BufferList  buffers_;
     std::string currentFile_;
     std::string currentFormat_; // "txt", "md", "html", "csv"
     bool        running_;
 
+    int                                   maxFps_;
+    std::chrono::steady_clock::time_point lastFrame_;
+
+    // Guardado en segundo plano
+    FsyncPolicy                 fsyncPolicy_;
+    std::unique_ptr<SaveWorker> saving_;
+    std::string                 savingMsg_;      // "Guardado: ", "Exportado como: "...
+    bool                        savingNotify_;   // avisar a los plugins al terminar
+    bool                        savingJournal_;  // al terminar, el diario cambia de base
+    bool                        savingRaw_;      // TXT/MD: el archivo es el documento
+    uint64_t                    savingMark_;     // posición del diario en la instantánea
+
+    // Índice de la última vista de tabla: se reutiliza si el documento
+    // no cambió desde entonces
+    std::unique_ptr<CsvTable>   table_;
+
     void buildMenus();
     void buildPluginMenu();
     void handleResize();
+    // Abre `path` en un documento nuevo (o pasa al suyo si ya está
+    // abierto), aplicando antes lo que haya en su diario
+    bool openPath(const std::string& path);
+    // Pone en el editor el documento `i` de buffers_. `recovered`
+    // recibe las ediciones recuperadas del diario.
+    bool switchTo(size_t i, size_t& recovered);
+    void switchAndReport(size_t i);
+    void closeActive();    // sin preguntar; siempre queda un documento
+    void pollLoading();    // incorpora la carga en segundo plano
+    void pollSave();       // informa el fin de un guardado
+    void startSave(const std::string& path, FileFormat fmt,
+                   const std::string& doneMsg, bool notify);
+    void renderFrame();    // pinta todo con un único doupdate()
+    void handleKey(int ch);
+    void drawStatusBar();
+    bool blankDocument() const;   // sin título, vacío y sin tocar
     bool confirmUnsaved(); // pregunta si hay cambios sin guardar
+    void cancelLoading();  // ESC mientras se carga un archivo grande
+    bool waitForLoad(const std::string& what);   // false si se cancela
 };
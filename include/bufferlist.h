@@ -0,0 +1,123 @@
+#pragma once
+#include "editor.h"
+#include "mappedfile.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// ─── Documentos abiertos ──────────────────────────────────────────
+// Varios documentos en un único Editor: el activo vive en el editor y
+// los demás quedan estacionados aquí (Editor::Parked) con su ruta,
+// formato y posición. Entre todos, con sus historiales de deshacer,
+// ocupan como mucho `budget` bytes: al pasarse se desalojan los
+// inactivos usados hace más tiempo, primero los que no tienen cambios.
+// Un documento desalojado queda reducido a:
+//   - su archivo mapeado, sin páginas residentes, si es idéntico a él;
+//   - su ruta, si no tiene cambios pero no es el mapeo (ya guardado,
+//     transcodificado) y el archivo sigue siendo el que se leyó o se
+//     guardó tal cual (mismo dispositivo, inodo, tamaño y mtime): se
+//     vuelve a leer del disco, con su historial y su diario;
+//   - un temporal compacto en otro caso (con cambios, exportado a
+//     HTML/CSV, tocado por otro programa...). Sobre un original mapeado
+//     sólo se vuelcan las ediciones (offset, bytes quitados y texto
+//     puesto, como en el diario); si no, el texto entero, que pasa a
+//     ser su original. El temporal se borra en cuanto se mapea: nunca
+//     queda nada en disco.
+// Activarlo lo reconstruye desde esa forma. Los que aún se están
+// cargando en segundo plano no se desalojan.
+class BufferList {
+public:
+    static const size_t kDefaultBudget = 1u << 30;
+
+    BufferList();
+
+    void   setBudget(size_t bytes) { budget_ = bytes; }
+    size_t budget() const          { return budget_; }
+
+    size_t count() const  { return docs_.size(); }
+    size_t active() const { return active_; }
+
+    const std::string& path(size_t i) const   { return docs_[i].path; }
+    const std::string& format(size_t i) const { return docs_[i].format; }
+    // Inactivo con cambios sin guardar (el activo lo sabe el editor)
+    bool dirty(size_t i) const { return docs_[i].state.dirty; }
+    bool resident(size_t i) const { return docs_[i].form == Form::Resident; }
+    // Índice del documento de `path` (SIZE_MAX si no está abierto)
+    size_t find(const std::string& path) const;
+
+    // Agrega un documento que se lee de `path` al activarlo (aplicando
+    // lo que haya en su diario); sin ruta, uno vacío. Devuelve su índice.
+    size_t add(const std::string& path, const std::string& format);
+    // Ruta y formato del documento activo (tras "Guardar como"...)
+    void describe(const std::string& path, const std::string& format);
+    // El activo se guardó en `path`: si fue tal cual (ver
+    // ExporterRegistry::isRaw) ese archivo vuelve a ser el documento y
+    // puede releerse al desalojarlo; si fue una exportación, no.
+    void noteSaved(const std::string& path, bool raw);
+    // Quita un documento inactivo (su diario queda como esté)
+    void remove(size_t i);
+    // Al salir descartando los cambios: borra los diarios de los
+    // inactivos que se llegaron a leer (los demás conservan lo que haya
+    // para recuperar)
+    void discardJournals();
+
+    // Pone en el editor el documento `i`: el activo se estaciona (con su
+    // diario cerrado sin borrar) y `i` se reconstruye si estaba
+    // desalojado, con las `rows` filas desde su vista ya indexadas.
+    // `recovered` recibe las ediciones aplicadas desde el diario. false
+    // si no se pudo leer su archivo: queda activo y vacío.
+    bool activate(size_t i, Editor& ed, int rows, size_t& recovered);
+    // El último activate volvió a leer un archivo que otro programa
+    // cambió desde que se desalojó: es el nuevo contenido, sin historial
+    bool changedOnDisk() const { return changed_; }
+
+    // Memoria de todos los documentos (la del activo, según el editor)
+    size_t memoryBytes(const Editor& ed) const;
+    // Desaloja inactivos hasta entrar en el presupuesto. Devuelve cuántos.
+    size_t trim(const Editor& ed);
+
+private:
+    enum class Form {
+        Resident,   // state.buf es el documento (o es el activo)
+        Mapped,     // `file` es el documento tal cual (nullptr: vacío)
+        Patched,    // `file` con las ediciones de `edits` encima
+        Reload      // se vuelve a leer de `path`
+    };
+
+    // Archivo en disco tal como estaba cuando su contenido era el documento
+    struct DiskId {
+        bool     valid = false;
+        dev_t    dev = 0;
+        ino_t    ino = 0;
+        uint64_t size = 0;
+        int64_t  mtimeNs = 0;
+    };
+
+    struct Document {
+        std::string    path;             // vacío: sin título
+        std::string    format = "txt";
+        bool           journaled = false;  // con diario (se reabre al activarlo)
+        Editor::Parked state;            // buf vacío si es el activo o está desalojado
+        Form           form = Form::Resident;
+        DiskId         disk;             // al leerlo o guardarlo tal cual
+        std::shared_ptr<const MappedFile> file;
+        std::shared_ptr<const MappedFile> edits;
+        uint64_t       lastUse = 0;
+    };
+
+    std::vector<Document> docs_;
+    size_t   active_;
+    size_t   budget_;
+    uint64_t clock_;     // para lastUse
+    bool     changed_;   // ver changedOnDisk
+
+    static DiskId diskId(const std::string& path);
+    static bool   sameFile(const DiskId& a, const DiskId& b);
+
+    size_t docBytes(const Document& d) const;
+    bool   evict(Document& d);
+    bool   rebuild(Document& d, int rows, size_t& recovered);
+};
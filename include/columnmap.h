@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <vector>
+
+class TextBuffer;
+
+// ─── Columnas de pantalla (UTF-8) ─────────────────────────────────
+// El cursor y las ediciones trabajan en bytes; la pantalla, en
+// columnas. Un carácter ocupa lo que dice wcwidth (0 un combinante, 2
+// uno ancho), un tabulador kTabWidth y un carácter de control 2 (^X).
+// Un byte que no forma UTF-8 válido se muestra como U+FFFD.
+//
+// Por línea se guardan puntos de control (byte, columna) cada kStride
+// bytes, así que pasar de byte a columna y al revés decodifica a lo
+// sumo un tramo, aun en una línea de 50 MB. Las líneas de ASCII
+// imprimible (lo común) no decodifican nada: columna == byte. Editar
+// dentro de una línea larga vuelve a decodificar sólo el tramo tocado
+// y corre los puntos que siguen.
+class ColumnMap {
+public:
+    static const int      kTabWidth = 4;
+    static const uint64_t kStride   = 1024;   // bytes entre puntos de control
+
+    explicit ColumnMap(const TextBuffer& buf);
+
+    const TextBuffer& buffer() const { return buf_; }
+
+    // Carácter que empieza en p (n > 0) y sus bytes en `len`; un byte
+    // suelto o una secuencia inválida es U+FFFD de un byte
+    static uint32_t decode(const char* p, size_t n, int& len);
+    // Columnas que ocupa (tabla de wcwidth armada una vez)
+    static int  charWidth(uint32_t cp);
+    // Se pinta tal cual (si no: ^X, espacios o U+FFFD)
+    static bool printable(uint32_t cp);
+    // Columnas de un tramo de caracteres completos
+    static uint64_t columns(const char* p, size_t n);
+    // Sólo ASCII imprimible
+    static bool plain(const char* p, size_t n);
+
+    void reset();                              // el documento cambió entero
+    // En la línea `row`, desde el byte `col`, `removed` bytes pasaron a
+    // ser `added`; la edición agregó `lineDelta` líneas (o quitó)
+    void noteEdit(int row, uint64_t col, uint64_t removed, uint64_t added, int lineDelta);
+
+    uint64_t width(int row);                    // columnas de la línea
+    uint64_t columnAt(int row, uint64_t byte);  // columna del carácter que contiene el byte
+    // Inicio del carácter visible en la columna (o fin de línea)
+    uint64_t byteAt(int row, uint64_t column);
+    // Posiciones vecinas del cursor; los combinantes van con su base
+    uint64_t nextChar(int row, uint64_t byte);
+    uint64_t prevChar(int row, uint64_t byte);
+
+private:
+    struct Mark {
+        uint64_t byte;
+        uint64_t col;
+    };
+
+    struct Line {
+        uint64_t          bytes = 0;
+        uint64_t          cols  = 0;
+        bool              plain = true;   // sin puntos: columna == byte
+        std::vector<Mark> marks;          // marks[0] = {0, 0}
+    };
+
+    // Líneas cacheadas; las que no son sólo ASCII guardan sus puntos
+    static const size_t kMaxLines = 4096;
+
+    const TextBuffer&    buf_;
+    std::map<int, Line>  lines_;
+    int                  lineCount_;   // líneas del documento que conocemos
+
+    // Recorre los caracteres desde `from` hasta el fin de la línea:
+    // fn(byte, columna, bytes, columnas); se detiene si devuelve false
+    using CharFn = std::function<bool(uint64_t, uint64_t, int, int)>;
+
+    void        sync();
+    const Line& line(int row);
+    void        build(int row, Line& ln);
+    Mark        scan(uint64_t start, Mark from, uint64_t to, std::vector<Mark>& marks) const;
+    void        walk(int row, const Line& ln, Mark from, const CharFn& fn) const;
+    static size_t markBefore(const Line& ln, uint64_t byte);
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include "textsnapshot.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// ─── Índice de columnas de un CSV ─────────────────────────────────
+// Se recorre la instantánea una vez, de a 64 bytes con SIMD: comillas,
+// delimitadores y '\n' salen como máscaras de bits y las comillas
+// abiertas se resuelven con un xor prefijo (un '"' alterna dentro /
+// fuera, así que "" dentro de un campo se compensa solo). Se guarda
+// sólo el inicio de cada fila: los campos se ubican al pedirlos,
+// recorriendo esa fila.
+//
+// Ordenar y filtrar trabajan sobre una vista (permutación de filas)
+// comparando los bytes de la instantánea en su lugar; sólo se copian
+// los campos partidos entre piezas o con comillas escapadas. La fila 0
+// es la cabecera y queda fuera de la vista.
+class CsvTable {
+public:
+    // Ancho máximo de una columna al mostrarla (celdas de pantalla)
+    static const int kMaxColumnWidth = 32;
+
+    struct Field {
+        uint64_t offset;   // contenido, sin las comillas que lo envuelven
+        uint64_t length;
+        bool     escaped;  // tiene "" que al mostrarlo es "
+    };
+
+    CsvTable() = default;
+
+    // Delimitador más probable (',' ';' '\t' '|') según la primera fila
+    static char detectDelimiter(const TextSnapshot& snap);
+
+    // Indexa la instantánea entera; apto para cualquier hilo. `scanned`
+    // avanza con los bytes recorridos. false si se canceló.
+    bool build(const TextSnapshot& snap, char delimiter,
+               std::atomic<uint64_t>* scanned = nullptr,
+               const std::atomic<bool>* cancel = nullptr);
+
+    const TextSnapshot& snapshot() const { return snap_; }
+    char   delimiter() const   { return delim_; }
+    size_t rowCount() const    { return rows_.size(); }   // con la cabecera
+    size_t columnCount() const { return columns_; }
+    uint64_t rowOffset(size_t row) const { return rows_[row]; }
+
+    // Campos de una fila (sin '\r\n' final). field() es false si la
+    // fila tiene menos columnas.
+    void fields(size_t row, std::vector<Field>& out) const;
+    bool field(size_t row, size_t col, Field& out) const;
+    // Texto de un campo para mostrar: "" pasa a ser " y los saltos de
+    // línea, espacios. Como mucho `maxBytes` bytes.
+    std::string text(const Field& f, size_t maxBytes = SIZE_MAX) const;
+
+    // Ancho de cada columna según la cabecera y las primeras filas
+    const std::vector<int>& widths() const { return widths_; }
+
+    // ── Vista ──
+    size_t viewCount() const { return view_.empty() && !filtered_ ? dataRows() : view_.size(); }
+    size_t viewRow(size_t i) const { return view_.empty() && !filtered_ ? i + 1 : view_[i]; }
+
+    // Orden estable de la vista actual por una columna: los números
+    // (enteros o decimales) van antes que el texto y entre sí por valor
+    void sortBy(size_t col, bool descending);
+    // Deja en la vista sólo las filas cuyo campo contiene `needle`
+    // (sin distinguir mayúsculas salvo que `needle` las tenga)
+    void filterBy(size_t col, const std::string& needle);
+    void resetView();
+
+private:
+    TextSnapshot          snap_;
+    char                  delim_   = ',';
+    size_t                columns_ = 0;
+    std::vector<uint64_t> rows_;      // inicio de cada fila
+    std::vector<int>      widths_;
+    std::vector<uint32_t> view_;      // filas de la vista (vacía: todas en orden)
+    bool                  filtered_ = false;
+
+    size_t   dataRows() const { return rows_.empty() ? 0 : rows_.size() - 1; }
+    uint64_t rowEnd(size_t row) const;
+    void     forEachInView(const std::function<void(size_t, size_t, uint32_t)>& fn) const;
+    void     computeWidths();
+};
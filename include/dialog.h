@@ -26,6 +26,7 @@ struct FindReplaceParams {
     std::string replacement;
     bool caseSensitive = false;
     bool replaceAll    = false;
+    bool regex         = false;   // needle es una expresión regular
 };
 bool dialogFindReplace(FindReplaceParams& params);
 
@@ -1,27 +1,89 @@
 #pragma once
+#include "columnmap.h"
+#include "highlighter.h"
+#include "journal.h"
+#include "textbuffer.h"
+#include "trigramindex.h"
+#include "undolog.h"
+#include "wrapindex.h"
 #include <ncurses.h>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+class Regex;
+
 class Editor {
 public:
     Editor(int y, int x, int height, int width);
     ~Editor();
 
-    void draw();
+    void draw();          // sólo wnoutrefresh: se muestra con doupdate()
+    void placeCursor();   // cursor físico en el editor, tras pintar lo demás
     void handleInput(int ch);
 
-    // Texto completo como vector de líneas
-    std::vector<std::string>& getLines() { return lines_; }
-    const std::vector<std::string>& getLines() const { return lines_; }
-
-    // Carga nuevo contenido (reemplaza todo)
-    void setLines(const std::vector<std::string>& lines);
+    // Acceso al documento (tabla de piezas)
+    const TextBuffer& buffer() const { return buf_; }
+    std::string line(int row) const { return buf_.line(row); }
+
+    // Líneas completas disponibles. Con carga perezosa la última línea
+    // del buffer está a medio recorrer y no se expone.
+    int  lineCount() const {
+        return buf_.fullyLoaded() ? buf_.lineCount() : buf_.lineCount() - 1;
+    }
+    bool isFullyLoaded() const { return buf_.fullyLoaded(); }
+
+    // Carga en segundo plano (ver TextBuffer::startBackgroundLoad)
+    bool   isLoading() const    { return buf_.backgroundLoading(); }
+    double loadProgress() const { return buf_.loadProgress(); }
+    bool   pollLoad();
+    void   cancelLoad()         { buf_.cancelBackgroundLoad(); }
+    void   loadAll()            { if (!isLoading()) buf_.loadAll(); }
+
+    // Carga nuevo contenido (reemplaza todo, sin copiar)
+    void setBuffer(TextBuffer&& buf);
     void clear();
 
-    // Posición del cursor (lógica, basada en documento)
+    // Lo propio de un documento, fuera del editor (ver BufferList):
+    // park() se lo lleva y deja el editor vacío; unpark() lo vuelve a
+    // poner. El índice de trigramas viaja con el documento (rehacerlo
+    // en cada cambio costaría recorrerlo entero); resaltado, columnas y
+    // ajuste se rehacen. El diario lo maneja quien llama.
+    struct Parked {
+        TextBuffer buf;
+        UndoLog    undo;
+        std::unique_ptr<TrigramIndex> index;   // nullptr: sin índice
+        int  curRow = 0, curCol = 0;
+        int  viewRow = 0, viewCol = 0, viewSub = 0;
+        bool dirty = false;
+    };
+    void park(Parked& out);
+    void unpark(Parked&& in);
+
+    // Posición del cursor (lógica, basada en documento; la columna en
+    // bytes) y su columna de pantalla
     int cursorRow() const { return curRow_; }
     int cursorCol() const { return curCol_; }
+    int cursorColumn() { return (int)cols_.columnAt(curRow_, curCol_); }
+    uint64_t cursorOffset() const { return offsetOf(curRow_, curCol_); }
+    void     setCursorOffset(uint64_t offset);
+
+    // Parte del documento en pantalla: [from, to)
+    void visibleRange(uint64_t& from, uint64_t& to) const;
+
+    // Resalta `length` bytes desde cada offset (ordenados) al dibujar.
+    // El vector debe seguir vivo y sin cambios hasta llamar con otro o
+    // con nullptr (sólo se repinta si cambia el puntero o la longitud).
+    void setHighlights(const std::vector<uint64_t>* offsets, uint64_t length);
+
+    // Resaltado de sintaxis según el formato ("md", "html", "csv"; sin
+    // gramática registrada, ninguno). Si el estado de las filas en
+    // pantalla quedó provisorio, pollHighlight() lo va completando
+    // entre fotogramas (true si hay que volver a pintar).
+    void setSyntax(const std::string& format);
+    bool highlightPending() const { return hlPending_; }
+    bool pollHighlight();
 
     // Indica si hubo cambios desde el último guardado
     bool isDirty() const { return dirty_; }
@@ -30,44 +92,156 @@ public:
     // Redimensionar ventana (para resize de terminal)
     void resize(int y, int x, int height, int width);
 
-    // Insertar texto programáticamente (para plugins)
+    // Ajuste de línea: las líneas largas siguen en las filas de abajo
+    // en lugar de desplazar la vista hacia la derecha
+    void setWrap(bool on);
+    bool wrap() const { return wrap_; }
+
+    // Insertar texto programáticamente (para plugins): un único insert
+    // en el cursor, que queda al final. Cada '\n' pasa a ser el fin de
+    // línea del documento.
     void insertText(const std::string& text);
 
+    // Pegado del terminal: como insertText, aceptando también \r y \r\n
+    void pasteText(const std::string& text);
+
     // Obtener texto completo como string
     std::string getText() const;
 
     // Buscar y reemplazar
-    // Devuelve número de reemplazos realizados
+    // Devuelve número de reemplazos realizados, o -1 si `regex` y el
+    // patrón no es válido o no se pudo reemplazar todo (motivo en
+    // lastError()). Con `regex` el
+    // reemplazo admite $1..$9 / ${n}. Reemplazar todo se reparte en el
+    // pool de hilos e informa avance (0..1) por `progress`; durante una
+    // carga en segundo plano espera a que termine (un solo reemplazo
+    // busca en lo ya cargado).
     int findReplace(const std::string& needle,
                     const std::string& replacement,
                     bool caseSensitive,
-                    bool replaceAll);
+                    bool replaceAll,
+                    bool regex = false,
+                    const std::function<void(double)>& progress = nullptr);
+    const std::string& lastError() const { return lastError_; }
+
+    // Rangos del documento que pueden contener `needle` según el índice
+    // de trigramas (documentos grandes, construido tras la carga). false
+    // si el índice no está listo o no sirve: hay que recorrer todo.
+    bool searchRanges(const std::string& needle, TrigramIndex::Ranges& out);
 
     // Ir a línea específica
     void gotoLine(int line);
 
+    // Deshacer / rehacer (false si no había nada). El historial ocupa
+    // como mucho `bytes` (ver UndoLog).
+    bool undo();
+    bool redo();
+    void setUndoBudget(size_t bytes) { undo_.setBudget(bytes); }
+    const UndoLog& undoLog() const   { return undo_; }
+    // Documento, historial e índice de búsqueda
+    size_t memoryBytes() const;
+
+    // Diario de ediciones: toda edición del documento se registra en él
+    // mientras esté abierto (lo abre y cierra la App según el archivo)
+    Journal& journal() { return journal_; }
+
 private:
     WINDOW* win_;
     int winY_, winX_, height_, width_;
 
-    std::vector<std::string> lines_;
-    int curRow_, curCol_;   // posición lógica en el documento
-    int viewRow_, viewCol_; // desplazamiento del viewport
+    TextBuffer buf_;
+    int curRow_, curCol_;   // posición lógica en el documento (columna en bytes)
+    int viewRow_, viewCol_; // desplazamiento del viewport (columna de pantalla)
+    int viewSub_;           // con ajuste: fila de viewRow_ que queda arriba
 
     bool dirty_;
+    std::string lastError_;
+
+    const std::vector<uint64_t>* hits_;   // resaltado de búsqueda
+    uint64_t                     hitLen_;
+
+    std::unique_ptr<TrigramIndex> index_;   // se lo lleva park()
+    Journal      journal_;
+    UndoLog      undo_;
+
+    // ── Sintaxis ──
+    Highlighter           hl_;
+    bool                  hlPending_;
+    std::vector<uint32_t> lineStates_;    // estado con que empieza cada línea visible
+    std::vector<uint32_t> drawnStates_;   // el de la línea de cada fila al pintarla
+    std::vector<Token>    tokens_;
+
+    // ── Columnas de pantalla (UTF-8) ──
+    ColumnMap cols_;
+
+    // ── Ajuste de línea ──
+    bool      wrap_;
+    WrapIndex layout_;                    // filas de cada línea (se mide a demanda)
+    std::vector<int> rowLine_, rowSub_;   // línea (-1: ninguna) y fila suya en cada fila de la ventana
+
+    void    measureLayout(int upTo);      // el índice cubre las líneas [0, upTo)
+    int64_t visualRow(int line, int sub); // fila visual absoluta
+    void    lineAtVisual(int64_t row, int& line, int& sub);
+    void    layoutRows(int total);        // rowLine_ / rowSub_ desde la vista
+    // Las líneas [row, row + oldLines) pasaron a ser [row, row + newLines)
+    void    noteLayoutEdit(int row, int oldLines, int newLines);
+
+    // ── Daño por fila ──
+    // Filas de la ventana que draw() debe reconstruir, relativas a lo
+    // pintado en el último draw() (drawnViewRow_). El resto se deja tal
+    // cual en la ventana.
+    std::vector<char> damaged_;
+    int  drawnViewRow_, drawnViewCol_, drawnViewSub_, drawnCurRow_, drawnLines_;
+    bool drawnWrap_;
+
+    void damageRow(int docRow);    // cambió el contenido de una línea
+    void damageFrom(int docRow);   // cambió esa línea y se movieron las siguientes
+    void damageAll();
+
+    // Toda edición del documento pasa por aquí para mantener el índice,
+    // el diario y el historial de deshacer
+    void insertAt(uint64_t offset, const std::string& text);
+    void eraseAt(uint64_t offset, uint64_t length);
+    // Ediciones en bloque (reemplazar todo y su deshacer): reconstruyen
+    // el árbol de una vez; el paso de deshacer lo registra quien llama
+    void bulkReplace(const std::vector<uint64_t>& offsets, uint64_t len,
+                     const std::string& text);
+    void bulkEdits(const std::vector<TextEdit>& edits);
+    void applyStep(const UndoLog::Step& step, bool undo);
+    // Construye (o reconstruye si hay bloques sucios) el índice
+    void maintainIndex();
 
     // Helpers
     void moveCursorUp();
     void moveCursorDown();
     void moveCursorLeft();
     void moveCursorRight();
+    void moveCursorVisual(int64_t delta);   // con ajuste: filas visuales
+    void moveToRow(int row);                // otra línea, misma columna de pantalla
     void insertChar(int ch);
     void deleteCharBack();  // Backspace
     void deleteCharFwd();   // Delete
     void insertNewline();
     void scrollToCursor();
-    void clampCursor();
-
-    // Dibuja una línea del documento en la fila visual dada
-    void drawLine(int visualRow, int docRow);
+    int  replaceAllParallel(const std::string& needle,
+                            const std::string& replacement,
+                            bool caseSensitive,
+                            const std::function<void(double)>& progress);
+    int  regexReplace(const std::shared_ptr<const Regex>& re,
+                      const std::string& replacement,
+                      bool replaceAll,
+                      const std::function<void(double)>& progress);
+
+    // Rangos de líneas completas para repartir en el pool, y su ejecución
+    std::vector<uint64_t> lineRanges() const;
+    void runRanges(size_t n, const std::function<void(size_t)>& task,
+                   const std::function<void(double)>& progress) const;
+
+    // Longitud (en bytes) de una línea y offset absoluto de (fila, col)
+    int      lineLen(int row) const { return (int)buf_.lineLength(row); }
+    uint64_t offsetOf(int row, int col) const { return buf_.lineStart(row) + col; }
+
+    // Dibuja una línea del documento (con ajuste, su fila `sub`) en la
+    // fila de la ventana dada
+    void drawLine(int visualRow, int docRow, int sub);
 };
@@ -0,0 +1,90 @@
+#pragma once
+#include "filemanager.h"
+#include "textsnapshot.h"
+#include "transcoder.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <sys/uio.h>
+#include <vector>
+
+// ─── Salida de un exportador ──────────────────────────────────────
+// Junta la salida en un buffer grande y la vuelca con writev. Los
+// tramos largos del documento se pueden pasar por referencia (sin
+// copiarlos) intercalados con texto generado: el orden se respeta.
+// Con una codificación que no es UTF-8 todo pasa por Transcoder camino
+// al buffer (con su BOM al comienzo, si lo lleva).
+class ExportSink {
+public:
+    explicit ExportSink(int fd, TextEncoding encoding = TextEncoding());
+
+    ExportSink(const ExportSink&) = delete;
+    ExportSink& operator=(const ExportSink&) = delete;
+
+    // Copia al buffer (etiquetas, escapes, tramos cortos)
+    bool put(const char* p, size_t n);
+    bool put(const std::string& s) { return put(s.data(), s.size()); }
+    bool put(char c)               { return put(&c, 1); }
+
+    // Tramo que sigue vivo hasta finish() (p. ej. de una instantánea):
+    // si es largo se escribe desde donde está
+    bool putRef(const char* p, size_t n);
+
+    // Vuelca todo lo pendiente
+    bool finish();
+
+private:
+    int                     fd_;
+    std::unique_ptr<char[]> buf_;
+    size_t                  used_;    // bytes ocupados del buffer
+    size_t                  mark_;    // [mark_, used_) aún no está en iov_
+    std::vector<iovec>      iov_;
+    size_t                  pending_; // bytes en iov_
+    TextEncoding            enc_;
+    char                    carry_[4]; // carácter partido entre dos put
+    int                     carryLen_;
+
+    void seal();
+    bool flush();
+    bool encode(const char* p, size_t n, bool last);
+};
+
+// ─── Exportador de un formato ─────────────────────────────────────
+// Recorre la instantánea completa y escribe el formato en `out`.
+// `written` (si no es nullptr) avanza con los bytes del documento ya
+// procesados. Corre en el hilo de guardado.
+class Exporter {
+public:
+    virtual ~Exporter() = default;
+    virtual bool write(const TextSnapshot& snap, ExportSink& out,
+                       std::atomic<uint64_t>* written) = 0;
+};
+
+// ─── Registro de formatos ─────────────────────────────────────────
+// FileManager guarda con el exportador registrado para cada FileFormat
+// y deduce el formato por extensión a partir de aquí; la App arma con
+// él el menú de formatos. TXT, MD, HTML y CSV vienen registrados. Un
+// formato nuevo se agrega con add() al iniciar, antes de guardar.
+struct ExportFormat {
+    FileFormat               format;
+    std::string              name;          // "html"
+    std::string              description;   // para el menú de formatos
+    std::vector<std::string> extensions;    // en minúsculas, sin punto; la primera se sugiere
+    bool                     raw;           // el archivo es el documento tal cual
+    std::function<std::unique_ptr<Exporter>()> create;
+};
+
+class ExporterRegistry {
+public:
+    // Agrega o reemplaza el formato de mismo FileFormat
+    static void add(ExportFormat fmt);
+
+    static const std::vector<ExportFormat>& formats();
+    static const ExportFormat* find(FileFormat fmt);
+    static const ExportFormat* byExtension(const std::string& ext);
+
+    static std::unique_ptr<Exporter> create(FileFormat fmt);
+    static bool isRaw(FileFormat fmt);
+};
@@ -1,7 +1,14 @@
 #pragma once
+#include "textbuffer.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
+class SaveWorker;
+
+// Cada formato tiene su exportador en ExporterRegistry (exporter.h)
 enum class FileFormat {
     TXT,
     MD,
@@ -9,16 +16,64 @@ enum class FileFormat {
     CSV
 };
 
+enum class LoadMode {
+    Auto,   // a partir de kLazyThreshold bytes, perezosa + segundo plano
+    Full,   // indexar todo el archivo al abrir
+    Lazy    // indexar sólo lo que se va mostrando
+};
+
+// Cuándo se fuerza a disco lo guardado. El rename siempre es atómico:
+// un corte a mitad de escritura nunca deja el original truncado. (El
+// parche en el lugar no pasa por rename: ver writeSnapshot.)
+enum class FsyncPolicy {
+    None,        // sin fsync (más rápido; ante un corte de luz puede perderse)
+    File,        // fsync del temporal antes del rename
+    FileAndDir   // además fsync del directorio tras el rename
+};
+
 class FileManager {
 public:
-    // Lee el archivo y devuelve sus líneas
-    static bool load(const std::string& path, std::vector<std::string>& lines);
+    // Tamaño a partir del cual LoadMode::Auto carga en segundo plano
+    static const size_t kLazyThreshold = 64u << 20;
+    // Tamaño a partir del cual se intenta parchear en el lugar al guardar
+    static const size_t kInPlaceThreshold = 64u << 20;
+
+    // Mapea el archivo en memoria y construye la tabla de piezas. Si no
+    // está en UTF-8 (BOM, UTF-16, Latin-1: ver Transcoder) se pasa a
+    // UTF-8 al cargar; encoding() del original recuerda cuál era.
+    static bool load(const std::string& path, TextBuffer& buf,
+                     LoadMode mode = LoadMode::Auto);
 
-    // Guarda las líneas en disco según el formato elegido
+    // Guarda el documento en disco según el formato elegido (bloquea).
+    // Texto plano vuelve a la codificación con que se cargó.
     static bool save(const std::string& path,
-                     const std::vector<std::string>& lines,
+                     const TextBuffer& buf,
                      FileFormat fmt = FileFormat::TXT);
 
+    // Igual, en un hilo sobre una instantánea (ver SaveWorker)
+    static std::unique_ptr<SaveWorker> saveAsync(const std::string& path,
+                                                 const TextBuffer& buf,
+                                                 FileFormat fmt = FileFormat::TXT,
+                                                 FsyncPolicy policy = FsyncPolicy::File);
+
+    // Escribe una instantánea en un temporal del mismo directorio con
+    // escrituras vectoriales (writev) grandes, aplica `policy` y lo
+    // renombra sobre `path`. Apta para cualquier hilo. `written` avanza
+    // con los bytes del documento procesados; `error` recibe el motivo.
+    //
+    // Texto plano de kInPlaceThreshold bytes o más sobre el mismo
+    // archivo que se mapeó, sin cambios ajenos en disco: si desde la
+    // carga sólo hubo reemplazos del mismo tamaño o texto agregado al
+    // final, se escriben únicamente esos tramos con pwrite. No es
+    // atómico (un corte puede dejar el parche a medias, nunca el archivo
+    // truncado); si falla se reescribe entero por el camino normal.
+    static bool writeSnapshot(const std::string& path,
+                              const TextSnapshot& snap,
+                              FileFormat fmt,
+                              FsyncPolicy policy,
+                              std::atomic<uint64_t>* written = nullptr,
+                              std::string* error = nullptr);
+
     // Inferir formato según extensión del path
     static FileFormat detectFormat(const std::string& path);
 
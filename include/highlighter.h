@@ -0,0 +1,125 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TextBuffer;
+
+// ─── Tramo resaltado de una línea ─────────────────────────────────
+enum class TokenStyle : uint8_t {
+    Normal,
+    Heading,     // títulos de Markdown
+    Emphasis,    // *énfasis*, **negrita**
+    Code,        // `código` y bloques cercados
+    Link,        // [texto](url)
+    Tag,         // <etiqueta> y marcas de lista / cita
+    Attribute,   // atributos de una etiqueta
+    String,      // valores entre comillas
+    Comment,     // <!-- ... -->
+    Punctuation, // delimitadores, entidades
+    Alternate    // columnas impares de un CSV
+};
+
+struct Token {
+    uint32_t   start;    // byte dentro de la línea
+    uint32_t   length;
+    TokenStyle style;
+};
+
+// ─── Gramática de un formato ──────────────────────────────────────
+// Tokeniza una línea (sin el '\n') partiendo del estado con que empieza
+// y devuelve el estado con que empieza la siguiente. El estado 0 es el
+// del inicio del documento. Con `out` == nullptr sólo interesa el
+// estado. Los tokens quedan ordenados y sin solaparse; lo que no cubren
+// es Normal. Debe ser una función pura: el mismo texto y estado, el
+// mismo resultado.
+class Grammar {
+public:
+    virtual ~Grammar() = default;
+    virtual uint32_t tokenize(const char* p, size_t n, uint32_t state,
+                              std::vector<Token>* out) const = 0;
+};
+
+// ─── Registro de gramáticas ───────────────────────────────────────
+// Por nombre de formato (el mismo de ExporterRegistry: "md", "html",
+// "csv"). Markdown, HTML y CSV vienen registradas; un plugin puede
+// agregar o reemplazar una con add() desde initialize().
+struct GrammarFormat {
+    std::string name;
+    std::function<std::unique_ptr<Grammar>()> create;
+};
+
+class GrammarRegistry {
+public:
+    static void add(GrammarFormat fmt);   // reemplaza la de mismo nombre
+    static std::unique_ptr<Grammar> create(const std::string& name);
+};
+
+// ─── Resaltado incremental ────────────────────────────────────────
+// Guarda el estado con que empieza una línea cada kStride líneas
+// (marcas). Las marcas hasta el frente están al día; las que siguen
+// son de antes de la última edición. Tras editar se vuelve a tokenizar
+// desde la marca anterior a la línea editada y, pasada la zona
+// editada, en cuanto el estado calculado coincide con una marca vieja
+// el resto se da por bueno sin recorrerlo.
+//
+// El trabajo por fotograma está acotado en tiempo: si el frente queda
+// lejos de la pantalla (un salto al final de un archivo enorme) se
+// pinta con un estado provisorio y el frente sigue avanzando con
+// settle() entre fotogramas.
+//
+// Las líneas de más de kMaxLineLength bytes (JSON minificado, volcados
+// en una sola línea) no se tokenizan: se pintan sin resaltar y dejan
+// pasar el estado tal como llega, sin copiarlas ni recorrerlas.
+class Highlighter {
+public:
+    // Líneas entre marca y marca
+    static const int kStride = 64;
+    // Bytes de la línea más larga que se tokeniza
+    static const size_t kMaxLineLength = 64 * 1024;
+
+    explicit Highlighter(const TextBuffer& buf);
+
+    void setGrammar(std::unique_ptr<Grammar> grammar);   // nullptr: sin resaltado
+    const Grammar* grammar() const { return grammar_.get(); }
+
+    void reset();                            // el documento cambió entero
+    void noteEdit(int row, int lineDelta);   // editada `row`; `lineDelta` líneas de más (o de menos)
+
+    // Estados con que empiezan las filas [row, row + n), todas menores
+    // que `lines` (las disponibles). Avanza el frente como mucho
+    // `budget`; false si algún estado quedó provisorio.
+    bool states(int row, int n, int lines, std::chrono::microseconds budget,
+                std::vector<uint32_t>& out);
+
+    // Avanza el frente hacia `row` durante `budget` como mucho; true si
+    // lo alcanzó
+    bool settle(int row, int lines, std::chrono::microseconds budget);
+
+private:
+    struct Mark {
+        int      line;
+        uint32_t state;
+    };
+
+    const TextBuffer&        buf_;
+    std::unique_ptr<Grammar> grammar_;
+    std::vector<Mark>        marks_;      // por línea creciente; marks_[0] = {0, 0}
+    size_t                   clean_;      // marks_[0, clean_) al día
+    int                      frontLine_;  // estado exacto de frontLine_: frontState_
+    uint32_t                 frontState_;
+    int                      dirtyTo_;    // no se empalma con marcas viejas hasta esta fila (-1: libre)
+    std::string              scratch_;   // línea partida entre piezas
+
+    // Estado tras una línea de forEachLine (nullptr: larguísima)
+    uint32_t advance(const char* p, size_t n, uint32_t state) const;
+
+    // Recorre las líneas [from, to) (to < lineCount) sin el fin de
+    // línea; las de más de kMaxLineLength llegan como (nullptr, largo).
+    // Se detiene si fn devuelve false.
+    bool forEachLine(int from, int to, const std::function<bool(const char*, size_t)>& fn);
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include "textsnapshot.h"
+#include "trigramindex.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TextBuffer;
+
+// ─── Búsqueda incremental ─────────────────────────────────────────
+// Cada tecla llama a update(). La región visible se resuelve en el
+// acto; el resto del documento lo recorre un hilo sobre una instantánea
+// (TextSnapshot), que se cancela en cuanto llega una consulta nueva.
+// Si la consulta extiende a la anterior sólo se filtran sus resultados,
+// y al borrar se recuperan los de la consulta más corta ya calculados.
+//
+// Los resultados son todas las apariciones (también solapadas), de modo
+// que los de "ab" son exactamente los de "a" seguidos de 'b'.
+class IncrementalSearch {
+public:
+    typedef std::vector<uint64_t> Matches;
+
+    IncrementalSearch() = default;
+    ~IncrementalSearch();   // cancela y espera al hilo
+
+    IncrementalSearch(const IncrementalSearch&) = delete;
+    IncrementalSearch& operator=(const IncrementalSearch&) = delete;
+
+    // Nueva consulta; [visFrom, visTo) es la parte del documento en pantalla.
+    // Si se dan `ranges` (p. ej. del índice de trigramas) el recorrido
+    // completo se limita a ellos: fuera no puede haber apariciones.
+    void update(const TextBuffer& buf, const std::string& query,
+                bool caseSensitive, uint64_t visFrom, uint64_t visTo,
+                const TrigramIndex::Ranges* ranges = nullptr);
+
+    // Incorpora el resultado del hilo si terminó; true si cambió algo
+    bool poll();
+
+    const std::string& query() const { return query_; }
+    bool   done() const { return done_; }   // resultados de todo el documento
+    double progress() const;                // 0..1 del recorrido en curso
+
+    // Offsets ordenados de cada aparición. Mientras !done() sólo cubren
+    // lo ya resuelto (al menos la región visible).
+    const Matches& matches() const { return *current_; }
+
+private:
+    // Resultados completos de una consulta, para volver atrás al borrar
+    struct Level {
+        std::string query;
+        bool        caseSensitive;
+        std::shared_ptr<const Matches> matches;
+    };
+    std::vector<Level> levels_;
+
+    std::string query_;
+    bool        caseSensitive_ = false;
+    bool        done_ = true;
+    std::shared_ptr<const Matches> current_ = std::make_shared<Matches>();
+
+    // Hilo en curso
+    std::thread           thread_;
+    std::atomic<bool>     cancel_{ false };
+    std::atomic<bool>     finished_{ false };
+    std::atomic<uint64_t> scanned_{ 0 };
+    uint64_t              total_ = 0;
+    std::mutex            mtx_;
+    std::shared_ptr<const Matches> result_;   // publicado por el hilo
+
+    void stop();
+    void start(TextSnapshot snap, std::shared_ptr<const Matches> base,
+               TrigramIndex::Ranges ranges);
+};
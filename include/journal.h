@@ -0,0 +1,106 @@
+#pragma once
+#include "textbuffer.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ─── Diario de ediciones (recuperación ante un corte) ─────────────
+// Archivo de solo-añadir junto al documento ("<ruta>.journal"): una
+// cabecera con la identidad del archivo en disco del que parten las
+// ediciones (tamaño y mtime) y después lotes de registros. Cada edición
+// es un registro binario compacto (offset, bytes quitados y texto
+// insertado en varints); cada lote lleva su longitud y suma de control,
+// así un lote cortado a medias se reconoce y se descarta.
+//
+// El hilo de la interfaz sólo codifica el registro en memoria; un hilo
+// escribe los lotes (cada kFlushMs o al juntar kFlushBytes) con
+// fdatasync. Un corte pierde como mucho el último intervalo. El archivo
+// se crea con la primera edición y se borra al guardar sin cambios
+// posteriores o al descartar el documento.
+class Journal {
+public:
+    Journal() = default;
+    ~Journal();   // vuelca lo pendiente; el archivo queda (no es un cierre limpio)
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Ruta del diario de `path`
+    static std::string pathFor(const std::string& path);
+
+    // Si hay un diario de `path` que parte del archivo tal como está en
+    // disco, aplica a `buf` sus ediciones (hasta el primer lote roto) y
+    // devuelve cuántas; 0 si no hay nada que recuperar.
+    static size_t replay(const std::string& path, TextBuffer& buf);
+    // Borra el diario de `path` sin abrirlo (un documento descartado
+    // que no estaba en el editor)
+    static void discard(const std::string& path);
+
+    // Empieza a registrar las ediciones del documento cargado de `path`.
+    // Un diario válido para el archivo en disco se continúa (se supone
+    // ya aplicado con replay); si no, se empieza uno nuevo.
+    bool open(const std::string& path);
+    // Deja de registrar. `discard` borra el archivo (documento guardado
+    // o descartado a propósito).
+    void close(bool discard);
+    bool active() const { return !path_.empty(); }
+
+    // Registro de ediciones, en el orden en que se aplican al documento
+    void noteEdit(uint64_t offset, uint64_t removed, const char* text, size_t len);
+    void noteReplaceMatches(const std::vector<uint64_t>& offsets, uint64_t len,
+                            const std::string& replacement);
+    void noteEdits(const std::vector<TextEdit>& edits);
+
+    // Posición actual del flujo de registros (ver rebase)
+    uint64_t mark() const;
+    // `path` en disco pasó a ser el documento tal como estaba en `mark`
+    // (terminó un guardado): el diario toma ese archivo como base y
+    // conserva sólo lo registrado después. Si no estaba activo, empieza.
+    void rebase(uint64_t mark, const std::string& path);
+
+private:
+    struct Base {
+        uint64_t size    = 0;
+        int64_t  mtimeNs = 0;
+    };
+    struct Rebase {
+        uint64_t    mark;
+        std::string file;   // diario nuevo
+        Base        base;
+    };
+
+    std::string path_;   // documento (vacío = inactivo)
+
+    // Compartido con el hilo
+    mutable std::mutex       mtx_;
+    std::condition_variable  cv_;
+    std::string              pending_;       // registros aún sin escribir
+    uint64_t                 enqueued_ = 0;  // bytes de registros desde siempre
+    std::vector<Rebase>      rebases_;
+    bool                     stop_     = false;
+
+    // Sólo el hilo (o con el hilo detenido)
+    int         fd_        = -1;
+    std::string file_;          // diario en uso
+    Base        base_;
+    uint64_t    fileStart_ = 0; // posición del flujo del primer registro del archivo
+
+    std::thread thread_;
+
+    static bool statBase(const std::string& path, Base& out);
+    // Lee un diario: cabecera y registros de los lotes íntegros. `end`
+    // recibe el tamaño válido del archivo.
+    static bool readFile(const std::string& file, Base& base,
+                         std::string& records, uint64_t& end);
+
+    void lockedAppend(uint64_t offset, uint64_t removed, const char* text, size_t len);
+    void wake(size_t before);
+    void run();
+    bool createFile(const std::string& file, const Base& base);
+    void writeBatch(const std::string& batch);
+    void applyRebase(const Rebase& r);
+    void stopThread();
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ─── Indexador de saltos de línea ─────────────────────────────────
+// Busca '\n' con SIMD (AVX2 / SSE2, con respaldo escalar). Los "\r\n"
+// no necesitan trato aparte: el '\r' se descarta al medir la línea.
+class LineIndexer {
+public:
+    // Agrega a `out` el offset (base + i) de cada '\n' de [data, data+len)
+    static void scan(const char* data, size_t len, uint64_t base,
+                     std::vector<uint64_t>& out);
+
+    // Igual que scan(), pero reparte el rango en tramos, escanea cada
+    // uno en su propio hilo y concatena los resultados en orden.
+    // threads = 0 usa todos los núcleos disponibles.
+    static void scanParallel(const char* data, size_t len, uint64_t base,
+                             std::vector<uint64_t>& out, unsigned threads = 0);
+
+    // Implementación elegida en tiempo de ejecución ("avx2", "sse2", "scalar")
+    static const char* backend();
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include "mappedfile.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ─── Indexado del original en segundo plano ───────────────────────
+// Un hilo recorre el archivo mapeado por tramos y publica los '\n'
+// encontrados. El hilo de la interfaz los recoge con take() entre
+// frames y los incorpora a la tabla de piezas, que no es thread-safe.
+class LoadWorker {
+public:
+    LoadWorker(std::shared_ptr<const MappedFile> file, uint64_t from);
+    ~LoadWorker();   // cancela y espera al hilo
+
+    LoadWorker(const LoadWorker&) = delete;
+    LoadWorker& operator=(const LoadWorker&) = delete;
+
+    void cancel();
+    void wait();
+
+    // Agrega a `lfs` los '\n' publicados desde la última llamada y
+    // devuelve hasta qué byte del archivo están cubiertos
+    uint64_t take(std::vector<uint64_t>& lfs);
+
+    bool     done()    const { return done_; }
+    uint64_t scanned() const { return scanned_; }
+
+private:
+    std::shared_ptr<const MappedFile> file_;
+    uint64_t from_;
+
+    std::atomic<bool>     cancel_;
+    std::atomic<bool>     done_;
+    std::atomic<uint64_t> scanned_;
+
+    std::mutex            mtx_;
+    std::vector<uint64_t> pending_;     // lotes aún no recogidos
+    uint64_t              pendingUpTo_;
+
+    std::thread thread_;
+
+    void run();
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include "transcoder.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+
+struct stat;
+
+// ─── Archivo mapeado en memoria (solo lectura) ────────────────────
+// Es el buffer "original" de la tabla de piezas: el contenido del
+// archivo nunca se copia, las piezas sólo lo referencian. Si el
+// archivo no está en UTF-8 se transcodifica una vez al cargar y el
+// original pasa a ser ese texto en memoria (ver fromMemory).
+class MappedFile {
+public:
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Abre y mapea el archivo. Devuelve nullptr si no se pudo abrir.
+    // `encoding`: la del documento, si el archivo ya es su texto en
+    // UTF-8 (un temporal de BufferList).
+    static std::shared_ptr<MappedFile> open(const std::string& path,
+                                            const TextEncoding& encoding = TextEncoding());
+    // Texto ya en memoria (el archivo transcodificado a UTF-8). No
+    // describe a ningún archivo en disco: nunca se parchea en el lugar.
+    static std::shared_ptr<MappedFile> fromMemory(std::unique_ptr<char[]> data, size_t size,
+                                                  TextEncoding encoding);
+
+    const char* data() const { return data_; }
+    size_t      size() const { return size_; }
+
+    // Codificación del archivo en disco (data() siempre es UTF-8)
+    const TextEncoding& encoding() const { return encoding_; }
+
+    // El texto está en memoria (fromMemory), no en un mapeo
+    bool inMemory() const { return mem_ != nullptr; }
+    // Suelta las páginas residentes del mapeo: se vuelven a leer del
+    // archivo al tocarlas (sin efecto en memoria)
+    void release() const;
+
+    // ¿`st` describe el mismo archivo, sin cambios ajenos desde que se
+    // mapeó (o desde el último parche propio)? Compara dispositivo,
+    // inodo, tamaño y mtime.
+    bool unchangedOnDisk(const struct stat& st) const;
+    // Tras parchearlo en el lugar: el nuevo estado pasa a ser el propio
+    void noteWritten(const struct stat& st) const;
+
+private:
+    MappedFile() = default;
+
+    const char* data_ = nullptr;
+    size_t      size_ = 0;
+    void*       map_  = nullptr; // base de mmap (nullptr si está vacío)
+    std::unique_ptr<char[]> mem_;  // sólo fromMemory
+    TextEncoding            encoding_;
+
+    // Estado conocido del archivo en disco (lo actualiza el hilo de guardado)
+    mutable std::mutex mutex_;
+    dev_t              dev_      = 0;
+    ino_t              ino_      = 0;
+    mutable uint64_t   diskSize_ = 0;
+    mutable int64_t    mtimeNs_  = 0;
+};
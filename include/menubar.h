@@ -22,7 +22,7 @@ public:
     ~MenuBar();
 
     void addMenu(const Menu& menu);
-    void draw();
+    void draw();   // sólo wnoutrefresh: se muestra con doupdate()
 
     // Devuelve true si el menú consumió la tecla
     bool handleInput(int ch);
@@ -0,0 +1,128 @@
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TextBuffer;
+
+// ─── Expresiones regulares compiladas ─────────────────────────────
+// El patrón se compila a un programa de NFA de Thompson. Para buscar,
+// un DFA perezoso (estados construidos bajo demanda y cacheados) recorre
+// las piezas del documento y descarta las líneas sin coincidencia; sólo
+// en las candidatas corre la máquina de Pike, que da la coincidencia más
+// a la izquierda con sus grupos. Todo es lineal en el texto: no hay
+// backtracking.
+//
+// Sintaxis: literales, . [..] [^..] \d \w \s \D \W \S \b \B \t \n \r,
+// ^ $ (inicio / fin de línea), ( ) (?: ), |, * + ? {m} {m,} {m,n} y
+// las variantes perezosas *? +? ?? {..}?. Las coincidencias no cruzan
+// líneas.
+class Regex {
+public:
+    // nullptr y `error` con el motivo si el patrón no es válido
+    static std::shared_ptr<const Regex> compile(const std::string& pattern,
+                                                bool caseSensitive,
+                                                std::string& error);
+
+    int groups() const { return groups_; }   // sin contar el grupo 0
+
+    // Texto de reemplazo: $0..$9 o ${n} insertan el grupo n, $$ un '$'
+    std::string expand(const std::string& tmpl, const char* line,
+                       const std::vector<long>& caps) const;
+
+    // ── Programa ──────────────────────────────────────────────────
+    enum Op : uint8_t {
+        Char,       // byte exacto (c)
+        Class,      // byte en classes_[x]
+        Split,      // salta a x (preferido) y a y
+        Jmp,        // salta a x
+        Save,       // guarda la posición en la ranura x
+        Bol, Eol,   // ^ $
+        WordB, NotWordB,
+        Match
+    };
+    struct Inst {
+        Op      op;
+        uint8_t c;
+        int     x, y;
+    };
+
+private:
+    friend class RegexMatcher;
+    friend class RegexCompiler;
+
+    std::vector<Inst>             prog_;
+    std::vector<std::bitset<256>> classes_;
+    int                           groups_ = 0;
+
+    bool consumes(const Inst& in, unsigned char b) const {
+        return in.op == Char ? in.c == b : classes_[in.x][b];
+    }
+};
+
+// ─── Estado de búsqueda ───────────────────────────────────────────
+// Caché del DFA y listas de hilos de la máquina de Pike. No es
+// thread-safe: cada hilo usa su propio RegexMatcher sobre el mismo Regex.
+class RegexMatcher {
+public:
+    explicit RegexMatcher(std::shared_ptr<const Regex> re);
+
+    // Coincidencia más a la izquierda en line[from..len) (line sin fin
+    // de línea). caps recibe 2*(groups+1) posiciones; -1 si el grupo no
+    // participó.
+    bool search(const char* line, size_t len, size_t from,
+                std::vector<long>& caps);
+
+    // Recorre las líneas que empiezan en [from, to) (from al inicio de
+    // una línea) y llama fn(inicio, fin sin terminador) por cada una que
+    // puede tener coincidencia. Se detiene si fn devuelve false.
+    void scanLines(const TextBuffer& buf, uint64_t from, uint64_t to,
+                   const std::function<bool(uint64_t, uint64_t)>& fn);
+
+private:
+    std::shared_ptr<const Regex> re_;
+
+    // ── DFA perezoso ──────────────────────────────────────────────
+    // table_[id*256 + b]: >= 0 es la fila (id*256) del estado siguiente;
+    // -1 sin calcular (y siempre para '\n'); <= -2 es el estado -v-2,
+    // al que se llega por '\r' o que ya contiene Match (ruta lenta).
+    struct DState {
+        std::vector<int> pcs;     // hilos tras la clausura
+        bool match;               // ya contiene Match
+        int  eolMatch;            // -1 sin calcular; 0/1 si acepta al final
+    };
+    std::vector<std::unique_ptr<DState>> states_;
+    std::map<std::vector<int>, int>      ids_;
+    std::vector<int>                     table_;
+    std::vector<int> restart_;   // clausura del inicio a mitad de línea
+    int startBol_, startMid_;
+
+    void closure(int pc, bool atBol, bool atEol,
+                 std::vector<char>& seen, std::vector<int>& out) const;
+    int  intern(std::vector<int>& pcs);
+    int  step(int& s, unsigned char b);   // s se reubica si se vacía la caché
+    bool acceptsAtEol(int s);
+    bool mayMatch(const char* line, size_t len, size_t from);
+    void resetCache();
+
+    // ── Máquina de Pike ───────────────────────────────────────────
+    struct Threads {
+        std::vector<int>  dense;   // pcs en orden de prioridad
+        std::vector<int>  sparse;  // pc → índice en dense
+        std::vector<long> caps;    // ranuras por pc
+        bool has(int pc) const {
+            int i = sparse[pc];
+            return i < (int)dense.size() && dense[i] == pc;
+        }
+    };
+    Threads clist_, nlist_;
+    std::vector<long> scratch_;
+
+    void addThread(Threads& l, int pc, long* caps, const char* line,
+                   size_t len, size_t pos);
+};
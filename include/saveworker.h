@@ -0,0 +1,45 @@
+#pragma once
+#include "filemanager.h"
+#include "textsnapshot.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// ─── Guardado en segundo plano ────────────────────────────────────
+// Un hilo escribe una instantánea del documento con
+// FileManager::writeSnapshot (temporal en el mismo directorio, fsync
+// según la política y rename encima del destino). El hilo de la
+// interfaz consulta done() entre frames y sigue editando mientras tanto.
+class SaveWorker {
+public:
+    SaveWorker(std::string path, TextSnapshot snap, FileFormat fmt, FsyncPolicy policy);
+    ~SaveWorker();   // espera al hilo: cortarlo dejaría el temporal a medias
+
+    SaveWorker(const SaveWorker&) = delete;
+    SaveWorker& operator=(const SaveWorker&) = delete;
+
+    void wait();
+
+    bool   done() const { return done_; }
+    double progress() const;
+
+    // Válidos cuando done()
+    bool               ok()    const { return ok_; }
+    const std::string& error() const { return error_; }
+
+    const std::string& path() const { return path_; }
+
+private:
+    std::string  path_;
+    TextSnapshot snap_;
+    FileFormat   fmt_;
+    FsyncPolicy  policy_;
+
+    std::atomic<uint64_t> written_;   // bytes del documento ya procesados
+    std::atomic<bool>     done_;
+    bool                  ok_;
+    std::string           error_;
+
+    std::thread thread_;
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class TextBuffer;
+class TextSnapshot;
+
+// ─── Núcleo de búsqueda literal ───────────────────────────────────
+// Filtro SIMD por primer y último byte de la aguja y verificación de
+// los candidatos. Sin distinguir mayúsculas, el pliegue (ASCII, como
+// ::tolower) se hace al vuelo en registros: no se copia ni se
+// convierte el texto, y no se reserva memoria por línea.
+class SearchKernel {
+public:
+    static const uint64_t npos = UINT64_MAX;
+
+    SearchKernel(const std::string& needle, bool caseSensitive);
+
+    size_t size() const { return needle_.size(); }
+
+    // Primera coincidencia en [hay+from, hay+len) o npos
+    uint64_t find(const char* hay, size_t len, size_t from = 0) const;
+
+    // Primera coincidencia en el documento entre [from, to), recorriendo
+    // las piezas sin materializar líneas (incluye las que cruzan piezas)
+    uint64_t find(const TextBuffer& buf, uint64_t from, uint64_t to) const;
+    uint64_t find(const TextSnapshot& snap, uint64_t from, uint64_t to) const;
+
+    // Implementación elegida en tiempo de ejecución
+    static const char* backend();
+
+private:
+    std::string needle_;   // ya plegada si !caseSensitive_
+    bool        caseSensitive_;
+
+    template <class Source>
+    uint64_t findSpans(const Source& src, uint64_t from, uint64_t to) const;
+};
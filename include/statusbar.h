@@ -7,8 +7,14 @@ public:
     StatusBar(int y, int x, int width);
     ~StatusBar();
 
+    // totalKnown = false: el archivo aún no se recorrió entero ("N+").
+    // Como drawPrompt, sólo prepara (wnoutrefresh): se muestra con doupdate()
     void draw(int row, int col, const std::string& filename,
-              bool dirty, int totalLines);
+              bool dirty, int totalLines, bool totalKnown = true);
+    // Línea de entrada (búsqueda incremental): "label text" a la
+    // izquierda con el cursor al final, `info` a la derecha
+    void drawPrompt(const std::string& label, const std::string& text,
+                    const std::string& info);
     void showMessage(const std::string& msg, int durationMs = 2000);
     void resize(int y, int x, int width);
 
@@ -0,0 +1,42 @@
+#pragma once
+#include <ncurses.h>
+#include <cstddef>
+#include <string>
+
+class CsvTable;
+
+// ─── Vista de tabla de un CSV ─────────────────────────────────────
+// Dibuja un CsvTable en la zona del editor: la cabecera fija arriba,
+// columnas alineadas a los anchos del índice y el número de fila real
+// a la izquierda. Sólo se leen las filas visibles. Navega por la vista
+// del índice (ya ordenada / filtrada); no edita.
+class TableView {
+public:
+    TableView(int y, int x, int height, int width);
+    ~TableView();
+
+    void setTable(const CsvTable* table);   // vuelve a la primera celda
+    void draw();                            // sólo wnoutrefresh
+    void resize(int y, int x, int height, int width);
+
+    // Flechas, Tab / Shift+Tab, RePág / AvPág, Inicio / Fin; false si
+    // la tecla no es de navegación
+    bool handleInput(int ch);
+
+    size_t cursorRow() const { return curRow_; }   // índice en la vista
+    size_t cursorCol() const { return curCol_; }
+    void   gotoRow(size_t i);
+    void   gotoColumn(size_t col);
+
+private:
+    WINDOW*         win_;
+    int             height_, width_;
+    const CsvTable* table_;
+    size_t          curRow_, curCol_;
+    size_t          topRow_, leftCol_;
+
+    int  dataHeight() const { return height_ > 1 ? height_ - 1 : 0; }
+    int  gutterWidth() const;
+    void scrollToCursor();
+    void drawRow(int y, size_t row, bool header);
+};
@@ -0,0 +1,179 @@
+#pragma once
+#include "mappedfile.h"
+#include "loadworker.h"
+#include "textsnapshot.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ─── Pieza: tramo contiguo de uno de los buffers ──────────────────
+struct Piece {
+    uint32_t buf;      // 0 = archivo original, 1.. = bloques de añadidos
+    uint64_t start;    // offset dentro del buffer
+    uint64_t length;   // bytes
+    uint64_t lfFirst;  // índice (en lfs del buffer) del primer '\n' de la pieza
+    uint64_t lfCount;  // cantidad de '\n' dentro de la pieza
+};
+
+// ─── Edición puntual para applyEdits ──────────────────────────────
+struct TextEdit {
+    uint64_t    offset;   // inicio del tramo a reemplazar
+    uint64_t    length;   // bytes que se quitan (0 = insertar)
+    std::string text;     // lo que queda en su lugar
+};
+
+// ─── Tabla de piezas ──────────────────────────────────────────────
+// El documento es la concatenación de piezas que apuntan al archivo
+// original (mapeado, nunca copiado) o a bloques de añadidos. Las piezas
+// viven en un treap implícito con totales de bytes y de '\n' por
+// subárbol, de modo que insertar, borrar y ubicar una línea cuestan
+// O(log n) sin importar en qué parte del archivo ocurran.
+//
+// Con carga perezosa el original se indexa por tramos: el documento
+// contiene sólo las líneas ya recorridas y el resto del archivo se
+// agrega al final a medida que se pide (ensureLines / loadAll), o bien
+// lo recorre un LoadWorker en segundo plano (startBackgroundLoad).
+class TextBuffer {
+public:
+    TextBuffer();                                    // documento vacío
+    explicit TextBuffer(std::shared_ptr<const MappedFile> file,
+                        bool lazy = false);
+    ~TextBuffer();
+
+    TextBuffer(TextBuffer&& other) noexcept;
+    TextBuffer& operator=(TextBuffer&& other) noexcept;
+    TextBuffer(const TextBuffer&) = delete;
+    TextBuffer& operator=(const TextBuffer&) = delete;
+
+    // Tamaño total en bytes
+    uint64_t size() const;
+
+    // Líneas (separadas por '\n'; siempre hay al menos una)
+    int      lineCount() const;
+    uint64_t lineStart(int row) const;
+    uint64_t lineLength(int row) const;   // sin "\n" ni "\r\n"
+    std::string line(int row) const;
+
+    // Línea que contiene el offset dado
+    int lineAt(uint64_t offset) const;
+
+    char        at(uint64_t offset) const;
+    std::string substr(uint64_t offset, uint64_t len) const;
+    std::string text() const;
+
+    // Recorre en orden los tramos contiguos de [offset, offset+len)
+    void forEachSpan(uint64_t offset, uint64_t len,
+                     const std::function<void(const char*, size_t)>& fn) const;
+    // Igual, pero se detiene cuando fn devuelve false (y devuelve false)
+    bool forEachSpanWhile(uint64_t offset, uint64_t len,
+                          const std::function<bool(const char*, size_t)>& fn) const;
+
+    // Copia de solo lectura de la lista de tramos (O(piezas)), apta
+    // para recorrerla desde otro hilo. Con `withPendingTail` incluye al
+    // final lo que la carga perezosa aún no agregó (el archivo completo,
+    // tal como se guardaría).
+    TextSnapshot snapshot(bool withPendingTail = false) const;
+
+    // Edición
+    void insert(uint64_t offset, const char* data, size_t len);
+    void insert(uint64_t offset, const std::string& s) { insert(offset, s.data(), s.size()); }
+    void erase(uint64_t offset, uint64_t len);
+
+    // Reemplaza de una vez todas las coincidencias (offsets ordenados y
+    // sin solaparse, de `len` bytes cada una). El reemplazo se guarda
+    // una sola vez y el árbol se reconstruye en O(piezas + coincidencias).
+    void replaceMatches(const std::vector<uint64_t>& offsets, uint64_t len,
+                        const std::string& replacement);
+
+    // Igual, pero cada tramo con su propio texto (p. ej. reemplazos con
+    // grupos de captura). Ediciones ordenadas por offset y sin solaparse.
+    void applyEdits(const std::vector<TextEdit>& edits);
+
+    // Fin de línea detectado al cargar ("\n" o "\r\n")
+    const std::string& eol() const { return eol_; }
+    // Codificación del archivo en disco (UTF-8 si el documento es nuevo)
+    TextEncoding encoding() const;
+
+    // Carga perezosa del original
+    bool fullyLoaded() const { return loadedEnd_ >= blocks_[0]->size; }
+    void ensureLines(int rows);   // hasta tener `rows` líneas completas
+    void ensureLoaded(uint64_t offset);   // hasta tener el original hasta `offset`
+    void loadAll();
+    // Parte del original que todavía no está en el documento
+    std::string_view pendingTail() const;
+
+    // Carga en segundo plano: mientras el hilo trabaja, ensureLines sólo
+    // incorpora lo ya recorrido y nunca bloquea
+    void   startBackgroundLoad();
+    bool   pollBackgroundLoad();    // true si se agregaron líneas
+    void   cancelBackgroundLoad();  // lo ya recorrido queda en el documento
+    bool   backgroundLoading() const { return worker_ != nullptr; }
+    double loadProgress() const;    // 0..1 sobre los bytes del original
+
+    size_t pieceCount() const;
+    // Memoria que ocupa: piezas, bloques de añadidos, índices de '\n' y
+    // el original (si está mapeado, sólo lo ya recorrido)
+    size_t memoryBytes() const;
+
+private:
+    // Buffer inmutable salvo por append al final (bloques de añadidos)
+    struct Block {
+        std::shared_ptr<const MappedFile> file; // sólo el original
+        std::unique_ptr<char[]> mem;            // sólo bloques de añadidos
+        const char* data     = nullptr;
+        size_t      size     = 0;
+        size_t      capacity = 0;
+        std::vector<uint64_t> lfs;              // offsets de cada '\n'
+    };
+
+    struct Node;
+
+    // Tramo [offset, offset+length) que pasa a ser `piece` (vacía si length 0)
+    struct Splice {
+        uint64_t offset;
+        uint64_t length;
+        Piece    piece;
+    };
+
+    std::vector<std::shared_ptr<Block>> blocks_;
+    Node*       root_;
+    uint32_t    seed_;
+    std::string eol_;
+    uint64_t    scanned_;    // bytes del original ya recorridos buscando '\n'
+    uint64_t    loadedEnd_;  // bytes del original ya agregados al documento
+    std::unique_ptr<LoadWorker> worker_;
+
+    Node* newNode(const Piece& p);
+    uint32_t nextPrio();
+
+    static void     update(Node* t);
+    static Node*    merge(Node* a, Node* b);
+    void            split(Node* t, uint64_t off, Node*& l, Node*& r);
+    static void     destroy(Node* t);
+    Node*           appendPiece(Node* t, const Piece& p);
+    void            collect(const Node* t, std::vector<Piece>& out) const;
+    Node*           build(const std::vector<Piece>& pieces);
+    void            splice(const std::vector<Splice>& splices);
+
+    Piece pieceHead(const Piece& p, uint64_t n) const;
+    Piece pieceTail(const Piece& p, uint64_t n) const;
+    Piece pieceSlice(const Piece& p, uint64_t from, uint64_t to) const;
+    uint64_t lfBefore(const Piece& p, uint64_t n) const;
+
+    // Offset absoluto del k-ésimo '\n' (k >= 1)
+    uint64_t lfOffset(uint64_t k) const;
+
+    // Copia bytes al bloque de añadidos actual y devuelve la pieza
+    Piece append(const char* data, size_t len);
+
+    // Recorre al menos `bytes` más del original y agrega al documento
+    // las líneas completas encontradas
+    void indexMore(uint64_t bytes);
+    void commitScanned();
+
+    bool visit(const Node* t, uint64_t base, uint64_t from, uint64_t to,
+               const std::function<bool(const char*, size_t)>& fn) const;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class MappedFile;
+
+// ─── Instantánea de solo lectura del documento ────────────────────
+// Lista de tramos (punteros a los buffers de la tabla de piezas) tomada
+// en un momento dado. Mantiene vivos los bloques que referencia, que
+// nunca se mueven ni se reescriben: otro hilo puede leerla mientras el
+// hilo de la interfaz sigue editando o cargando el TextBuffer.
+class TextSnapshot {
+public:
+    TextSnapshot() = default;
+
+    uint64_t size() const { return size_; }
+
+    // Mismo contrato que TextBuffer::forEachSpanWhile
+    bool forEachSpanWhile(uint64_t offset, uint64_t len,
+                          const std::function<bool(const char*, size_t)>& fn) const;
+
+    std::string substr(uint64_t offset, uint64_t len) const;
+
+    // Puntero a [offset, offset+len) si cae entero en un tramo; si no, nullptr
+    const char* contiguous(uint64_t offset, uint64_t len) const;
+
+    // Mismos tramos que `other`: el mismo documento sin tocar
+    bool sameSpans(const TextSnapshot& other) const;
+
+    // Archivo mapeado del que salió el documento (nullptr si es nuevo)
+    const std::shared_ptr<const MappedFile>& original() const { return original_; }
+
+    // Si el documento es el original con reemplazos del mismo tamaño
+    // y/o texto agregado al final, deja en `out` los tramos [desde, hasta)
+    // que no salen del original en su mismo offset y devuelve true. Si
+    // algo se movió, se borró o se insertó en medio, devuelve false.
+    bool patchRanges(std::vector<std::pair<uint64_t, uint64_t>>& out) const;
+
+private:
+    friend class TextBuffer;
+
+    struct Span {
+        const char* data;
+        uint64_t    length;
+        uint64_t    start;   // offset en el documento
+    };
+    std::vector<Span>                        spans_;
+    std::vector<std::shared_ptr<const void>> keep_;   // bloques referenciados
+    std::shared_ptr<const MappedFile>        original_;
+    uint64_t                                 size_ = 0;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ─── Pool de hilos compartido ─────────────────────────────────────
+// Hilos fijos (uno por núcleo) que atienden una cola de tareas. Lo
+// usan las operaciones que reparten el documento por rangos.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = 0);   // 0 = un hilo por núcleo
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Encola una tarea; el future se cumple al terminarla
+    std::future<void> submit(std::function<void()> task);
+
+    unsigned size() const { return (unsigned)workers_.size(); }
+
+    // Pool global de la aplicación
+    static ThreadPool& shared();
+
+private:
+    std::vector<std::thread>               workers_;
+    std::deque<std::packaged_task<void()>> queue_;
+    std::mutex                             mtx_;
+    std::condition_variable                cv_;
+    bool                                   stop_;
+
+    void loop();
+};
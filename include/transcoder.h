@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Juego de caracteres del archivo en disco. En memoria el documento
+// siempre es UTF-8.
+enum class Charset {
+    UTF8,
+    UTF16LE,
+    UTF16BE,
+    Latin1    // se lee como Windows-1252, su superconjunto habitual
+};
+
+struct TextEncoding {
+    Charset charset = Charset::UTF8;
+    bool    bom     = false;   // el archivo empieza con la marca de orden
+
+    // UTF-8 sin BOM: el archivo es el documento, byte a byte
+    bool plain() const { return charset == Charset::UTF8 && !bom; }
+};
+
+// ─── Transcodificación al cargar y al guardar ─────────────────────
+// Valida UTF-8 con SIMD (AVX2: clasificación por tablas de nibbles,
+// 32 bytes por paso; SSE2: salto de bloques ASCII; respaldo escalar) y
+// convierte Latin-1 / UTF-16 a UTF-8 y de vuelta. Los bloques ASCII se
+// copian (o se ensanchan / estrechan) de a 32 bytes; sólo el resto
+// pasa por el camino escalar.
+class Transcoder {
+public:
+    // ¿[p, p+n) es UTF-8 válido? (sin sobrelargos, sustitutos ni
+    // secuencias cortadas)
+    static bool validUtf8(const char* p, size_t n);
+
+    // BOM si lo hay; si no, UTF-16 por la posición de los bytes nulos,
+    // UTF-8 si valida (o si casi todo lo que no es ASCII lo es) y
+    // Latin-1 si no. Mira sólo los primeros `sniff` bytes (0 = todos).
+    static TextEncoding detect(const char* p, size_t n, size_t sniff = 0);
+
+    // Cota de los bytes de UTF-8 que salen de n bytes en `enc`
+    static size_t utf8Bound(const TextEncoding& enc, size_t n);
+    // El archivo entero (con su BOM) a UTF-8 en `out`, que tiene lugar
+    // para utf8Bound bytes. Devuelve los bytes escritos. Un sustituto
+    // UTF-16 sin pareja pasa a ser U+FFFD.
+    static size_t toUtf8(const TextEncoding& enc, const char* p, size_t n, char* out);
+
+    // De UTF-8 a `cs`, por tramos: convierte los caracteres completos de
+    // [p, p+n) en `out` (lugar para 2n bytes) y devuelve los bytes
+    // consumidos; `written` recibe los escritos. Una secuencia cortada
+    // al final queda sin consumir salvo en el último tramo (`last`).
+    // Lo que no existe en Latin-1 se escribe como '?'.
+    static size_t fromUtf8(Charset cs, const char* p, size_t n, char* out,
+                           size_t& written, bool last);
+
+    // Marca de orden de bytes de la codificación ("" si no lleva)
+    static std::string bom(const TextEncoding& enc);
+    // Para la barra de estado: "UTF-8", "UTF-16 LE", "Latin-1"...
+    static const char* name(const TextEncoding& enc);
+
+    // Implementación elegida en tiempo de ejecución ("avx2", "sse2", "scalar")
+    static const char* backend();
+};
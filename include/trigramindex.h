@@ -0,0 +1,81 @@
+#pragma once
+#include "textsnapshot.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ─── Índice de trigramas por bloques ──────────────────────────────
+// El documento se parte en bloques de ~64 KiB cortados en inicio de
+// línea. Para cada trigrama (plegado a minúsculas ASCII y reducido a
+// uno de kBuckets cubos) se guarda un bitmap con los bloques que lo
+// contienen. Una aguja sólo puede estar en los bloques donde aparecen
+// todos sus trigramas: el AND de sus bitmaps da los rangos a recorrer.
+//
+// Se construye en un hilo sobre una instantánea. Las ediciones corren
+// los límites de los bloques y marcan como sucios los que tocan; un
+// bloque sucio (y sus vecinos) siempre se recorre, hasta la próxima
+// reconstrucción.
+class TrigramIndex {
+public:
+    typedef std::vector<std::pair<uint64_t, uint64_t>> Ranges;   // [desde, hasta)
+
+    TrigramIndex() = default;
+    ~TrigramIndex();   // cancela y espera al hilo
+
+    TrigramIndex(const TrigramIndex&) = delete;
+    TrigramIndex& operator=(const TrigramIndex&) = delete;
+
+    // Reconstruye en segundo plano (descarta lo anterior)
+    void build(TextSnapshot snap);
+    // Olvida el índice (p. ej. tras reemplazar todo)
+    void reset();
+
+    bool building() const { return thread_.joinable(); }
+    bool ready()    const { return ready_; }
+    // Hay bloques sucios: conviene reconstruir
+    bool stale()    const { return ready_ && dirtyCount_ > 0; }
+
+    // Ajusta los bloques a una edición en `offset`
+    void noteEdit(uint64_t offset, uint64_t removed, uint64_t inserted);
+
+    // Rangos de [0, docSize) que pueden contener la aguja. false si el
+    // índice no sirve para esta búsqueda (no está listo, la aguja tiene
+    // menos de 3 bytes o un salto de línea): hay que recorrer todo.
+    bool candidates(const std::string& needle, uint64_t docSize, Ranges& out);
+
+    size_t memoryBytes() const;
+
+private:
+    struct Block {
+        uint64_t length;
+        bool     dirty;
+    };
+    struct Edit {
+        uint64_t offset, removed, inserted;
+    };
+    typedef std::vector<uint64_t> Bitmap;
+
+    // Índice en uso (sólo hilo de la interfaz)
+    bool                ready_ = false;
+    std::vector<Block>  blocks_;
+    std::vector<Bitmap> postings_;   // cubo → bloques
+    size_t              dirtyCount_ = 0;
+
+    // Construcción en curso
+    std::thread         thread_;
+    std::atomic<bool>   cancel_{ false };
+    std::atomic<bool>   finished_{ false };
+    std::mutex          mtx_;
+    std::vector<Block>  builtBlocks_;
+    std::vector<Bitmap> builtPostings_;
+    std::vector<Edit>   pendingEdits_;   // ediciones durante la construcción
+
+    void stop();
+    bool adopt();   // incorpora el resultado del hilo si terminó
+    void applyEdit(const Edit& e);
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// ─── Historial de deshacer / rehacer ──────────────────────────────
+// Registro de operaciones, no de copias del documento: cada paso guarda
+// sus tramos (offset, bytes quitados, bytes puestos) y los textos
+// concatenados en dos strings. La escritura seguida (y sus Backspace /
+// Supr) se funde en un solo tramo; una edición en otro lugar, o tras
+// seal() (Enter, pegar, reemplazar...), abre un paso nuevo. Un
+// reemplazar-todo es un único paso "masivo" que se deshace con la misma
+// operación en bloque que lo hizo.
+//
+// La memoria de ambos historiales se limita a `budget` bytes: al pasarse
+// se descartan primero los pasos más viejos.
+class UndoLog {
+public:
+    static const size_t kDefaultBudget = 64u << 20;
+
+    struct Delta {
+        uint64_t offset;
+        uint64_t removed;    // bytes quitados
+        uint64_t inserted;   // bytes puestos
+    };
+
+    struct Step {
+        std::vector<Delta> deltas;
+        std::string        removed;    // textos quitados, en orden de deltas
+        std::string        inserted;   // textos puestos, en orden de deltas
+        // Secuencial: cada delta se aplica sobre el resultado del anterior.
+        // Masivo: offsets del documento previo, ordenados y sin solaparse.
+        bool bulk         = false;
+        // Masivo: todos los tramos quitan / ponen el mismo texto (guardado una vez)
+        bool sameRemoved  = false;
+        bool sameInserted = false;
+
+        size_t bytes() const;
+    };
+
+    explicit UndoLog(size_t budget = kDefaultBudget);
+
+    void   setBudget(size_t bytes);
+    size_t budget() const      { return budget_; }
+    size_t memoryBytes() const { return bytes_; }
+
+    void clear();
+
+    // Las ediciones siguientes van a un paso nuevo
+    void seal() { open_ = false; }
+    // Entre beginGroup y endGroup todo va a un mismo paso, contiguo o no
+    void beginGroup() { seal(); grouping_ = true; }
+    void endGroup()   { grouping_ = false; seal(); }
+
+    // Mientras se aplica un paso (deshacer/rehacer) no se registra nada
+    void setPaused(bool paused) { paused_ = paused; }
+    bool recording() const      { return !paused_; }
+
+    // Edición puntual: se funde con el paso abierto si es contiguo a él
+    // (si no, abre otro) y descarta lo que hubiera para rehacer
+    void record(uint64_t offset, const char* removed, size_t removedLen,
+                const char* inserted, size_t insertedLen);
+    // Paso masivo ya armado (cerrado antes y después)
+    void recordBulk(Step&& step);
+
+    bool canUndo() const { return !undo_.empty(); }
+    bool canRedo() const { return !redo_.empty(); }
+
+    // Pasa el último paso al otro historial y lo devuelve para aplicarlo
+    // (nullptr si no hay). Válido hasta el próximo record.
+    const Step* undo();
+    const Step* redo();
+
+private:
+    std::deque<Step> undo_;
+    std::deque<Step> redo_;
+    size_t budget_;
+    size_t bytes_;    // suma de bytes() de ambos historiales
+    bool   open_;     // el último paso de undo_ admite más ediciones
+    bool   grouping_;
+    bool   paused_;
+
+    bool merge(Step& s, uint64_t offset, const char* removed, size_t removedLen,
+               const char* inserted, size_t insertedLen);
+    void clearRedo();
+    void enforceBudget();
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+class ColumnMap;
+
+// ─── Índice de filas visuales (ajuste de línea) ───────────────────
+// Cuántas filas de pantalla ocupa cada línea al ajustarla a `width`
+// columnas de pantalla (las de ColumnMap). Las líneas consecutivas con
+// la misma cantidad de filas forman un tramo; los tramos viven en un
+// treap implícito con totales de líneas y de filas por subárbol, así
+// que pasar de línea a fila visual y al revés cuesta O(log n) en
+// cualquier parte del documento.
+//
+// Se mide perezosamente: el índice cubre las primeras lines() líneas
+// y measure() agrega las que se necesiten recorriendo el texto. Una
+// edición vuelve a medir sólo las líneas tocadas; cambiar el ancho
+// descarta todo (reset) y se vuelve a medir a medida que se pide.
+class WrapIndex {
+public:
+    WrapIndex();
+    ~WrapIndex();
+
+    WrapIndex(const WrapIndex&) = delete;
+    WrapIndex& operator=(const WrapIndex&) = delete;
+
+    // Filas de una línea de `columns` columnas: la columna c cae en la
+    // fila c / width, incluida la posición tras el último carácter
+    static int rowsFor(uint64_t columns, int width) {
+        return (int)(columns / (uint64_t)(width > 0 ? width : 1)) + 1;
+    }
+
+    void reset(int width);            // vacío, con otro ancho
+    int  width() const { return width_; }
+    int  lines() const;               // líneas medidas
+    int64_t totalRows() const;        // filas de las líneas medidas
+
+    // Mide las líneas [lines(), upTo) del documento de `cols`
+    // (upTo <= lineCount())
+    void measure(ColumnMap& cols, int upTo);
+    // Las líneas medidas [row, row + oldLines) pasaron a ser
+    // [row, row + newLines) en el documento. true si cambió la cantidad de
+    // filas de la zona (lo que sigue se corrió en pantalla).
+    bool replaceLines(ColumnMap& cols, int row, int oldLines, int newLines);
+    void truncate(int lines);         // olvida las líneas desde `lines`
+
+    // Con line < lines()
+    int     rows(int line) const;
+    int64_t rowsBefore(int line) const;     // filas de las líneas anteriores
+    // Línea medida que contiene la fila visual `row` (< totalRows()) y
+    // la fila dentro de ella
+    int lineAtRow(int64_t row, int& sub) const;
+
+private:
+    struct Node;
+
+    Node*    root_;
+    int      width_;
+    int      docLines_;   // líneas del documento al medir por última vez
+    uint32_t seed_;
+
+    uint32_t     nextPrio();
+    Node*        newNode(int rows, int count);
+    static void  update(Node* t);
+    static Node* merge(Node* a, Node* b);
+    void         split(Node* t, int lines, Node*& l, Node*& r);
+    static void  destroy(Node* t);
+    Node*        appendRun(Node* t, int rows, int count);
+};
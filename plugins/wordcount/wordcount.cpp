@@ -27,10 +27,11 @@ public:
     void execute(const std::string& /*action*/) override {
         if (!ctx_.editor) return;
 
-        const auto& lines = ctx_.editor->getLines();
-        int chars = 0, words = 0, linesCount = (int)lines.size();
+        Editor* ed = ctx_.editor;
+        int chars = 0, words = 0, linesCount = ed->lineCount();
 
-        for (const auto& line : lines) {
+        for (int i = 0; i < linesCount; ++i) {
+            const std::string line = ed->line(i);
             chars += (int)line.size();
             bool inWord = false;
             for (char c : line) {
@@ -1,13 +1,53 @@
 #include "app.h"
+#include "bufferlist.h"
+#include "csvtable.h"
 #include "dialog.h"
+#include "exporter.h"
 #include "filemanager.h"
+#include "incsearch.h"
+#include "journal.h"
+#include "saveworker.h"
+#include "tableview.h"
+#include "transcoder.h"
 #include <ncurses.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
 #include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <filesystem>
+#include <thread>
+
+// Límite de fotogramas por defecto (ver App::setMaxFps)
+static const int kDefaultMaxFps = 60;
+// Cada cuánto se actualiza el avance al esperar una carga
+static const int kWaitPollMs = 50;
+
+// ── Pegado entre corchetes (bracketed paste) ──────────────────────
+// Con el modo 2004 activo el terminal envuelve lo pegado entre
+// ESC[200~ y ESC[201~. El inicio llega como una tecla propia.
+static const int   kKeyPasteBegin = KEY_MAX + 1;
+static const int   kKeyPasteEnd   = KEY_MAX + 2;
+static const char  kPasteEnd[]    = "\033[201~";
+// Si el terminal deja de enviar sin cerrar el pegado, se da por terminado
+static const int   kPasteTimeoutMs = 500;
+
+// Nombre del formato de un archivo según su extensión
+static std::string formatOf(const std::string& path) {
+    const ExportFormat* fmt = ExporterRegistry::find(FileManager::detectFormat(path));
+    return fmt ? fmt->name : "txt";
+}
+
+static std::string megabytes(size_t bytes) {
+    return std::to_string((bytes + (1u << 19)) >> 20) + " MiB";
+}
 
 // ── Constructor ───────────────────────────────────────────────────
 App::App(int argc, char* argv[])
-    : currentFormat_("txt"), running_(true)
+    : currentFormat_("txt"), running_(true), maxFps_(kDefaultMaxFps),
+      fsyncPolicy_(FsyncPolicy::File), savingNotify_(false),
+      savingJournal_(false), savingRaw_(false), savingMark_(0)
 {
     // Crear las tres zonas de pantalla
     int editorH = LINES - 2; // menos menubar y statusbar
@@ -18,87 +58,170 @@ App::App(int argc, char* argv[])
 
     buildMenus();
 
+    // Ctrl+Z es deshacer: el terminal no debe suspender el programa
+    // (endwin restaura el modo original al salir)
+    struct termios tio;
+    if (tcgetattr(STDIN_FILENO, &tio) == 0) {
+        tio.c_cc[VSUSP] = _POSIX_VDISABLE;
+        tcsetattr(STDIN_FILENO, TCSANOW, &tio);
+        def_prog_mode();
+    }
+
+    putp("\033[?2004h");
+    define_key("\033[200~", kKeyPasteBegin);
+    define_key("\033[201~", kKeyPasteEnd);
+
     // Cargar plugins desde carpeta ./plugins
     PluginContext ctx{ editor_.get(), this };
     pluginMgr_.loadFromDirectory("./plugins", ctx);
     buildPluginMenu(); // añadir menú de plugins si los hay
 
-    // Si se pasó un archivo como argumento, abrirlo
-    if (argc > 1) {
-        currentFile_ = argv[1];
-        std::vector<std::string> lines;
-        if (FileManager::load(currentFile_, lines)) {
-            editor_->setLines(lines);
-            pluginMgr_.notifyOpen(currentFile_);
-        }
+    // Cada archivo pasado como argumento es un documento: el primero se
+    // abre ya y los demás se leen al pasar a ellos. Si el primero no
+    // existe, el documento vacío queda con su ruta (se crea al guardar).
+    if (argc > 1 && !openPath(argv[1])) {
+        currentFile_   = argv[1];
+        currentFormat_ = formatOf(currentFile_);
+        editor_->setSyntax(currentFormat_);
+    }
+    for (int i = 2; i < argc; ++i) {
+        if (buffers_.find(argv[i]) != SIZE_MAX) continue;
+        buffers_.add(argv[i], formatOf(argv[i]));
+        pluginMgr_.notifyOpen(argv[i]);
     }
 }
 
-App::~App() {}
+App::~App() {
+    // Un guardado en curso termina antes de salir
+    if (saving_) saving_->wait();
+    putp("\033[?2004l");
+}
 
 // ── Bucle principal ───────────────────────────────────────────────
+// Cada vuelta pinta un fotograma y luego atiende todas las teclas que
+// ya estén en cola (p. ej. un pegado largo) antes del siguiente. Con
+// límite de fps se siguen recogiendo teclas hasta que toca pintar,
+// sin pasar más de un intervalo seguido sin actualizar la pantalla.
 void App::run() {
+    using Clock = std::chrono::steady_clock;
     while (running_) {
-        // Dibujar todo
-        menubar_->draw();
-        editor_->draw();
-        statusbar_->draw(
-            editor_->cursorRow(),
-            editor_->cursorCol(),
-            currentFile_.empty()
-                ? "[Sin título]"
-                : FileManager::basename(currentFile_),
-            editor_->isDirty(),
-            (int)editor_->getLines().size()
-        );
-
-        // Actualizar posición física del cursor al editor
-        // (ya lo hace editor_->draw() pero nos aseguramos)
-        doupdate();
-
-        // Leer tecla
+        pollLoading();
+        pollSave();
+        editor_->pollHighlight();
+        renderFrame();
+
+        // Esperar la primera tecla (sin bloquear mientras haya progreso;
+        // sin esperar mientras el resaltado de la pantalla sea provisorio)
+        timeout(editor_->highlightPending() ? 0 : editor_->isLoading() || saving_ ? 100 : -1);
         int ch = getch();
-
-        // Resize de terminal
-        if (ch == KEY_RESIZE) {
-            handleResize();
-            continue;
+        if (ch == ERR) continue;
+        handleKey(ch);
+
+        Clock::duration interval = maxFps_ > 0
+            ? Clock::duration(std::chrono::microseconds(1000000 / maxFps_))
+            : Clock::duration::zero();
+        Clock::time_point deadline = std::max(lastFrame_ + interval, Clock::now());
+        while (running_) {
+            Clock::time_point now = Clock::now();
+            if (now >= deadline + interval && maxFps_ > 0) break;
+            int waitMs = 0;
+            if (now < deadline)
+                waitMs = (int)std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+            timeout(waitMs);
+            if ((ch = getch()) == ERR) break;
+            handleKey(ch);
         }
+    }
+}
 
-        // F1 = ayuda
-        if (ch == KEY_F(1)) {
-            actionAbout();
-            continue;
-        }
+void App::pollLoading() {
+    // Incorporar lo que haya recorrido la carga en segundo plano
+    if (!editor_->isLoading()) return;
+    editor_->pollLoad();
+    if (editor_->isLoading()) {
+        int pct = (int)(editor_->loadProgress() * 100);
+        statusbar_->showMessage("Cargando... " + std::to_string(pct) +
+                                "%   [Esc] Cancelar");
+    } else {
+        statusbar_->showMessage("Carga completa: " +
+            std::to_string(editor_->lineCount()) + " líneas.");
+    }
+}
 
-        // Ctrl+S = guardar rápido
-        if (ch == ('s' & 0x1f)) { actionSave(); continue; }
-        // Ctrl+O = abrir
-        if (ch == ('o' & 0x1f)) { actionOpen(); continue; }
-        // Ctrl+N = nuevo
-        if (ch == ('n' & 0x1f)) { actionNew(); continue; }
-        // Ctrl+Q = salir
-        if (ch == ('q' & 0x1f)) { actionQuit(); continue; }
-        // Ctrl+F = buscar/reemplazar
-        if (ch == ('f' & 0x1f)) { actionFindReplace(); continue; }
-        // Ctrl+G = ir a línea
-        if (ch == ('g' & 0x1f)) { actionGotoLine(); continue; }
-
-        // F10 o ESC con menú cerrado = abrir menú
-        if (ch == KEY_F(10) || (ch == 27 && !menubar_->isOpen())) {
-            menubar_->handleInput(ch);
-            continue;
-        }
+void App::renderFrame() {
+    // El menú va después del editor: su desplegable queda encima
+    editor_->draw();
+    drawStatusBar();
+    menubar_->draw();
+    if (!menubar_->isOpen()) editor_->placeCursor();
+    doupdate();
+    lastFrame_ = std::chrono::steady_clock::now();
+}
 
-        // Si el menú está abierto, darle prioridad
-        if (menubar_->isOpen()) {
-            menubar_->handleInput(ch);
-            continue;
-        }
+void App::handleKey(int ch) {
+    // Resize de terminal
+    if (ch == KEY_RESIZE) {
+        handleResize();
+        return;
+    }
+
+    // Pegado: todo de una vez
+    if (ch == kKeyPasteBegin) { actionPaste(); return; }
+    if (ch == kKeyPasteEnd)   return;
+
+    // F1 = ayuda
+    if (ch == KEY_F(1)) {
+        actionAbout();
+        return;
+    }
+    // F6 / Shift+F6 = documento siguiente / anterior
+    if (ch == KEY_F(6))  { actionNextBuffer(); return; }
+    if (ch == KEY_F(18)) { actionPrevBuffer(); return; }
+
+    // Ctrl+S = guardar rápido
+    if (ch == ('s' & 0x1f)) { actionSave(); return; }
+    // Ctrl+O = abrir
+    if (ch == ('o' & 0x1f)) { actionOpen(); return; }
+    // Ctrl+N = nuevo
+    if (ch == ('n' & 0x1f)) { actionNew(); return; }
+    // Ctrl+Q = salir
+    if (ch == ('q' & 0x1f)) { actionQuit(); return; }
+    // Ctrl+F = buscar (incremental)
+    if (ch == ('f' & 0x1f)) { actionFind(); return; }
+    // Ctrl+R = buscar/reemplazar
+    if (ch == ('r' & 0x1f)) { actionFindReplace(); return; }
+    // Ctrl+G = ir a línea
+    if (ch == ('g' & 0x1f)) { actionGotoLine(); return; }
+    // Ctrl+T = vista de tabla
+    if (ch == ('t' & 0x1f)) { actionTable(); return; }
+    // Ctrl+W = ajuste de línea
+    if (ch == ('w' & 0x1f)) { actionWrap(); return; }
+    // Ctrl+B = lista de documentos
+    if (ch == ('b' & 0x1f)) { actionBuffers(); return; }
+    // Ctrl+Z / Ctrl+Y = deshacer / rehacer
+    if (ch == ('z' & 0x1f)) { actionUndo(); return; }
+    if (ch == ('y' & 0x1f)) { actionRedo(); return; }
+
+    // ESC durante la carga = cancelar la apertura
+    if (ch == 27 && editor_->isLoading() && !menubar_->isOpen()) {
+        cancelLoading();
+        return;
+    }
 
-        // Resto va al editor
-        editor_->handleInput(ch);
+    // F10 o ESC con menú cerrado = abrir menú
+    if (ch == KEY_F(10) || (ch == 27 && !menubar_->isOpen())) {
+        menubar_->handleInput(ch);
+        return;
     }
+
+    // Si el menú está abierto, darle prioridad
+    if (menubar_->isOpen()) {
+        menubar_->handleInput(ch);
+        return;
+    }
+
+    // Resto va al editor
+    editor_->handleInput(ch);
 }
 
 // ── Construcción de menús ─────────────────────────────────────────
@@ -109,6 +232,7 @@ void App::buildMenus() {
     archivo.items = {
         { "Nuevo",           "Ctrl+N", 0, [this]{ actionNew(); } },
         { "Abrir...",        "Ctrl+O", 0, [this]{ actionOpen(); } },
+        { "Cerrar",          "",       0, [this]{ actionClose(); } },
         { "---",             "",       0, nullptr },
         { "Guardar",         "Ctrl+S", 0, [this]{ actionSave(); } },
         { "Guardar como...", "",       0, [this]{ actionSaveAs(); } },
@@ -122,11 +246,34 @@ void App::buildMenus() {
     Menu editar;
     editar.title = "Editar";
     editar.items = {
-        { "Buscar/Reemplazar", "Ctrl+F", 0, [this]{ actionFindReplace(); } },
+        { "Deshacer",          "Ctrl+Z", 0, [this]{ actionUndo(); } },
+        { "Rehacer",           "Ctrl+Y", 0, [this]{ actionRedo(); } },
+        { "---",               "",       0, nullptr },
+        { "Buscar",            "Ctrl+F", 0, [this]{ actionFind(); } },
+        { "Buscar/Reemplazar", "Ctrl+R", 0, [this]{ actionFindReplace(); } },
         { "Ir a línea...",     "Ctrl+G", 0, [this]{ actionGotoLine(); } },
     };
     menubar_->addMenu(editar);
 
+    // ── Menú Ver ──────────────────────────────────────────────────
+    Menu ver;
+    ver.title = "Ver";
+    ver.items = {
+        { "Tabla (CSV)",     "Ctrl+T", 0, [this]{ actionTable(); } },
+        { "Ajuste de línea", "Ctrl+W", 0, [this]{ actionWrap(); } },
+    };
+    menubar_->addMenu(ver);
+
+    // ── Menú Documentos ───────────────────────────────────────────
+    Menu docs;
+    docs.title = "Documentos";
+    docs.items = {
+        { "Siguiente", "F6",       KEY_F(6),  [this]{ actionNextBuffer(); } },
+        { "Anterior",  "Shift+F6", KEY_F(18), [this]{ actionPrevBuffer(); } },
+        { "Lista...",  "Ctrl+B",   0,         [this]{ actionBuffers(); } },
+    };
+    menubar_->addMenu(docs);
+
     // ── Menú Ayuda ────────────────────────────────────────────────
     Menu ayuda;
     ayuda.title = "Ayuda";
@@ -157,38 +304,49 @@ void App::buildPluginMenu() {
 
 // ── Acciones ──────────────────────────────────────────────────────
 void App::actionNew() {
-    if (!confirmUnsaved()) return;
-    editor_->clear();
-    currentFile_   = "";
-    currentFormat_ = "txt";
+    if (!blankDocument()) {
+        size_t recovered;
+        switchTo(buffers_.add("", "txt"), recovered);
+    }
     statusbar_->showMessage("Nuevo documento creado.");
 }
 
 void App::actionOpen() {
-    if (!confirmUnsaved()) return;
-
     std::string path;
     if (!dialogFilePath("Abrir archivo", path)) return;
+    if (!openPath(path)) dialogAlert("Error", "No se pudo abrir el archivo.");
+}
 
-    std::vector<std::string> lines;
-    if (!FileManager::load(path, lines)) {
-        dialogAlert("Error", "No se pudo abrir el archivo.");
-        return;
+bool App::openPath(const std::string& path) {
+    size_t i = buffers_.find(path);
+    if (i != SIZE_MAX) {
+        switchAndReport(i);
+        return true;
     }
 
-    editor_->setLines(lines);
-    currentFile_ = path;
-
-    FileFormat fmt = FileManager::detectFormat(path);
-    switch (fmt) {
-    case FileFormat::MD:   currentFormat_ = "md";   break;
-    case FileFormat::HTML: currentFormat_ = "html"; break;
-    case FileFormat::CSV:  currentFormat_ = "csv";  break;
-    default:               currentFormat_ = "txt";  break;
+    // Un documento sin título y sin tocar se reemplaza
+    size_t prev  = buffers_.active();
+    bool   blank = blankDocument();
+    size_t recovered;
+    i = buffers_.add(path, formatOf(path));
+    if (!switchTo(i, recovered)) {
+        switchTo(prev, recovered);
+        buffers_.remove(i);
+        return false;
     }
+    if (blank) buffers_.remove(prev);
 
     pluginMgr_.notifyOpen(path);
-    statusbar_->showMessage("Archivo abierto: " + FileManager::basename(path));
+    TextEncoding enc = editor_->buffer().encoding();
+    if (recovered)
+        statusbar_->showMessage("Recuperados " + std::to_string(recovered) +
+                                " cambios sin guardar.");
+    else if (!enc.plain())
+        statusbar_->showMessage("Archivo abierto: " + FileManager::basename(path) + " (" +
+                                Transcoder::name(enc) + ")");
+    else
+        statusbar_->showMessage("Archivo abierto: " + FileManager::basename(path));
+    return true;
 }
 
 void App::actionSave() {
@@ -197,13 +355,7 @@ void App::actionSave() {
         return;
     }
     FileFormat fmt = FileManager::detectFormat(currentFile_);
-    if (!FileManager::save(currentFile_, editor_->getLines(), fmt)) {
-        dialogAlert("Error", "No se pudo guardar el archivo.");
-        return;
-    }
-    editor_->setDirty(false);
-    pluginMgr_.notifySave(currentFile_);
-    statusbar_->showMessage("Guardado: " + FileManager::basename(currentFile_));
+    startSave(currentFile_, fmt, "Guardado: ", true);
 }
 
 void App::actionSaveAs() {
@@ -211,61 +363,323 @@ void App::actionSaveAs() {
     if (!dialogFilePath("Guardar como", path)) return;
 
     FileFormat fmt = FileManager::detectFormat(path);
-    if (!FileManager::save(path, editor_->getLines(), fmt)) {
-        dialogAlert("Error", "No se pudo guardar el archivo.");
-        return;
-    }
     currentFile_ = path;
-    editor_->setDirty(false);
-    pluginMgr_.notifySave(path);
-    statusbar_->showMessage("Guardado como: " + FileManager::basename(path));
+    startSave(path, fmt, "Guardado como: ", true);
 }
 
 void App::actionSaveFormat() {
-    std::vector<std::string> formats = {
-        "TXT  - Texto plano (.txt)",
-        "MD   - Markdown (.md)",
-        "HTML - Página web (.html)",
-        "CSV  - Valores separados (.csv)"
-    };
+    // Los formatos salen del registro de exportadores
+    const std::vector<ExportFormat>& registered = ExporterRegistry::formats();
+    std::vector<std::string> formats;
+    for (const ExportFormat& f : registered) {
+        std::string ext = f.extensions.empty() ? "" : " (." + f.extensions[0] + ")";
+        formats.push_back(f.description + ext);
+    }
     int sel = 0;
     if (!dialogChoose("Elegir formato de guardado", formats, sel)) return;
-
-    // Pedir nombre de archivo
-    std::string extensions[] = { ".txt", ".md", ".html", ".csv" };
-    FileFormat fmts[] = {
-        FileFormat::TXT, FileFormat::MD,
-        FileFormat::HTML, FileFormat::CSV
-    };
+    const ExportFormat& fmt = registered[sel];
 
     std::string path = currentFile_;
     // Sugerir extensión correcta
-    if (path.empty()) path = "documento" + extensions[sel];
+    if (path.empty() && !fmt.extensions.empty()) path = "documento." + fmt.extensions[0];
 
     if (!dialogFilePath("Guardar en formato", path)) return;
 
-    if (!FileManager::save(path, editor_->getLines(), fmts[sel])) {
-        dialogAlert("Error", "No se pudo guardar.");
+    currentFile_ = path;
+    startSave(path, fmt.format, "Exportado como: ", false);
+}
+
+// ── Documentos ────────────────────────────────────────────────────
+// Todos comparten el editor: cambiar de documento estaciona el activo
+// en buffers_ y trae el otro (ver BufferList), y después se desalojan
+// los inactivos que no entren en el presupuesto de memoria. Un
+// guardado en curso termina antes: al terminar actúa sobre el diario y
+// el estado del documento activo.
+bool App::switchTo(size_t i, size_t& recovered) {
+    if (saving_) {
+        saving_->wait();
+        pollSave();
+    }
+    table_.reset();
+    savingJournal_ = false;
+    buffers_.describe(currentFile_, currentFormat_);
+    bool ok = buffers_.activate(i, *editor_, LINES - 2, recovered);
+    currentFile_   = buffers_.path(i);
+    currentFormat_ = buffers_.format(i);
+    editor_->setSyntax(currentFormat_);
+    buffers_.trim(*editor_);
+    return ok;
+}
+
+void App::switchAndReport(size_t i) {
+    size_t recovered;
+    if (!switchTo(i, recovered)) {
+        dialogAlert("Error", "No se pudo leer " + FileManager::basename(currentFile_) + ".");
         return;
     }
-    currentFile_ = path;
+    if (buffers_.changedOnDisk())
+        statusbar_->showMessage(FileManager::basename(currentFile_) +
+                                " cambió en disco: se volvió a leer.");
+    else if (recovered)
+        statusbar_->showMessage("Recuperados " + std::to_string(recovered) +
+                                " cambios sin guardar.");
+    else
+        statusbar_->showMessage("Documento " + std::to_string(i + 1) + "/" +
+                                std::to_string(buffers_.count()) + ": " +
+                                (currentFile_.empty() ? "[Sin título]"
+                                                      : FileManager::basename(currentFile_)));
+}
+
+void App::closeActive() {
+    if (saving_) {
+        saving_->wait();
+        pollSave();
+    }
+    editor_->journal().close(true);
+    size_t closing = buffers_.active();
+    if (buffers_.count() == 1) buffers_.add("", "txt");
+    size_t next = closing + 1 < buffers_.count() ? closing + 1 : closing - 1;
+    size_t recovered;
+    bool ok = switchTo(next, recovered);
+    buffers_.remove(closing);
+    if (!ok) dialogAlert("Error", "No se pudo leer " + FileManager::basename(currentFile_) + ".");
+}
+
+void App::actionClose() {
+    if (!confirmUnsaved()) return;
+    std::string name = currentFile_.empty() ? "[Sin título]" : FileManager::basename(currentFile_);
+    closeActive();
+    statusbar_->showMessage("Cerrado: " + name);
+}
+
+void App::actionNextBuffer() {
+    if (buffers_.count() < 2) {
+        statusbar_->showMessage("No hay otros documentos abiertos.");
+        return;
+    }
+    switchAndReport((buffers_.active() + 1) % buffers_.count());
+}
+
+void App::actionPrevBuffer() {
+    if (buffers_.count() < 2) {
+        statusbar_->showMessage("No hay otros documentos abiertos.");
+        return;
+    }
+    switchAndReport((buffers_.active() + buffers_.count() - 1) % buffers_.count());
+}
+
+void App::actionBuffers() {
+    buffers_.describe(currentFile_, currentFormat_);
+    std::vector<std::string> names;
+    for (size_t i = 0; i < buffers_.count(); ++i) {
+        const std::string& path = buffers_.path(i);
+        std::string name = path.empty() ? "[Sin título]" : FileManager::basename(path);
+        if (i == buffers_.active() ? editor_->isDirty() : buffers_.dirty(i)) name += " *";
+        if (!buffers_.resident(i)) name += "  (en disco)";
+        names.push_back(name);
+    }
+    int sel = (int)buffers_.active();
+    std::string title = "Documentos (" + megabytes(buffers_.memoryBytes(*editor_)) + " de " +
+                        megabytes(buffers_.budget()) + ")";
+    if (!dialogChoose(title, names, sel)) return;
+    switchAndReport((size_t)sel);
+}
+
+// ── Guardado en segundo plano ─────────────────────────────────────
+// El documento se da por guardado al tomar la instantánea: lo que se
+// edite mientras el hilo escribe vuelve a marcarlo como modificado.
+void App::startSave(const std::string& path, FileFormat fmt,
+                    const std::string& doneMsg, bool notify) {
+    // Un guardado a la vez: el anterior termina primero
+    if (saving_) {
+        saving_->wait();
+        pollSave();
+    }
+    saving_        = FileManager::saveAsync(path, editor_->buffer(), fmt, fsyncPolicy_);
+    savingMsg_     = doneMsg;
+    savingNotify_  = notify;
+    savingJournal_ = true;
+    savingRaw_     = ExporterRegistry::isRaw(fmt);
+    savingMark_    = editor_->journal().mark();
     editor_->setDirty(false);
-    statusbar_->showMessage("Exportado como: " + FileManager::basename(path));
+    statusbar_->showMessage("Guardando " + FileManager::basename(path) + "...");
+}
+
+void App::pollSave() {
+    if (!saving_) return;
+    if (!saving_->done()) {
+        int pct = (int)(saving_->progress() * 100);
+        statusbar_->showMessage("Guardando " + FileManager::basename(saving_->path()) +
+                                "... " + std::to_string(pct) + "%");
+        return;
+    }
+    saving_->wait();
+    std::unique_ptr<SaveWorker> done = std::move(saving_);
+    if (!done->ok()) {
+        if (done->path() == currentFile_) editor_->setDirty(true);
+        dialogAlert("Error al guardar", done->error());
+        return;
+    }
+    // Lo guardado ya no hace falta en el diario. Una exportación
+    // (HTML, CSV) no es el documento: no sirve de base y se deja de registrar.
+    if (savingJournal_ && done->path() == currentFile_) {
+        if (savingRaw_) editor_->journal().rebase(savingMark_, done->path());
+        else            editor_->journal().close(true);
+        buffers_.noteSaved(done->path(), savingRaw_);
+    }
+    if (savingNotify_) pluginMgr_.notifySave(done->path());
+    statusbar_->showMessage(savingMsg_ + FileManager::basename(done->path()));
+}
+
+// ── Deshacer / rehacer ────────────────────────────────────────────
+void App::actionUndo() {
+    if (!editor_->undo()) statusbar_->showMessage("Nada para deshacer.");
+}
+
+void App::actionRedo() {
+    if (!editor_->redo()) statusbar_->showMessage("Nada para rehacer.");
 }
 
+// ── Búsqueda incremental ──────────────────────────────────────────
+// Cada tecla refina la búsqueda y salta a la primera coincidencia desde
+// donde estaba el cursor. [Abajo]/[Arriba] recorren las coincidencias,
+// [Enter] deja el cursor en la actual, [Esc] lo devuelve a su lugar y
+// [Ctrl+R] pasa a reemplazar con la consulta escrita.
 void App::actionFind() {
-    actionFindReplace();
+    editor_->loadAll();
+
+    IncrementalSearch search;
+    std::string query;
+    const uint64_t origin  = editor_->cursorOffset();
+    uint64_t       current = origin;   // offset de la coincidencia actual
+    bool           found   = false;
+
+    // Coincidencia en `at` o la siguiente (dando la vuelta al final)
+    auto select = [&](uint64_t at) {
+        const IncrementalSearch::Matches& m = search.matches();
+        found = !m.empty();
+        if (!found) {
+            editor_->setCursorOffset(origin);
+            return;
+        }
+        auto it = std::lower_bound(m.begin(), m.end(), at);
+        current = it != m.end() ? *it : m.front();
+        editor_->setCursorOffset(current);
+    };
+
+    auto refresh = [&] {
+        // Mayúsculas "inteligentes": distingue sólo si la consulta las tiene
+        bool cs = std::any_of(query.begin(), query.end(),
+                              [](char c) { return std::isupper((unsigned char)c); });
+        uint64_t from, to;
+        editor_->visibleRange(from, to);
+        TrigramIndex::Ranges ranges;
+        bool indexed = editor_->searchRanges(query, ranges);
+        search.update(editor_->buffer(), query, cs, from, to, indexed ? &ranges : nullptr);
+        select(origin);
+    };
+
+    bool accept = false;
+    for (;;) {
+        // Pintar: editor con las coincidencias y la consulta en la barra
+        editor_->setHighlights(&search.matches(), query.size());
+        menubar_->draw();
+        editor_->draw();
+
+        const IncrementalSearch::Matches& m = search.matches();
+        std::string info;
+        if (!query.empty()) {
+            if (found) {
+                size_t idx = std::lower_bound(m.begin(), m.end(), current) - m.begin();
+                info = std::to_string(idx + 1) + "/" + std::to_string(m.size());
+            } else {
+                info = "Sin coincidencias";
+            }
+            if (!search.done())
+                info += "+ (" + std::to_string((int)(search.progress() * 100)) + "%)";
+        }
+        info += "  [Enter] Ir  [Esc] Cancelar";
+        statusbar_->drawPrompt("Buscar:", query, info);
+        doupdate();
+
+        // Mientras el hilo trabaja se despierta para recoger su resultado
+        timeout(search.done() ? -1 : 30);
+        int ch = getch();
+        if (ch == ERR) {
+            if (search.poll()) select(found ? current : origin);
+            continue;
+        }
+
+        bool changed = false;
+        if (ch == 27) break;
+        if (ch == '\n' || ch == KEY_ENTER) { accept = true; break; }
+        if (ch == ('r' & 0x1f)) {
+            editor_->setHighlights(nullptr, 0);
+            timeout(-1);
+            actionFindReplace(query);
+            return;
+        }
+        switch (ch) {
+        case KEY_DOWN:
+            if (found) select(current + 1);
+            break;
+        case KEY_UP:
+            if (found) {
+                auto it = std::lower_bound(m.begin(), m.end(), current);
+                current = it == m.begin() ? m.back() : *(it - 1);
+                editor_->setCursorOffset(current);
+            }
+            break;
+        case KEY_BACKSPACE: case 127: case '\b':
+            if (!query.empty()) { query.pop_back(); changed = true; }
+            break;
+        case KEY_RESIZE:
+            handleResize();
+            break;
+        default:
+            if (ch >= 32 && ch < 256) { query += (char)ch; changed = true; }
+            break;
+        }
+        if (!changed) continue;
+
+        // Si ya hay más teclas esperando, buscar sólo con la última consulta
+        timeout(0);
+        int next = getch();
+        if (next != ERR) {
+            ungetch(next);
+            continue;
+        }
+        refresh();
+    }
+
+    editor_->setHighlights(nullptr, 0);
+    timeout(-1);
+    if (!accept || !found) editor_->setCursorOffset(origin);
 }
 
-void App::actionFindReplace() {
+void App::actionFindReplace(const std::string& needle) {
     FindReplaceParams p;
+    p.needle = needle;
     if (!dialogFindReplace(p)) return;
     if (p.needle.empty()) return;
+    // Reemplazar todo no puede dejar sin tocar lo que falta cargar
+    if (p.replaceAll && !waitForLoad("Reemplazar todo")) {
+        statusbar_->showMessage("Reemplazo cancelado: la carga sigue en curso.");
+        return;
+    }
 
     int count = editor_->findReplace(
-        p.needle, p.replacement, p.caseSensitive, p.replaceAll);
-
-    if (count == 0) {
+        p.needle, p.replacement, p.caseSensitive, p.replaceAll, p.regex,
+        [this](double done) {
+            statusbar_->showMessage("Reemplazando... " +
+                                    std::to_string((int)(done * 100)) + "%");
+            drawStatusBar();
+            doupdate();
+        });
+
+    if (count < 0) {
+        dialogAlert(p.regex ? "Expresión inválida" : "No se pudo reemplazar", editor_->lastError());
+    } else if (count == 0) {
         statusbar_->showMessage("No se encontró: " + p.needle);
     } else {
         statusbar_->showMessage(
@@ -273,13 +687,183 @@ void App::actionFindReplace() {
     }
 }
 
+// El contenido pegado todavía está en el tty (ncurses lee de a un byte
+// y sólo lo que necesita): se lee directamente en bloques grandes hasta
+// el marcador de fin. Lo que llegue detrás vuelve a la cola de getch.
+void App::actionPaste() {
+    std::string text;
+    std::string rest;
+    std::vector<char> chunk(1 << 16);
+    const size_t markLen = sizeof(kPasteEnd) - 1;
+    for (;;) {
+        struct pollfd pfd = { STDIN_FILENO, POLLIN, 0 };
+        if (poll(&pfd, 1, kPasteTimeoutMs) <= 0) break;
+        ssize_t n = read(STDIN_FILENO, chunk.data(), chunk.size());
+        if (n <= 0) break;
+        size_t from = text.size() > markLen ? text.size() - markLen : 0;
+        text.append(chunk.data(), (size_t)n);
+        size_t end = text.find(kPasteEnd, from);
+        if (end != std::string::npos) {
+            rest = text.substr(end + markLen);
+            text.resize(end);
+            break;
+        }
+    }
+    for (auto it = rest.rbegin(); it != rest.rend(); ++it) ungetch((unsigned char)*it);
+
+    if (menubar_->isOpen()) return;
+    editor_->pasteText(text);
+}
+
 void App::actionGotoLine() {
     int target = editor_->cursorRow() + 1;
-    int maxLine = (int)editor_->getLines().size();
+    int maxLine = editor_->lineCount();
     if (!dialogGotoLine(maxLine, target)) return;
     editor_->gotoLine(target);
 }
 
+// ── Vista de tabla ────────────────────────────────────────────────
+// Modal y de solo lectura, sobre una instantánea: el índice se arma en
+// un hilo (Esc lo cancela) y se conserva mientras el documento no
+// cambie. Enter deja el cursor del editor en la celda elegida.
+void App::actionTable() {
+    TextSnapshot snap = editor_->buffer().snapshot(true);
+    if (!table_ || !table_->snapshot().sameSpans(snap)) {
+        table_.reset();
+        auto table = std::make_unique<CsvTable>();
+        char delim = CsvTable::detectDelimiter(snap);
+        std::atomic<uint64_t> scanned{ 0 };
+        std::atomic<bool>     cancel{ false }, finished{ false };
+        bool built = false;
+        std::thread worker([&] {
+            built = table->build(snap, delim, &scanned, &cancel);
+            finished = true;
+        });
+        while (!finished) {
+            int pct = snap.size() ? (int)(scanned * 100 / snap.size()) : 100;
+            statusbar_->drawPrompt("Tabla:", "", "Indexando... " + std::to_string(pct) +
+                                   "%  [Esc] Cancelar");
+            doupdate();
+            timeout(50);
+            if (getch() == 27) cancel = true;
+        }
+        worker.join();
+        timeout(-1);
+        if (!built) {
+            statusbar_->showMessage("Vista de tabla cancelada.");
+            return;
+        }
+        table_ = std::move(table);
+    }
+    if (table_->rowCount() == 0) {
+        statusbar_->showMessage("El documento está vacío.");
+        return;
+    }
+
+    CsvTable& table = *table_;
+    table.resetView();
+    TableView view(1, 0, LINES - 2, COLS);
+    view.setTable(&table);
+    size_t sortCol  = SIZE_MAX;
+    bool   sortDesc = false;
+    curs_set(0);
+
+    // Texto de la cabecera de una columna
+    auto header = [&](size_t col) {
+        CsvTable::Field f;
+        return table.field(0, col, f) ? table.text(f, 64) : std::string();
+    };
+    // Operaciones largas: aviso antes de bloquear
+    auto busy = [&](const std::string& msg) {
+        statusbar_->drawPrompt("Tabla:", "", msg);
+        doupdate();
+    };
+
+    for (;;) {
+        menubar_->draw();
+        view.draw();
+        size_t col = view.cursorCol();
+        std::string where;
+        if (table.viewCount() > 0)
+            where = "fila " + std::to_string(table.viewRow(view.cursorRow()) + 1) + " (" +
+                    std::to_string(view.cursorRow() + 1) + "/" +
+                    std::to_string(table.viewCount()) + ")";
+        else
+            where = "sin filas";
+        where += "  col " + std::to_string(col + 1) + "/" +
+                 std::to_string(table.columnCount()) + " " + header(col);
+        statusbar_->drawPrompt("Tabla:", where,
+            "[s] Ordenar [f] Filtrar [c] Columna [r] Todo [Enter] Ir [Esc] Salir");
+        doupdate();
+
+        int ch = getch();
+        if (view.handleInput(ch)) continue;
+        if (ch == 27 || ch == 'q' || ch == ('t' & 0x1f)) break;
+
+        if (ch == '\n' || ch == KEY_ENTER) {
+            if (table.viewCount() > 0) {
+                size_t row = table.viewRow(view.cursorRow());
+                CsvTable::Field f;
+                editor_->setCursorOffset(table.field(row, col, f) ? f.offset
+                                                                  : table.rowOffset(row));
+            }
+            break;
+        }
+
+        switch (ch) {
+        case 's': case 'S':
+            sortDesc = (sortCol == col) ? !sortDesc : false;
+            sortCol  = col;
+            busy("Ordenando por " + header(col) + "...");
+            table.sortBy(col, sortDesc);
+            view.gotoRow(0);
+            break;
+        case 'f': case 'F': {
+            std::string needle;
+            if (!dialogInput("Filtrar", "\"" + header(col) + "\" contiene:", needle) ||
+                needle.empty())
+                break;
+            busy("Filtrando...");
+            table.filterBy(col, needle);
+            view.gotoRow(0);
+            break;
+        }
+        case 'r': case 'R':
+            table.resetView();
+            sortCol = SIZE_MAX;
+            view.gotoRow(0);
+            break;
+        case 'c': case 'C': {
+            std::string name;
+            if (!dialogInput("Ir a columna", "Número o nombre:", name) || name.empty()) break;
+            if (std::all_of(name.begin(), name.end(), ::isdigit)) {
+                view.gotoColumn((size_t)std::max(1L, atol(name.c_str())) - 1);
+                break;
+            }
+            // Por nombre de cabecera, sin distinguir mayúsculas
+            auto lower = [](std::string s) {
+                std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+                return s;
+            };
+            std::string want = lower(name);
+            for (size_t c = 0; c < table.columnCount(); ++c) {
+                if (lower(header(c)).compare(0, want.size(), want) == 0) {
+                    view.gotoColumn(c);
+                    break;
+                }
+            }
+            break;
+        }
+        case KEY_RESIZE:
+            handleResize();
+            view.resize(1, 0, LINES - 2, COLS);
+            break;
+        }
+    }
+    table.resetView();
+    curs_set(1);
+}
+
 void App::actionAbout() {
     dialogAlert("Acerca de NotepadTUI",
         "NotepadTUI v1.0\n"
@@ -288,21 +872,99 @@ void App::actionAbout() {
         "  Ctrl+N Nuevo    Ctrl+O Abrir\n"
         "  Ctrl+S Guardar  Ctrl+Q Salir\n"
         "  Ctrl+F Buscar   Ctrl+G Ir a línea\n"
+        "  Ctrl+Z Deshacer Ctrl+Y Rehacer\n"
+        "  Ctrl+T Tabla    Ctrl+W Ajuste de línea\n"
+        "  F6     Siguiente documento\n"
+        "  Ctrl+B Lista de documentos\n"
         "  F10    Menú");
 }
 
+void App::actionWrap() {
+    editor_->setWrap(!editor_->wrap());
+    statusbar_->showMessage(editor_->wrap() ? "Ajuste de línea activado."
+                                            : "Ajuste de línea desactivado.");
+}
+
 void App::actionQuit() {
-    if (!confirmUnsaved()) return;
+    // Si el guardado en curso falla, el documento vuelve a estar sin guardar
+    if (saving_) {
+        saving_->wait();
+        pollSave();
+    }
+    size_t dirty = editor_->isDirty() ? 1 : 0;
+    for (size_t i = 0; i < buffers_.count(); ++i)
+        if (i != buffers_.active() && buffers_.dirty(i)) ++dirty;
+    if (dirty > 1 &&
+        !dialogConfirm("Cambios sin guardar", "Hay " + std::to_string(dirty) +
+                       " documentos con cambios sin guardar. ¿Continuar y descartar?"))
+        return;
+    if (dirty == 1 && !dialogConfirm("Cambios sin guardar",
+                                     "Hay cambios sin guardar. ¿Continuar y descartar?"))
+        return;
+    editor_->journal().close(true);
+    buffers_.discardJournals();
     running_ = false;
 }
 
 // ── Helpers ───────────────────────────────────────────────────────
+bool App::blankDocument() const {
+    return currentFile_.empty() && !editor_->isDirty() && editor_->buffer().size() == 0;
+}
+
 bool App::confirmUnsaved() {
     if (!editor_->isDirty()) return true;
     return dialogConfirm("Cambios sin guardar",
         "Hay cambios sin guardar. ¿Continuar y descartar?");
 }
 
+void App::cancelLoading() {
+    if (!dialogConfirm("Carga en curso",
+            "¿Cancelar la apertura de " + FileManager::basename(currentFile_) + "?"))
+        return;
+    editor_->cancelLoad();
+    closeActive();
+    statusbar_->showMessage("Apertura cancelada.");
+}
+
+// Espera a que termine la carga en segundo plano mostrando el avance.
+// [Esc] deja de esperar (la carga sigue) y devuelve false.
+bool App::waitForLoad(const std::string& what) {
+    bool ok = true;
+    timeout(kWaitPollMs);
+    while (editor_->isLoading()) {
+        editor_->pollLoad();
+        int pct = (int)(editor_->loadProgress() * 100);
+        statusbar_->showMessage(what + ": esperando la carga... " + std::to_string(pct) +
+                                "%   [Esc] Cancelar");
+        drawStatusBar();
+        doupdate();
+        int ch = getch();
+        if (ch == 27) {
+            ok = false;
+            break;
+        }
+        if (ch == KEY_RESIZE) handleResize();
+    }
+    timeout(-1);
+    return ok;
+}
+
+void App::drawStatusBar() {
+    // Con varios documentos, cuál es el activo
+    std::string name = currentFile_.empty() ? "[Sin título]" : FileManager::basename(currentFile_);
+    if (buffers_.count() > 1)
+        name += " [" + std::to_string(buffers_.active() + 1) + "/" +
+                std::to_string(buffers_.count()) + "]";
+    statusbar_->draw(
+        editor_->cursorRow(),
+        editor_->cursorColumn(),
+        name,
+        editor_->isDirty(),
+        editor_->lineCount(),
+        editor_->isFullyLoaded()
+    );
+}
+
 void App::handleResize() {
     endwin();
     refresh();
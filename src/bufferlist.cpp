@@ -0,0 +1,383 @@
+#include "bufferlist.h"
+#include "filemanager.h"
+#include "journal.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Los temporales se escriben de a kSpillChunk bytes
+static const size_t kSpillChunk = 1u << 20;
+
+// ── Helpers internos ──────────────────────────────────────────────
+// Temporal de desalojo: se escribe con búfer y al terminar se mapea y
+// se borra su nombre (el mapeo lo mantiene vivo). Si algo falla no
+// queda nada en disco.
+class SpillFile {
+public:
+    SpillFile() {
+        const char* dir = getenv("TMPDIR");
+        path_ = std::string(dir && *dir ? dir : "/tmp") + "/notepad-spill-XXXXXX";
+        fd_   = mkstemp(&path_[0]);
+        ok_   = fd_ >= 0;
+    }
+    ~SpillFile() {
+        if (fd_ < 0) return;
+        ::close(fd_);
+        ::unlink(path_.c_str());
+    }
+
+    void put(const char* p, size_t n) {
+        if (buf_.size() + n > kSpillChunk) flush();
+        if (n >= kSpillChunk) write(p, n);
+        else buf_.append(p, n);
+    }
+    void putVarint(uint64_t v) {
+        char b[10];
+        size_t n = 0;
+        while (v >= 0x80) {
+            b[n++] = (char)((v & 0x7f) | 0x80);
+            v >>= 7;
+        }
+        b[n++] = (char)v;
+        put(b, n);
+    }
+
+    std::shared_ptr<MappedFile> finish(const TextEncoding& encoding) {
+        flush();
+        if (!ok_) return nullptr;
+        return MappedFile::open(path_, encoding);   // el destructor borra el nombre
+    }
+
+private:
+    std::string path_;
+    std::string buf_;
+    int  fd_;
+    bool ok_;
+
+    void flush() {
+        write(buf_.data(), buf_.size());
+        buf_.clear();
+    }
+    void write(const char* p, size_t n) {
+        while (ok_ && n > 0) {
+            ssize_t w = ::write(fd_, p, n);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) {
+                ok_ = false;
+                break;
+            }
+            p += w;
+            n -= (size_t)w;
+        }
+    }
+};
+
+static bool getVarint(const char* p, size_t n, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && pos < n; shift += 7) {
+        unsigned char b = (unsigned char)p[pos++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// Ediciones que llevan del original mapeado al documento, como en el
+// diario (offset y bytes quitados del original, texto puesto). Los
+// tramos del original que siguen en orden se conservan; lo demás es
+// texto puesto.
+static std::shared_ptr<MappedFile> spillEdits(const TextSnapshot& snap) {
+    SpillFile out;
+    const MappedFile& orig = *snap.original();
+    uintptr_t base = (uintptr_t)orig.data();
+    uint64_t  pos  = 0;   // hasta dónde se recorrió el original
+    std::vector<std::pair<const char*, size_t>> text;
+    uint64_t  textLen = 0;
+
+    auto flush = [&](uint64_t upTo) {
+        if (upTo == pos && textLen == 0) return;
+        out.putVarint(pos);
+        out.putVarint(upTo - pos);
+        out.putVarint(textLen);
+        for (const auto& t : text) out.put(t.first, t.second);
+        text.clear();
+        textLen = 0;
+    };
+    snap.forEachSpanWhile(0, snap.size(), [&](const char* p, size_t n) {
+        uint64_t at = (uint64_t)((uintptr_t)p - base);
+        if ((uintptr_t)p >= base && at >= pos && at + n <= orig.size()) {
+            flush(at);
+            pos = at + n;
+        } else {
+            text.push_back({ p, n });
+            textLen += n;
+        }
+        return true;
+    });
+    flush(orig.size());
+    return out.finish(TextEncoding());
+}
+
+static bool readEdits(const MappedFile& file, std::vector<TextEdit>& out) {
+    const char* p = file.data();
+    size_t      n = file.size();
+    size_t      pos = 0;
+    while (pos < n) {
+        uint64_t offset, removed, len;
+        if (!getVarint(p, n, pos, offset) || !getVarint(p, n, pos, removed) ||
+            !getVarint(p, n, pos, len) || len > n - pos)
+            return false;
+        out.push_back({ offset, removed, std::string(p + pos, (size_t)len) });
+        pos += (size_t)len;
+    }
+    return true;
+}
+
+// El documento entero, que pasa a ser su propio original
+static std::shared_ptr<MappedFile> spillText(const TextSnapshot& snap) {
+    SpillFile out;
+    snap.forEachSpanWhile(0, snap.size(), [&](const char* p, size_t n) {
+        out.put(p, n);
+        return true;
+    });
+    return out.finish(snap.original() ? snap.original()->encoding() : TextEncoding());
+}
+
+// Carga perezosa: las filas a la vista enseguida y el resto en segundo
+// plano si es grande (como FileManager::load)
+static void startLoad(TextBuffer& buf, int rows) {
+    buf.ensureLines(rows);
+    if (buf.fullyLoaded()) return;
+    if (buf.size() + buf.pendingTail().size() >= FileManager::kLazyThreshold)
+        buf.startBackgroundLoad();
+    else
+        buf.loadAll();
+}
+
+static int64_t mtimeNs(const struct stat& st) {
+    return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+// ── Constructor ───────────────────────────────────────────────────
+// Siempre hay al menos un documento: el del editor al empezar
+BufferList::BufferList()
+    : active_(0), budget_(kDefaultBudget), clock_(0), changed_(false)
+{
+    docs_.emplace_back();
+}
+
+// ── Lista ─────────────────────────────────────────────────────────
+size_t BufferList::find(const std::string& path) const {
+    for (size_t i = 0; i < docs_.size(); ++i)
+        if (!path.empty() && docs_[i].path == path) return i;
+    return SIZE_MAX;
+}
+
+size_t BufferList::add(const std::string& path, const std::string& format) {
+    docs_.emplace_back();
+    Document& d = docs_.back();
+    d.path      = path;
+    d.format    = format;
+    d.journaled = !path.empty();
+    d.form      = path.empty() ? Form::Mapped : Form::Reload;
+    return docs_.size() - 1;
+}
+
+void BufferList::describe(const std::string& path, const std::string& format) {
+    docs_[active_].path   = path;
+    docs_[active_].format = format;
+}
+
+void BufferList::noteSaved(const std::string& path, bool raw) {
+    docs_[active_].disk = raw ? diskId(path) : DiskId();
+}
+
+void BufferList::remove(size_t i) {
+    if (i == active_) return;
+    docs_.erase(docs_.begin() + i);
+    if (i < active_) --active_;
+}
+
+void BufferList::discardJournals() {
+    for (size_t i = 0; i < docs_.size(); ++i) {
+        const Document& d = docs_[i];
+        bool read = d.form != Form::Reload || d.disk.valid;   // desalojado tras leerlo
+        if (i != active_ && d.journaled && read) Journal::discard(d.path);
+    }
+}
+
+// ── Activar ───────────────────────────────────────────────────────
+bool BufferList::activate(size_t i, Editor& ed, int rows, size_t& recovered) {
+    recovered = 0;
+    changed_  = false;
+    if (i == active_) return true;
+
+    Document& cur = docs_[active_];
+    cur.journaled = ed.journal().active();
+    ed.journal().close(false);
+    ed.park(cur.state);
+    cur.form = Form::Resident;
+    active_  = i;
+
+    Document& d = docs_[i];
+    d.lastUse = ++clock_;
+    bool ok = rebuild(d, std::max(d.state.curRow, d.state.viewRow) + rows, recovered);
+    ed.unpark(std::move(d.state));
+    d.state = Editor::Parked();
+    d.form  = Form::Resident;
+    if (d.journaled && !d.path.empty()) ed.journal().open(d.path);
+    return ok;
+}
+
+// De la forma desalojada a state.buf
+bool BufferList::rebuild(Document& d, int rows, size_t& recovered) {
+    bool ok = true;
+    switch (d.form) {
+    case Form::Resident:
+        return true;
+    case Form::Mapped:
+        d.state.buf = TextBuffer(d.file, true);
+        startLoad(d.state.buf, rows);
+        break;
+    case Form::Patched: {
+        // Las ediciones van en orden: basta con tener indexado el
+        // original hasta donde termina la última. Lo que sigue se carga
+        // como al abrir.
+        TextBuffer buf(d.file, true);
+        std::vector<TextEdit> edits;
+        ok = readEdits(*d.edits, edits);
+        if (ok && !edits.empty()) {
+            buf.ensureLoaded(edits.back().offset + edits.back().length);
+            buf.applyEdits(edits);
+        }
+        startLoad(buf, rows);
+        d.state.buf = std::move(buf);
+        break;
+    }
+    case Form::Reload: {
+        // Desalojado (disk válido): el archivo era el documento. Si otro
+        // programa lo cambió desde entonces, lo que se lee es otro texto
+        // y el historial ya no le corresponde.
+        DiskId before = diskId(d.path);
+        TextBuffer buf;
+        ok = FileManager::load(d.path, buf, LoadMode::Lazy);
+        if (ok) {
+            bool steady = sameFile(before, diskId(d.path));   // no cambió durante la lectura
+            if (d.disk.valid && !(steady && sameFile(before, d.disk))) {
+                d.state.undo.clear();
+                changed_ = true;
+            }
+            d.disk    = steady ? before : DiskId();
+            recovered = Journal::replay(d.path, buf);
+            if (recovered) d.state.dirty = true;
+            startLoad(buf, rows);
+        }
+        d.state.buf = std::move(buf);
+        break;
+    }
+    }
+    d.file.reset();
+    d.edits.reset();
+    return ok;
+}
+
+// ── Identidad en disco ────────────────────────────────────────────
+BufferList::DiskId BufferList::diskId(const std::string& path) {
+    DiskId id;
+    struct stat st;
+    if (path.empty() || stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return id;
+    id.valid   = true;
+    id.dev     = st.st_dev;
+    id.ino     = st.st_ino;
+    id.size    = (uint64_t)st.st_size;
+    id.mtimeNs = mtimeNs(st);
+    return id;
+}
+
+bool BufferList::sameFile(const DiskId& a, const DiskId& b) {
+    return a.valid && b.valid && a.dev == b.dev && a.ino == b.ino &&
+           a.size == b.size && a.mtimeNs == b.mtimeNs;
+}
+
+// ── Presupuesto de memoria ────────────────────────────────────────
+size_t BufferList::docBytes(const Document& d) const {
+    size_t bytes = d.state.undo.memoryBytes();
+    if (d.state.index) bytes += d.state.index->memoryBytes();
+    if (d.form == Form::Resident) bytes += d.state.buf.memoryBytes();
+    return bytes;
+}
+
+size_t BufferList::memoryBytes(const Editor& ed) const {
+    size_t bytes = ed.memoryBytes();
+    for (size_t i = 0; i < docs_.size(); ++i)
+        if (i != active_) bytes += docBytes(docs_[i]);
+    return bytes;
+}
+
+// Primero los que no tienen cambios (soltarlos no cuesta nada), de a
+// uno y del usado hace más tiempo
+size_t BufferList::trim(const Editor& ed) {
+    size_t total   = memoryBytes(ed);
+    size_t evicted = 0;
+    for (int pass = 0; pass < 2 && total > budget_; ++pass) {
+        std::vector<size_t> order;
+        for (size_t i = 0; i < docs_.size(); ++i)
+            if (i != active_ && docs_[i].form == Form::Resident &&
+                docs_[i].state.dirty == (pass == 1))
+                order.push_back(i);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return docs_[a].lastUse < docs_[b].lastUse;
+        });
+        for (size_t i : order) {
+            if (total <= budget_) break;
+            size_t before = docBytes(docs_[i]);
+            if (!evict(docs_[i])) continue;
+            total -= before - docBytes(docs_[i]);
+            ++evicted;
+        }
+    }
+    return evicted;
+}
+
+bool BufferList::evict(Document& d) {
+    TextBuffer& buf = d.state.buf;
+    if (buf.backgroundLoading()) return false;
+
+    TextSnapshot snap = buf.snapshot(true);
+    const std::shared_ptr<const MappedFile>& orig = snap.original();
+    bool mapped = orig && !orig->inMemory();
+    std::vector<std::pair<uint64_t, uint64_t>> changed;
+    bool same = orig ? snap.size() == orig->size() && snap.patchRanges(changed) && changed.empty()
+                     : snap.size() == 0;
+
+    std::shared_ptr<const MappedFile> file, edits;
+    Form form;
+    if (same && (mapped || !orig)) {
+        file = orig;
+        form = Form::Mapped;
+    } else if (!d.state.dirty && d.disk.valid && sameFile(d.disk, diskId(d.path))) {
+        // Lo que hay en disco es el documento (leído o guardado tal
+        // cual, sin cambios ajenos): historial y diario siguen valiendo
+        form = Form::Reload;
+    } else if (mapped) {
+        if (!(edits = spillEdits(snap))) return false;
+        file = orig;
+        form = Form::Patched;
+    } else {
+        if (!(file = spillText(snap))) return false;
+        form = Form::Mapped;
+    }
+
+    d.state.index.reset();   // se rehace al volver
+    d.form  = form;
+    d.file  = file;
+    d.edits = edits;
+    buf     = TextBuffer();
+    snap    = TextSnapshot();
+    if (file) file->release();
+    return true;
+}
@@ -0,0 +1,337 @@
+#include "columnmap.h"
+#include "textbuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <wchar.h>
+
+static const uint32_t kReplacement = 0xFFFD;
+static const uint64_t kOnes = 0x0101010101010101ull;
+static const uint64_t kHigh = 0x8080808080808080ull;
+
+// ── Helpers internos ──────────────────────────────────────────────
+static inline bool plainByte(unsigned char c) {
+    return c >= 0x20 && c < 0x7f;
+}
+
+// Los 8 bytes son ASCII imprimible: ninguno menor que 0x20 ni mayor
+// que 0x7e (comparaciones por byte dentro de una palabra)
+static inline bool plain8(const char* p) {
+    uint64_t x;
+    memcpy(&x, p, 8);
+    uint64_t below = (x - kOnes * 0x20) & ~x & kHigh;
+    uint64_t above = ((x + kOnes) | x) & kHigh;
+    return (below | above) == 0;
+}
+
+// wcwidth de todo el plano básico, calculado una vez; -1 si no se
+// puede pintar
+static int rawWidth(uint32_t cp) {
+    static const std::vector<int8_t> table = [] {
+        std::vector<int8_t> t(0x10000);
+        for (uint32_t c = 0; c < t.size(); ++c) t[c] = (int8_t)wcwidth((wchar_t)c);
+        return t;
+    }();
+    return cp < table.size() ? table[cp] : wcwidth((wchar_t)cp);
+}
+
+// ── Constructor ───────────────────────────────────────────────────
+ColumnMap::ColumnMap(const TextBuffer& buf) : buf_(buf), lineCount_(0) {}
+
+// ── Caracteres ────────────────────────────────────────────────────
+uint32_t ColumnMap::decode(const char* p, size_t n, int& len) {
+    const unsigned char* s = (const unsigned char*)p;
+    len = 1;
+    if (s[0] < 0x80) return s[0];
+
+    int      need;
+    uint32_t cp, min;
+    if (s[0] >= 0xC2 && s[0] <= 0xDF)      { need = 1; cp = s[0] & 0x1F; min = 0x80; }
+    else if (s[0] >= 0xE0 && s[0] <= 0xEF) { need = 2; cp = s[0] & 0x0F; min = 0x800; }
+    else if (s[0] >= 0xF0 && s[0] <= 0xF4) { need = 3; cp = s[0] & 0x07; min = 0x10000; }
+    else return kReplacement;
+
+    if ((size_t)need >= n) return kReplacement;
+    for (int i = 1; i <= need; ++i) {
+        if ((s[i] & 0xC0) != 0x80) return kReplacement;
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    // Sin formas largas, sustitutos ni más allá de U+10FFFF
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return kReplacement;
+    len = need + 1;
+    return cp;
+}
+
+int ColumnMap::charWidth(uint32_t cp) {
+    if (cp >= 0x20 && cp < 0x7f) return 1;
+    if (cp == '\t') return kTabWidth;
+    if (cp < 0x20 || cp == 0x7f) return 2;   // ^X
+    int w = rawWidth(cp);
+    return w < 0 ? 1 : w;                    // U+FFFD
+}
+
+bool ColumnMap::printable(uint32_t cp) {
+    if (cp < 0x80) return plainByte((unsigned char)cp);
+    return rawWidth(cp) >= 0;
+}
+
+uint64_t ColumnMap::columns(const char* p, size_t n) {
+    uint64_t cols = 0;
+    size_t   i    = 0;
+    while (i < n) {
+        while (i + 8 <= n && plain8(p + i)) {
+            i    += 8;
+            cols += 8;
+        }
+        if (i >= n) break;
+        if (plainByte((unsigned char)p[i])) {
+            ++i;
+            ++cols;
+            continue;
+        }
+        int len;
+        cols += charWidth(decode(p + i, n - i, len));
+        i    += len;
+    }
+    return cols;
+}
+
+bool ColumnMap::plain(const char* p, size_t n) {
+    size_t i = 0;
+    while (i + 8 <= n && plain8(p + i)) i += 8;
+    for (; i < n; ++i)
+        if (!plainByte((unsigned char)p[i])) return false;
+    return true;
+}
+
+// ── Caché por línea ───────────────────────────────────────────────
+void ColumnMap::reset() {
+    lines_.clear();
+    lineCount_ = buf_.lineCount();
+}
+
+// La carga perezosa agrega líneas al final sin pasar por noteEdit: la
+// que era la última pudo completarse
+void ColumnMap::sync() {
+    int n = buf_.lineCount();
+    if (n == lineCount_) return;
+    lines_.erase(lineCount_ - 1);
+    lineCount_ = n;
+}
+
+const ColumnMap::Line& ColumnMap::line(int row) {
+    sync();
+    auto it = lines_.find(row);
+    if (it != lines_.end()) return it->second;
+
+    if (lines_.size() >= kMaxLines) {
+        // Primero las que no tienen puntos: medirlas de nuevo es barato
+        for (auto i = lines_.begin(); i != lines_.end();)
+            i = i->second.marks.size() <= 1 ? lines_.erase(i) : std::next(i);
+        if (lines_.size() >= kMaxLines / 2) lines_.clear();
+    }
+    Line& ln = lines_[row];
+    build(row, ln);
+    return ln;
+}
+
+void ColumnMap::build(int row, Line& ln) {
+    uint64_t start = buf_.lineStart(row);
+    ln.bytes = buf_.lineLength(row);
+    ln.plain = buf_.forEachSpanWhile(start, ln.bytes,
+                                     [](const char* p, size_t n) { return plain(p, n); });
+    ln.marks.clear();
+    if (ln.plain) {
+        ln.cols = ln.bytes;
+        return;
+    }
+    ln.marks.push_back({ 0, 0 });
+    ln.cols = scan(start, ln.marks[0], ln.bytes, ln.marks).col;
+}
+
+// Decodifica desde `from` hasta el byte `to` de la línea que empieza en
+// `start`, dejando un punto de control por tramo. Devuelve dónde
+// terminó: pasa de `to` si el último carácter lo cruza.
+ColumnMap::Mark ColumnMap::scan(uint64_t start, Mark from, uint64_t to,
+                                std::vector<Mark>& marks) const {
+    Mark        at = from;
+    std::string chunk;
+    while (at.byte < to) {
+        uint64_t n = std::min((uint64_t)kStride, to - at.byte);
+        // +3: el último carácter del tramo puede seguir
+        chunk = buf_.substr(start + at.byte, n + 3);
+        size_t i = 0;
+        while (i < n) {
+            if (plainByte((unsigned char)chunk[i])) {
+                ++i;
+                ++at.col;
+                continue;
+            }
+            int len;
+            at.col += charWidth(decode(chunk.data() + i, chunk.size() - i, len));
+            i      += len;
+        }
+        at.byte += i;
+        if (at.byte < to) marks.push_back(at);
+    }
+    return at;
+}
+
+void ColumnMap::walk(int row, const Line& ln, Mark from, const CharFn& fn) const {
+    uint64_t    start = buf_.lineStart(row);
+    Mark        at    = from;
+    std::string chunk;
+    while (at.byte < ln.bytes) {
+        uint64_t n = std::min((uint64_t)kStride, ln.bytes - at.byte);
+        chunk = buf_.substr(start + at.byte, n + 3);
+        size_t i = 0;
+        while (i < n) {
+            int len;
+            int w = charWidth(decode(chunk.data() + i, chunk.size() - i, len));
+            if (!fn(at.byte + i, at.col, len, w)) return;
+            at.col += w;
+            i      += len;
+        }
+        at.byte += i;
+    }
+}
+
+// Último punto de control en o antes de `byte`
+size_t ColumnMap::markBefore(const Line& ln, uint64_t byte) {
+    auto it = std::upper_bound(ln.marks.begin(), ln.marks.end(), byte,
+                               [](uint64_t b, const Mark& m) { return b < m.byte; });
+    return (size_t)(it - ln.marks.begin()) - 1;
+}
+
+// ── Edición ───────────────────────────────────────────────────────
+void ColumnMap::noteEdit(int row, uint64_t col, uint64_t removed, uint64_t added, int lineDelta) {
+    lineCount_ += lineDelta;
+    if (lineDelta != 0) {
+        // Las líneas tocadas se vuelven a medir; las que siguen se corren
+        int last = row + std::max(0, -lineDelta);
+        lines_.erase(lines_.lower_bound(row), lines_.upper_bound(last));
+        std::vector<std::map<int, Line>::node_type> moved;
+        for (auto it = lines_.upper_bound(last); it != lines_.end();) moved.push_back(lines_.extract(it++));
+        for (auto& node : moved) {
+            node.key() += lineDelta;
+            lines_.insert(std::move(node));
+        }
+        return;
+    }
+
+    auto it = lines_.find(row);
+    if (it == lines_.end()) return;
+    Line&    ln    = it->second;
+    uint64_t start = buf_.lineStart(row);
+    uint64_t bytes = ln.bytes - removed + added;
+    // Un '\r' escrito al final pasa a ser parte del fin de línea
+    if (buf_.lineLength(row) != bytes) {
+        lines_.erase(it);
+        return;
+    }
+    if (ln.plain) {
+        if (buf_.forEachSpanWhile(start + col, added,
+                                  [](const char* p, size_t n) { return plain(p, n); }))
+            ln.bytes = ln.cols = bytes;
+        else
+            lines_.erase(it);
+        return;
+    }
+    // Una línea corta se vuelve a medir entera cuando se pida
+    if (ln.marks.size() <= 1) {
+        lines_.erase(it);
+        return;
+    }
+
+    // Se decodifica de nuevo el tramo entre los puntos que rodean lo
+    // editado; los puntos que siguen se corren
+    size_t i = markBefore(ln, col);
+    size_t j = markBefore(ln, col + removed) + 1;
+    Mark   oldEnd = j < ln.marks.size() ? ln.marks[j] : Mark{ ln.bytes, ln.cols };
+    uint64_t to   = oldEnd.byte - removed + added;
+    std::vector<Mark> fresh;
+    Mark end = scan(start, ln.marks[i], to, fresh);
+    if (end.byte != to) {   // un carácter quedó a caballo del borde
+        lines_.erase(it);
+        return;
+    }
+    for (size_t k = j; k < ln.marks.size(); ++k) {
+        ln.marks[k].byte += added - removed;
+        ln.marks[k].col  += end.col - oldEnd.col;
+    }
+    ln.marks.erase(ln.marks.begin() + i + 1, ln.marks.begin() + j);
+    ln.marks.insert(ln.marks.begin() + i + 1, fresh.begin(), fresh.end());
+    ln.bytes  = bytes;
+    ln.cols  += end.col - oldEnd.col;
+}
+
+// ── Consultas ─────────────────────────────────────────────────────
+uint64_t ColumnMap::width(int row) {
+    return line(row).cols;
+}
+
+uint64_t ColumnMap::columnAt(int row, uint64_t byte) {
+    const Line& ln = line(row);
+    if (byte >= ln.bytes) return ln.cols;
+    if (ln.plain) return byte;
+    uint64_t col = 0;
+    walk(row, ln, ln.marks[markBefore(ln, byte)], [&](uint64_t b, uint64_t c, int len, int) {
+        col = c;
+        return b + len <= byte;
+    });
+    return col;
+}
+
+uint64_t ColumnMap::byteAt(int row, uint64_t column) {
+    const Line& ln = line(row);
+    if (column >= ln.cols) return ln.bytes;
+    if (ln.plain) return column;
+    auto it = std::upper_bound(ln.marks.begin(), ln.marks.end(), column,
+                               [](uint64_t c, const Mark& m) { return c < m.col; });
+    uint64_t at = ln.bytes;
+    walk(row, ln, *(it - 1), [&](uint64_t b, uint64_t c, int, int w) {
+        if (w > 0 && c + w > column) {
+            at = b;
+            return false;
+        }
+        return true;
+    });
+    return at;
+}
+
+uint64_t ColumnMap::nextChar(int row, uint64_t byte) {
+    const Line& ln = line(row);
+    if (byte >= ln.bytes) return ln.bytes;
+    if (ln.plain) return byte + 1;
+    uint64_t next   = ln.bytes;
+    bool     passed = false;   // ya se pasó el carácter del cursor
+    walk(row, ln, ln.marks[markBefore(ln, byte)], [&](uint64_t b, uint64_t, int len, int w) {
+        if (b + len <= byte) return true;
+        if (passed && w > 0) {
+            next = b;
+            return false;
+        }
+        passed = true;
+        return true;
+    });
+    return next;
+}
+
+uint64_t ColumnMap::prevChar(int row, uint64_t byte) {
+    const Line& ln = line(row);
+    byte = std::min(byte, ln.bytes);
+    if (byte == 0) return 0;
+    if (ln.plain) return byte - 1;
+    // Si entre el punto y el cursor sólo hay combinantes, se prueba
+    // desde el punto anterior
+    for (size_t k = markBefore(ln, byte - 1) + 1; k-- > 0;) {
+        uint64_t prev = UINT64_MAX;
+        walk(row, ln, ln.marks[k], [&](uint64_t b, uint64_t, int, int w) {
+            if (b >= byte) return false;
+            if (w > 0) prev = b;
+            return true;
+        });
+        if (prev != UINT64_MAX) return prev;
+    }
+    return 0;
+}
@@ -0,0 +1,544 @@
+#include "csvtable.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CSVTABLE_X86 1
+#endif
+
+// Bloques de 64 bytes que se clasifican por llamada
+static const size_t kChunk       = 4096;
+// Cada cuánto se informa el avance y se mira si se canceló
+static const size_t kStep        = 1u << 20;
+// Filas de datos que se miran para los anchos de columna
+static const size_t kWidthSample = 1000;
+
+// ── Clasificación de bytes ────────────────────────────────────────
+// Un bit por byte de cada bloque de 64: comillas, delimitadores y '\n'
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t delim;
+    uint64_t nl;
+};
+
+// Clasifica p[0 .. n), n <= kChunk; el último bloque puede ser parcial
+typedef void (*ClassifyFn)(const char*, size_t, char, BlockMasks*);
+
+static void classifyScalar(const char* p, size_t n, char delim, BlockMasks* out) {
+    for (size_t b = 0; b * 64 < n; ++b) {
+        BlockMasks m = { 0, 0, 0 };
+        size_t end = std::min<size_t>(64, n - b * 64);
+        for (size_t i = 0; i < end; ++i) {
+            char c = p[b * 64 + i];
+            uint64_t bit = (uint64_t)1 << i;
+            if (c == '"')        m.quote |= bit;
+            else if (c == delim) m.delim |= bit;
+            else if (c == '\n')  m.nl    |= bit;
+        }
+        out[b] = m;
+    }
+}
+
+#ifdef CSVTABLE_X86
+#ifdef __SSE2__
+static void classifySse2(const char* p, size_t n, char delim, BlockMasks* out) {
+    const __m128i q = _mm_set1_epi8('"');
+    const __m128i d = _mm_set1_epi8(delim);
+    const __m128i l = _mm_set1_epi8('\n');
+    size_t b = 0;
+    for (; (b + 1) * 64 <= n; ++b) {
+        BlockMasks m = { 0, 0, 0 };
+        for (int j = 0; j < 4; ++j) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + b * 64 + j * 16));
+            m.quote |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, q)) << (j * 16);
+            m.delim |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, d)) << (j * 16);
+            m.nl    |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, l)) << (j * 16);
+        }
+        out[b] = m;
+    }
+    if (b * 64 < n) classifyScalar(p + b * 64, n - b * 64, delim, out + b);
+}
+#endif
+
+__attribute__((target("avx2")))
+static inline uint64_t bits64(__m256i lo, __m256i hi, __m256i v) {
+    return (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, v)) |
+           (uint64_t)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, v)) << 32;
+}
+
+__attribute__((target("avx2")))
+static void classifyAvx2(const char* p, size_t n, char delim, BlockMasks* out) {
+    const __m256i q = _mm256_set1_epi8('"');
+    const __m256i d = _mm256_set1_epi8(delim);
+    const __m256i l = _mm256_set1_epi8('\n');
+    size_t b = 0;
+    for (; (b + 1) * 64 <= n; ++b) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + b * 64));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + b * 64 + 32));
+        out[b] = { bits64(lo, hi, q), bits64(lo, hi, d), bits64(lo, hi, l) };
+    }
+    if (b * 64 < n) classifyScalar(p + b * 64, n - b * 64, delim, out + b);
+}
+#endif
+
+static ClassifyFn pickClassify() {
+#ifdef CSVTABLE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return classifyAvx2;
+#ifdef __SSE2__
+    return classifySse2;
+#endif
+#endif
+    return classifyScalar;
+}
+
+static ClassifyFn gClassify = pickClassify();
+
+// Bit i = xor de los bits 0..i: 1 en los bytes entre comillas (incluida
+// la que abre)
+static inline uint64_t prefixXor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// ── Construcción ──────────────────────────────────────────────────
+char CsvTable::detectDelimiter(const TextSnapshot& snap) {
+    static const char kCandidates[] = { ',', ';', '\t', '|' };
+    std::string head = snap.substr(0, 64 * 1024);
+    size_t count[4] = { 0, 0, 0, 0 };
+    bool quoted = false;
+    for (char c : head) {
+        if (c == '"') quoted = !quoted;
+        if (quoted) continue;
+        if (c == '\n') break;
+        for (int k = 0; k < 4; ++k)
+            if (c == kCandidates[k]) ++count[k];
+    }
+    int best = 0;
+    for (int k = 1; k < 4; ++k)
+        if (count[k] > count[best]) best = k;
+    return kCandidates[best];
+}
+
+bool CsvTable::build(const TextSnapshot& snap, char delimiter,
+                     std::atomic<uint64_t>* scanned, const std::atomic<bool>* cancel) {
+    snap_    = snap;
+    delim_   = delimiter;
+    columns_ = 0;
+    rows_.clear();
+    view_.clear();
+    filtered_ = false;
+    if (snap.size() == 0) {
+        widths_.clear();
+        return true;
+    }
+
+    rows_.push_back(0);
+    const uint64_t size = snap.size();
+    bool     inQuote = false;
+    uint64_t seps    = 0;   // delimitadores en la fila actual
+    uint64_t base    = 0;   // offset en el documento del tramo actual
+    BlockMasks masks[kChunk / 64];
+
+    bool ok = snap.forEachSpanWhile(0, size, [&](const char* p, size_t n) {
+        for (size_t step = 0; step < n; step += kStep) {
+            if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+            size_t stepEnd = std::min(n, step + kStep);
+            for (size_t chunk = step; chunk < stepEnd; chunk += kChunk) {
+                size_t len = std::min(kChunk, stepEnd - chunk);
+                gClassify(p + chunk, len, delim_, masks);
+                for (size_t b = 0; b * 64 < len; ++b) {
+                    const BlockMasks& m = masks[b];
+                    uint64_t inq = prefixXor(m.quote) ^ (inQuote ? ~(uint64_t)0 : 0);
+                    inQuote = inq >> 63;
+                    uint64_t delims = m.delim & ~inq;
+                    uint64_t ends   = m.nl & ~inq;
+                    uint64_t done   = 0;   // bits ya contados
+                    uint64_t at     = base + chunk + b * 64;
+                    for (; ends; ends &= ends - 1) {
+                        int bit = __builtin_ctzll(ends);
+                        uint64_t upTo = bit == 63 ? ~(uint64_t)0 : ((uint64_t)2 << bit) - 1;
+                        seps += (uint64_t)__builtin_popcountll(delims & upTo & ~done);
+                        columns_ = std::max<size_t>(columns_, seps + 1);
+                        seps = 0;
+                        done = upTo;
+                        if (at + bit + 1 < size) rows_.push_back(at + bit + 1);
+                    }
+                    seps += (uint64_t)__builtin_popcountll(delims & ~done);
+                }
+            }
+            if (scanned) *scanned += stepEnd - step;
+        }
+        base += n;
+        return true;
+    });
+    if (!ok) {
+        rows_.clear();
+        columns_ = 0;
+        return false;
+    }
+    columns_ = std::max<size_t>(columns_, seps + 1);
+    computeWidths();
+    return true;
+}
+
+// ── Campos ────────────────────────────────────────────────────────
+uint64_t CsvTable::rowEnd(size_t row) const {
+    uint64_t start = rows_[row];
+    uint64_t end   = row + 1 < rows_.size() ? rows_[row + 1] - 1 : snap_.size();
+    if (row + 1 == rows_.size() && end > start && *snap_.contiguous(end - 1, 1) == '\n') --end;
+    if (end > start && *snap_.contiguous(end - 1, 1) == '\r') --end;
+    return end;
+}
+
+// Bytes de [from, to): en su lugar si caen en un tramo, si no copiados a `tmp`
+static const char* rowBytes(const TextSnapshot& snap, uint64_t from, uint64_t to,
+                            std::string& tmp) {
+    if (const char* p = snap.contiguous(from, to - from)) return p;
+    tmp = snap.substr(from, to - from);
+    return tmp.data();
+}
+
+// Recorre la fila p[0 .. n) (que empieza en `base`) campo por campo;
+// `fn` devuelve false para cortar. Un campo que empieza con '"' se
+// toma hasta la última comilla.
+template <class Fn>
+static void scanRow(const char* p, size_t n, uint64_t base, char delim, Fn&& fn) {
+    size_t start     = 0;
+    bool   inQuote   = false;
+    bool   quoted    = false;
+    size_t lastQuote = 0;
+    int    quotes    = 0;
+
+    auto emit = [&](size_t end) {
+        CsvTable::Field f;
+        if (quoted) {
+            size_t close = quotes > 1 ? lastQuote : end;
+            f = { base + start + 1, close - (start + 1), quotes > 2 };
+        } else {
+            f = { base + start, end - start, false };
+        }
+        return fn(f);
+    };
+
+    for (size_t i = 0; i < n; ++i) {
+        char c = p[i];
+        if (c == '"') {
+            if (i == start) quoted = true;
+            inQuote = !inQuote;
+            lastQuote = i;
+            ++quotes;
+        } else if (c == delim && !inQuote) {
+            if (!emit(i)) return;
+            start  = i + 1;
+            quoted = false;
+            quotes = 0;
+        }
+    }
+    emit(n);
+}
+
+void CsvTable::fields(size_t row, std::vector<Field>& out) const {
+    out.clear();
+    uint64_t from = rows_[row], to = rowEnd(row);
+    std::string tmp;
+    const char* p = rowBytes(snap_, from, to, tmp);
+    scanRow(p, (size_t)(to - from), from, delim_, [&](const Field& f) {
+        out.push_back(f);
+        return true;
+    });
+}
+
+bool CsvTable::field(size_t row, size_t col, Field& out) const {
+    uint64_t from = rows_[row], to = rowEnd(row);
+    std::string tmp;
+    const char* p = rowBytes(snap_, from, to, tmp);
+    size_t k = 0;
+    bool found = false;
+    scanRow(p, (size_t)(to - from), from, delim_, [&](const Field& f) {
+        if (k++ < col) return true;
+        out = f;
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+std::string CsvTable::text(const Field& f, size_t maxBytes) const {
+    // Con "" cada byte mostrado puede costar dos
+    uint64_t take = f.length;
+    if (maxBytes < f.length)
+        take = f.escaped ? std::min<uint64_t>(f.length, (uint64_t)maxBytes * 2) : maxBytes;
+    std::string raw = snap_.substr(f.offset, take);
+    std::string out;
+    out.reserve(std::min<size_t>(raw.size(), maxBytes));
+    for (size_t i = 0; i < raw.size() && out.size() < maxBytes; ++i) {
+        char c = raw[i];
+        if (c == '"' && f.escaped && i + 1 < raw.size() && raw[i + 1] == '"') ++i;
+        if (c == '\n' || c == '\r' || c == '\t') c = ' ';
+        out += c;
+    }
+    return out;
+}
+
+// Ancho en pantalla: un carácter por byte que no sea de continuación UTF-8
+static int displayWidth(const std::string& s) {
+    int w = 0;
+    for (char c : s)
+        if (((unsigned char)c & 0xC0) != 0x80) ++w;
+    return w;
+}
+
+void CsvTable::computeWidths() {
+    widths_.assign(columns_, 1);
+    size_t last = std::min(rows_.size(), kWidthSample + 1);
+    std::vector<Field> fs;
+    for (size_t r = 0; r < last; ++r) {
+        fields(r, fs);
+        for (size_t c = 0; c < fs.size() && c < columns_; ++c) {
+            int w = displayWidth(text(fs[c], kMaxColumnWidth * 4));
+            widths_[c] = std::max(widths_[c], std::min(w, (int)kMaxColumnWidth));
+        }
+    }
+}
+
+// ── Vista ─────────────────────────────────────────────────────────
+void CsvTable::resetView() {
+    view_.clear();
+    view_.shrink_to_fit();
+    filtered_ = false;
+}
+
+// Tramos en que se reparten n filas: uno por hilo del pool, no muy chicos
+static size_t partsFor(size_t n) {
+    return std::max<size_t>(1, std::min<size_t>(ThreadPool::shared().size(), n / 4096));
+}
+
+// Tramo k de partsFor(n): [n*k/parts, n*(k+1)/parts)
+static void parallelFor(size_t n, const std::function<void(size_t, size_t, size_t)>& fn) {
+    size_t parts = partsFor(n);
+    std::vector<std::future<void>> jobs;
+    for (size_t k = 0; k < parts; ++k) {
+        size_t a = n * k / parts, b = n * (k + 1) / parts;
+        jobs.push_back(ThreadPool::shared().submit([&fn, a, b, k] { fn(k, a, b); }));
+    }
+    for (auto& j : jobs) j.get();
+}
+
+// Número decimal completo: [+-]dígitos[.dígitos][e[+-]dígitos]. Hasta
+// 15 cifras sin exponente se arma directo (mantisa y potencia de 10
+// exactas, una sola división: mismo resultado que strtod).
+static bool parseNumber(const char* p, size_t n, double& out) {
+    static const double kPow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                                     1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+    while (n > 0 && *p == ' ') { ++p; --n; }
+    while (n > 0 && p[n - 1] == ' ') --n;
+    if (n == 0 || n > 63) return false;
+    size_t   i = 0, digits = 0, decimals = 0;
+    uint64_t mantissa = 0;
+    bool     neg = p[0] == '-';
+    if (p[i] == '+' || p[i] == '-') ++i;
+    for (; i < n && isdigit((unsigned char)p[i]); ++i, ++digits)
+        mantissa = mantissa * 10 + (uint64_t)(p[i] - '0');
+    if (i < n && p[i] == '.') {
+        for (++i; i < n && isdigit((unsigned char)p[i]); ++i, ++digits, ++decimals)
+            mantissa = mantissa * 10 + (uint64_t)(p[i] - '0');
+    }
+    if (digits == 0) return false;
+    bool exponent = i < n && (p[i] == 'e' || p[i] == 'E');
+    if (exponent) {
+        ++i;
+        if (i < n && (p[i] == '+' || p[i] == '-')) ++i;
+        if (i == n || !isdigit((unsigned char)p[i])) return false;
+        while (i < n && isdigit((unsigned char)p[i])) ++i;
+    }
+    if (i != n) return false;
+    if (!exponent && digits <= 15) {
+        out = (double)mantissa / kPow10[decimals];
+        if (neg) out = -out;
+        return true;
+    }
+    char tmp[64];
+    memcpy(tmp, p, n);
+    tmp[n] = '\0';
+    out = strtod(tmp, nullptr);
+    return true;
+}
+
+// Recorre en orden de archivo (no de la vista) las filas de la vista,
+// repartidas en el pool: leer el documento en orden es mucho más
+// barato que saltar por él tras un orden o un filtro anterior
+void CsvTable::forEachInView(const std::function<void(size_t, size_t, uint32_t)>& fn) const {
+    bool all = view_.empty() && !filtered_;
+    std::vector<uint32_t> posOf;   // posición en la vista de cada fila
+    if (!all) {
+        posOf.assign(rows_.size(), UINT32_MAX);
+        for (size_t i = 0; i < view_.size(); ++i) posOf[view_[i]] = (uint32_t)i;
+    }
+    parallelFor(dataRows(), [&](size_t part, size_t a, size_t b) {
+        for (size_t r = a + 1; r <= b; ++r) {
+            uint32_t pos = all ? (uint32_t)(r - 1) : posOf[r];
+            if (pos != UINT32_MAX) fn(part, r, pos);
+        }
+    });
+}
+
+namespace {
+// Lo que se ordena: 16 bytes. `prefix` ordena como la clave completa
+// hasta donde llega (los primeros 8 bytes del texto, o el número como
+// entero sin signo); el resto del texto está en SortText[pos], y pos
+// (la posición en la vista anterior) desempata.
+struct SortKey {
+    uint64_t prefix;
+    uint32_t pos;
+    uint32_t numeric;
+};
+struct SortText {
+    const char* p;
+    uint32_t    len;
+    uint32_t    row;
+};
+}
+
+// double → uint64 con el mismo orden
+static uint64_t orderedBits(double d) {
+    uint64_t u;
+    memcpy(&u, &d, sizeof u);
+    return (u >> 63) ? ~u : u | ((uint64_t)1 << 63);
+}
+
+static uint64_t textPrefix(const char* p, size_t n) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < 8; ++i) v = (v << 8) | (i < n ? (unsigned char)p[i] : 0);
+    return v;
+}
+
+void CsvTable::sortBy(size_t col, bool descending) {
+    // Cada fila va a la posición que tenía en la vista
+    size_t n = viewCount();
+    std::vector<SortKey>  keys(n);
+    std::vector<SortText> texts(n);
+    std::vector<std::deque<std::string>> owned(partsFor(dataRows()));
+
+    forEachInView([&](size_t part, size_t row, uint32_t pos) {
+        SortKey&  k = keys[pos];
+        SortText& t = texts[pos];
+        k = { 0, pos, 0 };
+        t = { nullptr, 0, (uint32_t)row };
+        Field f;
+        if (!field(row, col, f)) return;
+        const char* p = f.escaped ? nullptr : snap_.contiguous(f.offset, f.length);
+        if (!p) {
+            owned[part].push_back(text(f));
+            p = owned[part].back().data();
+            f.length = owned[part].back().size();
+        }
+        double num;
+        if (parseNumber(p, (size_t)f.length, num)) {
+            k.prefix  = orderedBits(num);
+            k.numeric = 1;
+        } else {
+            t.p      = p;
+            t.len    = (uint32_t)std::min<uint64_t>(f.length, UINT32_MAX);
+            k.prefix = textPrefix(p, t.len);
+        }
+    });
+
+    // Los números antes que el texto; orden total, así que queda estable
+    auto less = [&texts, descending](const SortKey& x, const SortKey& y) {
+        int c;
+        if (x.numeric != y.numeric) {
+            c = x.numeric ? -1 : 1;
+        } else if (x.prefix != y.prefix) {
+            c = x.prefix < y.prefix ? -1 : 1;
+        } else if (x.numeric) {
+            c = 0;
+        } else {
+            const SortText& a = texts[x.pos];
+            const SortText& b = texts[y.pos];
+            uint32_t m = std::min(a.len, b.len);
+            c = m > 8 ? memcmp(a.p + 8, b.p + 8, m - 8) : 0;
+            if (c == 0) c = a.len < b.len ? -1 : a.len > b.len ? 1 : 0;
+        }
+        if (c != 0) return descending ? c > 0 : c < 0;
+        return x.pos < y.pos;
+    };
+    // Por tramos en paralelo y luego mezclas
+    parallelFor(n, [&](size_t, size_t a, size_t b) {
+        std::sort(keys.begin() + a, keys.begin() + b, less);
+    });
+    std::vector<size_t> bounds;
+    for (size_t k = 0, m = partsFor(n); k <= m; ++k) bounds.push_back(n * k / m);
+    while (bounds.size() > 2) {
+        std::vector<size_t> next;
+        for (size_t k = 0; k + 2 < bounds.size(); k += 2) {
+            std::inplace_merge(keys.begin() + bounds[k], keys.begin() + bounds[k + 1],
+                               keys.begin() + bounds[k + 2], less);
+            next.push_back(bounds[k]);
+        }
+        if (bounds.size() % 2 == 0) next.push_back(bounds[bounds.size() - 2]);
+        next.push_back(bounds.back());
+        bounds.swap(next);
+    }
+    view_.resize(n);
+    for (size_t i = 0; i < n; ++i) view_[i] = texts[keys[i].pos].row;
+}
+
+// Contiene `needle` (ya en minúsculas si !cs)
+static bool contains(const char* p, size_t n, const std::string& needle, bool cs) {
+    if (needle.size() > n) return false;
+    if (cs) return memmem(p, n, needle.data(), needle.size()) != nullptr;
+    for (size_t i = 0; i + needle.size() <= n; ++i) {
+        size_t k = 0;
+        while (k < needle.size() && tolower((unsigned char)p[i + k]) == (unsigned char)needle[k]) ++k;
+        if (k == needle.size()) return true;
+    }
+    return false;
+}
+
+void CsvTable::filterBy(size_t col, const std::string& needle) {
+    if (needle.empty()) return;
+    bool cs = std::any_of(needle.begin(), needle.end(),
+                          [](char c) { return isupper((unsigned char)c); });
+    std::string lower = needle;
+    if (!cs) std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+    // Un byte por fila (no bits: cada hilo escribe su tramo sin pisar otro)
+    std::vector<char> match(rows_.size(), 0);
+    forEachInView([&](size_t, size_t row, uint32_t) {
+        Field f;
+        if (!field(row, col, f)) return;
+        const char* p = f.escaped ? nullptr : snap_.contiguous(f.offset, f.length);
+        size_t len = (size_t)f.length;
+        std::string tmp;
+        if (!p) {
+            tmp = text(f);
+            p = tmp.data();
+            len = tmp.size();
+        }
+        if (contains(p, len, lower, cs)) match[row] = 1;
+    });
+
+    std::vector<uint32_t> kept;
+    if (view_.empty() && !filtered_) {
+        for (size_t r = 1; r < rows_.size(); ++r)
+            if (match[r]) kept.push_back((uint32_t)r);
+    } else {
+        for (uint32_t r : view_)
+            if (match[r]) kept.push_back(r);
+    }
+    view_.swap(kept);
+    filtered_ = true;
+}
@@ -164,15 +164,23 @@ bool dialogChoose(const std::string& title,
 
 // ── dialogFindReplace ─────────────────────────────────────────────
 bool dialogFindReplace(FindReplaceParams& params) {
-    int w = 60, h = 10;
+    int w = 60, h = 11;
     WINDOW* win = centeredWin(h, w);
     drawBox(win, "Buscar y Reemplazar");
 
+    // Las opciones van en teclas de función para no robar letras a los
+    // campos (un patrón puede llevar cualquier carácter)
+    auto drawOptions = [&] {
+        mvwprintw(win, 5, 2, "[F2] May/Min: %s", params.caseSensitive ? "SI" : "NO");
+        mvwprintw(win, 6, 2, "[F3] Todo   : %s", params.replaceAll    ? "SI" : "NO");
+        mvwprintw(win, 7, 2, "[F4] Regex  : %s  ($1..$9 en el reemplazo)",
+                  params.regex ? "SI" : "NO");
+    };
+
     mvwprintw(win, 1, 2, "Buscar   :");
     mvwprintw(win, 3, 2, "Reemplaz.:");
-    mvwprintw(win, 5, 2, "[M] May/Min: %s", params.caseSensitive ? "SI" : "NO");
-    mvwprintw(win, 6, 2, "[A] Todo   : %s", params.replaceAll   ? "SI" : "NO");
-    mvwprintw(win, 8, 2, "[Enter] Buscar/Reemplazar  [Esc] Cancelar");
+    drawOptions();
+    mvwprintw(win, 9, 2, "[Enter] Buscar/Reemplazar  [Esc] Cancelar");
 
     // Campo activo: 0 = needle, 1 = replacement
     int field = 0;
@@ -195,8 +203,7 @@ bool dialogFindReplace(FindReplaceParams& params) {
     while (running) {
         drawField(0);
         drawField(1);
-        mvwprintw(win, 5, 2, "[M] May/Min: %s", params.caseSensitive ? "SI" : "NO");
-        mvwprintw(win, 6, 2, "[A] Todo   : %s", params.replaceAll   ? "SI" : "NO");
+        drawOptions();
         // Cursor en campo activo
         wmove(win, (field == 0 ? 1 : 3), 13 + cursors[field]);
         wrefresh(win);
@@ -206,8 +213,9 @@ bool dialogFindReplace(FindReplaceParams& params) {
         case 27: running = false; confirmed = false; break;
         case '\n': case KEY_ENTER: running = false; confirmed = true; break;
         case '\t': field = 1 - field; break;
-        case 'm': case 'M': params.caseSensitive = !params.caseSensitive; break;
-        case 'a': case 'A': params.replaceAll    = !params.replaceAll;    break;
+        case KEY_F(2): params.caseSensitive = !params.caseSensitive; break;
+        case KEY_F(3): params.replaceAll    = !params.replaceAll;    break;
+        case KEY_F(4): params.regex         = !params.regex;         break;
         case KEY_BACKSPACE: case 127: case '\b':
             if (cursors[field] > 0) {
                 bufs[field].erase(cursors[field] - 1, 1);
@@ -1,22 +1,60 @@
 #include "editor.h"
+#include "regex.h"
+#include "searchkernel.h"
+#include "threadpool.h"
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
 #include <sstream>
 
 // ── Paleta de colores ─────────────────────────────────────────────
 #define COLOR_EDITOR_BG   1
 #define COLOR_CURSOR_LINE 2
+#define COLOR_SEARCH_HIT  7
+#define COLOR_SYN_HEADING 10
+#define COLOR_SYN_STRING  11
+#define COLOR_SYN_TAG     12
+#define COLOR_SYN_COMMENT 13
+#define COLOR_SYN_PUNCT   14
+
+// Tamaño mínimo de cada rango de "reemplazar todo" en paralelo
+static const uint64_t kReplaceRangeBytes = 1 << 20;
+// Por debajo de este tamaño recorrer todo es más barato que indexar
+static const uint64_t kIndexMinBytes = 8 << 20;
+// Tiempo de resaltado por fotograma y por vuelta ociosa de pollHighlight
+static const std::chrono::microseconds kHighlightFrame(400);
+static const std::chrono::microseconds kHighlightIdle(4000);
+// Con ajuste de línea: líneas que se miden de una vez al buscar una fila
+// visual más allá de lo medido, y a partir de cuántas líneas nuevas una
+// edición descarta lo medido desde ella en vez de medirlas ya
+static const int kLayoutChunk    = 4096;
+static const int kLayoutRemeasure = 1024;
 
 // ── Constructor / Destructor ──────────────────────────────────────
 Editor::Editor(int y, int x, int height, int width)
     : winY_(y), winX_(x), height_(height), width_(width),
-      curRow_(0), curCol_(0), viewRow_(0), viewCol_(0), dirty_(false)
+      curRow_(0), curCol_(0), viewRow_(0), viewCol_(0), viewSub_(0), dirty_(false),
+      hits_(nullptr), hitLen_(0), index_(new TrigramIndex()),
+      hl_(buf_), hlPending_(false), cols_(buf_), wrap_(false),
+      drawnViewRow_(0), drawnViewCol_(0), drawnViewSub_(0), drawnCurRow_(0), drawnLines_(0),
+      drawnWrap_(false)
 {
     init_pair(COLOR_EDITOR_BG,   COLOR_WHITE,  COLOR_BLACK);
     init_pair(COLOR_CURSOR_LINE, COLOR_BLACK,  COLOR_WHITE);
+    init_pair(COLOR_SEARCH_HIT,  COLOR_BLACK,  COLOR_YELLOW);
+    init_pair(COLOR_SYN_HEADING, COLOR_YELLOW,  COLOR_BLACK);
+    init_pair(COLOR_SYN_STRING,  COLOR_GREEN,   COLOR_BLACK);
+    init_pair(COLOR_SYN_TAG,     COLOR_CYAN,    COLOR_BLACK);
+    init_pair(COLOR_SYN_COMMENT, COLOR_BLUE,    COLOR_BLACK);
+    init_pair(COLOR_SYN_PUNCT,   COLOR_MAGENTA, COLOR_BLACK);
 
     win_ = newwin(height_, width_, winY_, winX_);
     keypad(win_, TRUE);
-    lines_.push_back(""); // documento vacío tiene al menos una línea
+    wbkgd(win_, COLOR_PAIR(COLOR_EDITOR_BG));
+    idlok(win_, TRUE);   // permite a ncurses desplazar con el terminal
+    damageAll();
 }
 
 Editor::~Editor() {
@@ -28,57 +66,312 @@ void Editor::resize(int y, int x, int height, int width) {
     winY_ = y; winX_ = x; height_ = height; width_ = width;
     wresize(win_, height_, width_);
     mvwin(win_, winY_, winX_);
+    // Con otro ancho cambian todas las filas: se vuelven a medir a
+    // medida que se pidan
+    if (layout_.width() != width_) layout_.reset(width_);
+    damageAll();
+    scrollToCursor();
+}
+
+void Editor::setWrap(bool on) {
+    wrap_ = on;
+    layout_.reset(width_);
+    viewCol_ = 0;
+    viewSub_ = 0;
+    damageAll();
     scrollToCursor();
 }
 
+// ── Ajuste de línea ───────────────────────────────────────────────
+void Editor::measureLayout(int upTo) {
+    upTo = std::min(upTo, lineCount());
+    if (layout_.lines() < upTo) layout_.measure(cols_, upTo);
+}
+
+int64_t Editor::visualRow(int line, int sub) {
+    if (!wrap_) return line;
+    measureLayout(line + height_);
+    return layout_.rowsBefore(line) + sub;
+}
+
+void Editor::lineAtVisual(int64_t row, int& line, int& sub) {
+    if (!wrap_) {
+        line = (int)std::max<int64_t>(0, std::min<int64_t>(row, lineCount() - 1));
+        sub  = 0;
+        return;
+    }
+    while (layout_.totalRows() <= row && layout_.lines() < lineCount())
+        measureLayout(layout_.lines() + kLayoutChunk);
+    line = layout_.lineAtRow(std::max<int64_t>(0, std::min(row, layout_.totalRows() - 1)), sub);
+}
+
+void Editor::layoutRows(int total) {
+    rowLine_.assign(std::max(0, height_), -1);
+    rowSub_.assign(rowLine_.size(), 0);
+    if (wrap_) measureLayout(viewRow_ + height_);
+    int line = viewRow_, sub = wrap_ ? viewSub_ : 0;
+    for (int vr = 0; vr < height_ && line < total; ++vr) {
+        rowLine_[vr] = line;
+        rowSub_[vr]  = sub;
+        if (!wrap_ || ++sub >= layout_.rows(line)) {
+            ++line;
+            sub = 0;
+        }
+    }
+}
+
+// Lo medido de [row, ...) deja de valer; si cambió cuántas filas ocupa
+// la zona, lo que sigue se corrió en pantalla
+void Editor::noteLayoutEdit(int row, int oldLines, int newLines) {
+    if (!wrap_ || row >= layout_.lines()) return;
+    if (row + oldLines > layout_.lines() || newLines > kLayoutRemeasure) {
+        damageFrom(row);
+        layout_.truncate(row);
+        return;
+    }
+    if (layout_.replaceLines(cols_, row, oldLines, newLines)) damageFrom(row);
+}
+
 // ── Dibujo ────────────────────────────────────────────────────────
+// Sólo se reconstruyen las filas dañadas desde el último draw(). Un
+// desplazamiento vertical corto mueve lo ya pintado con wscrl y daña
+// sólo las filas que entran.
+// Con ajuste una línea ocupa varias filas; lo no medido está más abajo
+// que la pantalla
+void Editor::damageRow(int docRow) {
+    if (wrap_ && docRow >= layout_.lines()) return;
+    int64_t from = wrap_ ? visualRow(docRow, 0) - visualRow(drawnViewRow_, drawnViewSub_)
+                         : docRow - drawnViewRow_;
+    int64_t to   = from + (wrap_ ? layout_.rows(docRow) : 1);
+    for (int64_t vr = std::max<int64_t>(0, from); vr < to && vr < (int64_t)damaged_.size(); ++vr)
+        damaged_[vr] = 1;
+}
+
+void Editor::damageFrom(int docRow) {
+    if (wrap_ && docRow >= layout_.lines()) return;
+    int64_t from = wrap_ ? visualRow(docRow, 0) - visualRow(drawnViewRow_, drawnViewSub_)
+                         : docRow - drawnViewRow_;
+    for (int64_t vr = std::max<int64_t>(0, from); vr < (int64_t)damaged_.size(); ++vr)
+        damaged_[vr] = 1;
+}
+
+void Editor::damageAll() {
+    damaged_.assign(std::max(0, height_), 1);
+    drawnStates_.assign(damaged_.size(), UINT32_MAX);
+}
+
 void Editor::draw() {
-    werase(win_);
-    wbkgd(win_, COLOR_PAIR(COLOR_EDITOR_BG));
+    // Carga perezosa: indexar sólo lo que se va a mostrar
+    buf_.ensureLines(viewRow_ + height_);
+
+    int total = lineCount();
+    if (viewCol_ != drawnViewCol_ || wrap_ != drawnWrap_) {
+        damageAll();
+    } else if (viewRow_ != drawnViewRow_ || viewSub_ != drawnViewSub_) {
+        int64_t dv = visualRow(viewRow_, viewSub_) - visualRow(drawnViewRow_, drawnViewSub_);
+        int     d  = (int)std::max<int64_t>(-height_, std::min<int64_t>(height_, dv));
+        if (std::abs(d) < height_) {
+            scrollok(win_, TRUE);
+            wscrl(win_, d);
+            scrollok(win_, FALSE);
+            if (d > 0) {
+                damaged_.erase(damaged_.begin(), damaged_.begin() + d);
+                damaged_.insert(damaged_.end(), d, 1);
+                drawnStates_.erase(drawnStates_.begin(), drawnStates_.begin() + d);
+                drawnStates_.insert(drawnStates_.end(), d, UINT32_MAX);
+            } else {
+                damaged_.erase(damaged_.end() + d, damaged_.end());
+                damaged_.insert(damaged_.begin(), -d, 1);
+                drawnStates_.erase(drawnStates_.end() + d, drawnStates_.end());
+                drawnStates_.insert(drawnStates_.begin(), -d, UINT32_MAX);
+            }
+        } else {
+            damageAll();
+        }
+    }
+    drawnViewRow_ = viewRow_;
+    drawnViewCol_ = viewCol_;
+    drawnViewSub_ = viewSub_;
+    drawnWrap_    = wrap_;
+
+    // Línea del cursor (resaltada) y líneas que llegaron con la carga
+    if (curRow_ != drawnCurRow_) {
+        damageRow(drawnCurRow_);
+        damageRow(curRow_);
+    }
+    if (total != drawnLines_) damageFrom(std::min(total, drawnLines_) - 1);
+    drawnCurRow_ = curRow_;
+    drawnLines_  = total;
 
+    // Una fila cuyo estado inicial cambió (p. ej. se abrió un bloque de
+    // código más arriba) se repinta aunque su texto sea el mismo
+    layoutRows(total);
+    int visible = 0;
+    for (int dr : rowLine_) if (dr >= 0) visible = dr - viewRow_ + 1;
+    hlPending_ = !hl_.states(viewRow_, visible, total, kHighlightFrame, lineStates_);
     for (int vr = 0; vr < height_; ++vr) {
-        int dr = vr + viewRow_;
-        if (dr < (int)lines_.size()) {
-            drawLine(vr, dr);
+        int dr = rowLine_[vr];
+        if (dr >= 0 && lineStates_[dr - viewRow_] != drawnStates_[vr]) damaged_[vr] = 1;
+    }
+
+    for (int vr = 0; vr < height_; ++vr) {
+        if (!damaged_[vr]) continue;
+        damaged_[vr] = 0;
+        int dr = rowLine_[vr];
+        if (dr >= 0) {
+            drawLine(vr, dr, rowSub_[vr]);
+            drawnStates_[vr] = lineStates_[dr - viewRow_];
+        } else {
+            wmove(win_, vr, 0);
+            wclrtoeol(win_);
         }
     }
 
-    // Posicionar cursor físico
-    int cy = curRow_ - viewRow_;
-    int cx = curCol_ - viewCol_;
+    // Un diálogo o menú pudo pisar la ventana: se entrega entera y
+    // ncurses sólo envía al terminal las celdas que difieren
+    touchwin(win_);
+    placeCursor();
+}
+
+void Editor::placeCursor() {
+    int cy, cx;
+    int col = cursorColumn();
+    if (wrap_) {
+        int64_t v = visualRow(curRow_, col / width_) - visualRow(viewRow_, viewSub_);
+        cy = (int)std::max<int64_t>(-1, std::min<int64_t>(height_, v));
+        cx = col % width_;
+    } else {
+        cy = curRow_ - viewRow_;
+        cx = col - viewCol_;
+    }
     if (cy >= 0 && cy < height_ && cx >= 0 && cx < width_) {
         wmove(win_, cy, cx);
     }
+    wnoutrefresh(win_);
+}
 
-    wrefresh(win_);
+static attr_t styleAttr(TokenStyle style) {
+    switch (style) {
+    case TokenStyle::Heading:     return COLOR_PAIR(COLOR_SYN_HEADING) | A_BOLD;
+    case TokenStyle::Emphasis:    return COLOR_PAIR(COLOR_EDITOR_BG) | A_BOLD;
+    case TokenStyle::Code:
+    case TokenStyle::String:      return COLOR_PAIR(COLOR_SYN_STRING);
+    case TokenStyle::Link:        return COLOR_PAIR(COLOR_SYN_TAG) | A_UNDERLINE;
+    case TokenStyle::Tag:
+    case TokenStyle::Alternate:   return COLOR_PAIR(COLOR_SYN_TAG);
+    case TokenStyle::Attribute:   return COLOR_PAIR(COLOR_SYN_HEADING);
+    case TokenStyle::Comment:     return COLOR_PAIR(COLOR_SYN_COMMENT) | A_BOLD;
+    case TokenStyle::Punctuation: return COLOR_PAIR(COLOR_SYN_PUNCT);
+    default:                      return COLOR_PAIR(COLOR_EDITOR_BG);
+    }
 }
 
-void Editor::drawLine(int visualRow, int docRow) {
+void Editor::drawLine(int visualRow, int docRow, int sub) {
     wmove(win_, visualRow, 0);
-    wclrtoeol(win_);
 
-    bool isCursorLine = (docRow == curRow_);
+    attr_t base = (docRow == curRow_) ? COLOR_PAIR(COLOR_CURSOR_LINE)
+                                      : COLOR_PAIR(COLOR_EDITOR_BG);
 
-    if (isCursorLine)
-        wattron(win_, COLOR_PAIR(COLOR_CURSOR_LINE));
-    else
-        wattron(win_, COLOR_PAIR(COLOR_EDITOR_BG));
+    // Columnas de pantalla [startCol, endCol), desde el carácter que
+    // ocupa startCol
+    uint64_t startCol = wrap_ ? (uint64_t)sub * width_ : (uint64_t)viewCol_;
+    uint64_t endCol   = startCol + width_;
+    uint64_t start    = buf_.lineStart(docRow);
+    uint64_t len      = buf_.lineLength(docRow);
+    uint64_t from     = cols_.byteAt(docRow, startCol);
+    uint64_t col      = cols_.columnAt(docRow, from);
 
-    const std::string& line = lines_[docRow];
-    int startCol = viewCol_;
-    int endCol   = std::min((int)line.size(), viewCol_ + width_);
+    // Caracteres visibles. Sólo se copia la parte visible: una línea de
+    // varios MB no se copia entera
+    struct Glyph {
+        uint64_t byte;    // en la línea
+        int      len;
+        uint64_t col;
+        int      width;
+        uint32_t cp;
+    };
+    std::vector<Glyph> glyphs;
+    std::string text;
+    for (uint64_t at = from; col < endCol && at < len;) {
+        size_t i = (size_t)(at - from);
+        if (i + 4 > text.size() && from + text.size() < len)
+            text += buf_.substr(start + from + text.size(), (uint64_t)width_ * 4 + 16);
+        int      n;
+        uint32_t cp = ColumnMap::decode(text.data() + i, text.size() - i, n);
+        int      w  = ColumnMap::charWidth(cp);
+        glyphs.push_back({ at, n, col, w, cp });
+        at  += n;
+        col += w;
+    }
 
-    for (int c = startCol; c < endCol; ++c) {
-        waddch(win_, (unsigned char)line[c]);
+    // Atributo de cada carácter: la sintaxis (salvo en la línea del
+    // cursor) y encima las coincidencias de búsqueda
+    std::vector<attr_t> attrs(glyphs.size(), base);
+    if (docRow != curRow_ && hl_.grammar() && !glyphs.empty() &&
+        len <= Highlighter::kMaxLineLength) {
+        const std::string line = buf_.line(docRow);
+        tokens_.clear();
+        hl_.grammar()->tokenize(line.data(), line.size(), lineStates_[docRow - viewRow_], &tokens_);
+        size_t t = 0;
+        for (size_t g = 0; g < glyphs.size(); ++g) {
+            while (t < tokens_.size() && tokens_[t].start + tokens_[t].length <= glyphs[g].byte) ++t;
+            if (t < tokens_.size() && tokens_[t].start <= glyphs[g].byte)
+                attrs[g] = styleAttr(tokens_[t].style);
+        }
     }
-    // Rellenar resto de la línea con espacios para resaltar línea cursor
-    int printed = endCol - startCol;
-    for (int p = printed; p < width_; ++p) waddch(win_, ' ');
+    if (hits_ && !hits_->empty() && !glyphs.empty()) {
+        uint64_t first = start + from;
+        auto it = std::lower_bound(hits_->begin(), hits_->end(),
+                                   first > hitLen_ ? first - hitLen_ + 1 : 0);
+        for (size_t g = 0; g < glyphs.size(); ++g) {
+            uint64_t o = start + glyphs[g].byte;
+            while (it != hits_->end() && *it + hitLen_ <= o) ++it;
+            if (it != hits_->end() && *it <= o) attrs[g] = COLOR_PAIR(COLOR_SEARCH_HIT);
+        }
+    }
+
+    // Tramos con el mismo atributo, de una sola llamada cada uno. El
+    // tabulador y los controles ocupan columnas fijas (espacios, ^X), lo
+    // que no se puede pintar va como U+FFFD y un carácter cortado por un
+    // borde deja espacios
+    std::string run;
+    attr_t      runAttr = base;
+    auto flush = [&] {
+        if (run.empty()) return;
+        wattrset(win_, runAttr);
+        waddnstr(win_, run.data(), (int)run.size());
+        run.clear();
+    };
+    for (size_t g = 0; g < glyphs.size(); ++g) {
+        const Glyph& gl = glyphs[g];
+        if (attrs[g] != runAttr) {
+            flush();
+            runAttr = attrs[g];
+        }
+        if (gl.col < startCol || gl.col + gl.width > endCol) {
+            uint64_t a = std::max(gl.col, startCol);
+            uint64_t b = std::min(gl.col + gl.width, endCol);
+            run.append((size_t)(b - a), ' ');
+        } else if (gl.cp == '\t') {
+            run.append((size_t)ColumnMap::kTabWidth, ' ');
+        } else if (gl.cp < 0x20 || gl.cp == 0x7f) {
+            run += '^';
+            run += (char)(gl.cp ^ 0x40);
+        } else if (gl.cp == 0xFFFD || !ColumnMap::printable(gl.cp)) {
+            run += "\xEF\xBF\xBD";
+        } else {
+            run.append(text, (size_t)(gl.byte - from), (size_t)gl.len);
+        }
+    }
+    flush();
 
-    if (isCursorLine)
-        wattroff(win_, COLOR_PAIR(COLOR_CURSOR_LINE));
-    else
-        wattroff(win_, COLOR_PAIR(COLOR_EDITOR_BG));
+    // Rellenar resto de la línea con espacios para resaltar línea cursor
+    wattrset(win_, base);
+    if (getcury(win_) == visualRow) {
+        int pad = width_ - getcurx(win_);
+        if (pad > 0) waddnstr(win_, std::string(pad, ' ').c_str(), pad);
+    }
+    wattrset(win_, A_NORMAL);
 }
 
 // ── Manejo de Input ───────────────────────────────────────────────
@@ -92,23 +385,29 @@ void Editor::handleInput(int ch) {
     case KEY_HOME:
         curCol_ = 0;
         viewCol_ = 0;
+        scrollToCursor();
         break;
 
     case KEY_END:
-        curCol_ = (int)lines_[curRow_].size();
+        curCol_ = lineLen(curRow_);
         scrollToCursor();
         break;
 
     case KEY_PPAGE: // Page Up
-        curRow_ = std::max(0, curRow_ - (height_ - 1));
-        clampCursor();
-        scrollToCursor();
+        if (wrap_) {
+            moveCursorVisual(-(height_ - 1));
+            break;
+        }
+        moveToRow(std::max(0, curRow_ - (height_ - 1)));
         break;
 
     case KEY_NPAGE: // Page Down
-        curRow_ = std::min((int)lines_.size() - 1, curRow_ + (height_ - 1));
-        clampCursor();
-        scrollToCursor();
+        buf_.ensureLines(curRow_ + 2 * height_);
+        if (wrap_) {
+            moveCursorVisual(height_ - 1);
+            break;
+        }
+        moveToRow(std::min(lineCount() - 1, curRow_ + (height_ - 1)));
         break;
 
     case KEY_BACKSPACE:
@@ -143,37 +442,58 @@ void Editor::handleInput(int ch) {
 }
 
 // ── Movimiento del cursor ─────────────────────────────────────────
+// Con ajuste, arriba / abajo y las páginas se mueven por filas visuales
+// manteniendo la columna dentro de la fila
+void Editor::moveCursorVisual(int64_t delta) {
+    int col = cursorColumn();
+    int x   = col % width_;
+    int sub = col / width_;
+    lineAtVisual(std::max<int64_t>(0, visualRow(curRow_, sub) + delta), curRow_, sub);
+    curCol_ = (int)cols_.byteAt(curRow_, (uint64_t)sub * width_ + x);
+    scrollToCursor();
+}
+
+// La columna de pantalla se conserva: el byte cambia con los
+// caracteres de varios bytes o anchos
+void Editor::moveToRow(int row) {
+    uint64_t col = cols_.columnAt(curRow_, curCol_);
+    curRow_ = row;
+    curCol_ = (int)cols_.byteAt(curRow_, col);
+    scrollToCursor();
+}
+
 void Editor::moveCursorUp() {
-    if (curRow_ > 0) {
-        --curRow_;
-        clampCursor();
-        scrollToCursor();
+    if (wrap_) {
+        moveCursorVisual(-1);
+        return;
     }
+    if (curRow_ > 0) moveToRow(curRow_ - 1);
 }
 
 void Editor::moveCursorDown() {
-    if (curRow_ < (int)lines_.size() - 1) {
-        ++curRow_;
-        clampCursor();
-        scrollToCursor();
+    buf_.ensureLines(curRow_ + 2);
+    if (wrap_) {
+        moveCursorVisual(1);
+        return;
     }
+    if (curRow_ < lineCount() - 1) moveToRow(curRow_ + 1);
 }
 
 void Editor::moveCursorLeft() {
     if (curCol_ > 0) {
-        --curCol_;
+        curCol_ = (int)cols_.prevChar(curRow_, curCol_);
     } else if (curRow_ > 0) {
         --curRow_;
-        curCol_ = (int)lines_[curRow_].size();
+        curCol_ = lineLen(curRow_);
     }
     scrollToCursor();
 }
 
 void Editor::moveCursorRight() {
-    int lineLen = (int)lines_[curRow_].size();
-    if (curCol_ < lineLen) {
-        ++curCol_;
-    } else if (curRow_ < (int)lines_.size() - 1) {
+    buf_.ensureLines(curRow_ + 2);
+    if (curCol_ < lineLen(curRow_)) {
+        curCol_ = (int)cols_.nextChar(curRow_, curCol_);
+    } else if (curRow_ < lineCount() - 1) {
         ++curRow_;
         curCol_ = 0;
     }
@@ -181,8 +501,65 @@ void Editor::moveCursorRight() {
 }
 
 // ── Edición ───────────────────────────────────────────────────────
+void Editor::insertAt(uint64_t offset, const std::string& text) {
+    int      row   = buf_.lineAt(offset);
+    int      lines = buf_.lineCount();
+    uint64_t col   = offset - buf_.lineStart(row);
+    buf_.insert(offset, text);
+    index_->noteEdit(offset, 0, text.size());
+    journal_.noteEdit(offset, 0, text.data(), text.size());
+    undo_.record(offset, nullptr, 0, text.data(), text.size());
+    hl_.noteEdit(row, buf_.lineCount() - lines);
+    cols_.noteEdit(row, col, 0, text.size(), buf_.lineCount() - lines);
+    noteLayoutEdit(row, 1, 1 + buf_.lineCount() - lines);
+    if (buf_.lineCount() != lines) damageFrom(row);
+    else                           damageRow(row);
+}
+
+void Editor::eraseAt(uint64_t offset, uint64_t length) {
+    int      row   = buf_.lineAt(offset);
+    int      lines = buf_.lineCount();
+    uint64_t col   = offset - buf_.lineStart(row);
+    std::string removed;
+    if (undo_.recording()) removed = buf_.substr(offset, length);
+    buf_.erase(offset, length);
+    index_->noteEdit(offset, length, 0);
+    journal_.noteEdit(offset, length, nullptr, 0);
+    undo_.record(offset, removed.data(), removed.size(), nullptr, 0);
+    hl_.noteEdit(row, buf_.lineCount() - lines);
+    cols_.noteEdit(row, col, length, 0, buf_.lineCount() - lines);
+    noteLayoutEdit(row, 1 + lines - buf_.lineCount(), 1);
+    if (buf_.lineCount() != lines) damageFrom(row);
+    else                           damageRow(row);
+}
+
+void Editor::bulkReplace(const std::vector<uint64_t>& offsets, uint64_t len,
+                         const std::string& text) {
+    buf_.replaceMatches(offsets, len, text);
+    journal_.noteReplaceMatches(offsets, len, text);
+    index_->reset();
+    maintainIndex();
+    hl_.reset();
+    cols_.reset();
+    layout_.reset(width_);
+    damageAll();
+    dirty_ = true;
+}
+
+void Editor::bulkEdits(const std::vector<TextEdit>& edits) {
+    buf_.applyEdits(edits);
+    journal_.noteEdits(edits);
+    index_->reset();
+    maintainIndex();
+    hl_.reset();
+    cols_.reset();
+    layout_.reset(width_);
+    damageAll();
+    dirty_ = true;
+}
+
 void Editor::insertChar(int ch) {
-    lines_[curRow_].insert(curCol_, 1, (char)ch);
+    insertAt(offsetOf(curRow_, curCol_), std::string(1, (char)ch));
     ++curCol_;
     dirty_ = true;
     scrollToCursor();
@@ -190,14 +567,15 @@ void Editor::insertChar(int ch) {
 
 void Editor::deleteCharBack() {
     if (curCol_ > 0) {
-        lines_[curRow_].erase(curCol_ - 1, 1);
-        --curCol_;
+        int prev = (int)cols_.prevChar(curRow_, curCol_);
+        eraseAt(offsetOf(curRow_, prev), curCol_ - prev);
+        curCol_ = prev;
         dirty_ = true;
     } else if (curRow_ > 0) {
-        // Unir con línea anterior
-        int prevLen = (int)lines_[curRow_ - 1].size();
-        lines_[curRow_ - 1] += lines_[curRow_];
-        lines_.erase(lines_.begin() + curRow_);
+        // Unir con línea anterior: borrar su terminador
+        int prevLen = lineLen(curRow_ - 1);
+        uint64_t eolStart = offsetOf(curRow_ - 1, prevLen);
+        eraseAt(eolStart, buf_.lineStart(curRow_) - eolStart);
         --curRow_;
         curCol_ = prevLen;
         dirty_ = true;
@@ -206,22 +584,23 @@ void Editor::deleteCharBack() {
 }
 
 void Editor::deleteCharFwd() {
-    int lineLen = (int)lines_[curRow_].size();
-    if (curCol_ < lineLen) {
-        lines_[curRow_].erase(curCol_, 1);
+    buf_.ensureLines(curRow_ + 2);
+    if (curCol_ < lineLen(curRow_)) {
+        int next = (int)cols_.nextChar(curRow_, curCol_);
+        eraseAt(offsetOf(curRow_, curCol_), next - curCol_);
         dirty_ = true;
-    } else if (curRow_ < (int)lines_.size() - 1) {
-        // Unir con línea siguiente
-        lines_[curRow_] += lines_[curRow_ + 1];
-        lines_.erase(lines_.begin() + curRow_ + 1);
+    } else if (curRow_ < lineCount() - 1) {
+        // Unir con línea siguiente: borrar el terminador
+        uint64_t eolStart = offsetOf(curRow_, curCol_);
+        eraseAt(eolStart, buf_.lineStart(curRow_ + 1) - eolStart);
         dirty_ = true;
     }
 }
 
 void Editor::insertNewline() {
-    std::string rest = lines_[curRow_].substr(curCol_);
-    lines_[curRow_] = lines_[curRow_].substr(0, curCol_);
-    lines_.insert(lines_.begin() + curRow_ + 1, rest);
+    insertAt(offsetOf(curRow_, curCol_), buf_.eol());
+    // Cada línea escrita es un paso de deshacer
+    undo_.seal();
     ++curRow_;
     curCol_ = 0;
     dirty_ = true;
@@ -230,62 +609,200 @@ void Editor::insertNewline() {
 
 // ── Scroll ────────────────────────────────────────────────────────
 void Editor::scrollToCursor() {
+    if (wrap_) {
+        // Por filas visuales; la vista nunca se corre a la derecha
+        viewCol_ = 0;
+        viewRow_ = std::max(0, std::min(viewRow_, lineCount() - 1));
+        measureLayout(viewRow_ + 1);
+        viewSub_ = std::min(viewSub_, layout_.rows(viewRow_) - 1);
+        int64_t cur = visualRow(curRow_, cursorColumn() / width_);
+        int64_t top = visualRow(viewRow_, viewSub_);
+        if (cur < top)
+            top = cur;
+        else if (cur >= top + height_)
+            top = cur - height_ + 1;
+        lineAtVisual(top, viewRow_, viewSub_);
+        return;
+    }
+
     // Vertical
     if (curRow_ < viewRow_)
         viewRow_ = curRow_;
     else if (curRow_ >= viewRow_ + height_)
         viewRow_ = curRow_ - height_ + 1;
 
-    // Horizontal
-    if (curCol_ < viewCol_)
-        viewCol_ = curCol_;
-    else if (curCol_ >= viewCol_ + width_)
-        viewCol_ = curCol_ - width_ + 1;
-}
-
-void Editor::clampCursor() {
-    if (curRow_ < 0) curRow_ = 0;
-    if (curRow_ >= (int)lines_.size())
-        curRow_ = (int)lines_.size() - 1;
-    int lineLen = (int)lines_[curRow_].size();
-    if (curCol_ > lineLen) curCol_ = lineLen;
+    // Horizontal, en columnas de pantalla
+    int col = cursorColumn();
+    if (col < viewCol_)
+        viewCol_ = col;
+    else if (col >= viewCol_ + width_)
+        viewCol_ = col - width_ + 1;
 }
 
 // ── API pública ────────────────────────────────────────────────────
-void Editor::setLines(const std::vector<std::string>& lines) {
-    lines_ = lines;
-    if (lines_.empty()) lines_.push_back("");
+void Editor::setBuffer(TextBuffer&& buf) {
+    index_->reset();
+    undo_.clear();
+    buf_ = std::move(buf);
+    buf_.ensureLines(height_);
+    hl_.reset();
+    cols_.reset();
+    layout_.reset(width_);
     curRow_ = 0; curCol_ = 0;
-    viewRow_ = 0; viewCol_ = 0;
+    viewRow_ = 0; viewCol_ = 0; viewSub_ = 0;
     dirty_ = false;
+    damageAll();
+    maintainIndex();
 }
 
 void Editor::clear() {
-    lines_.clear();
-    lines_.push_back("");
+    index_->reset();
+    undo_.clear();
+    buf_ = TextBuffer();
+    hl_.reset();
+    cols_.reset();
+    layout_.reset(width_);
     curRow_ = 0; curCol_ = 0;
-    viewRow_ = 0; viewCol_ = 0;
+    viewRow_ = 0; viewCol_ = 0; viewSub_ = 0;
     dirty_ = false;
+    damageAll();
+}
+
+void Editor::park(Parked& out) {
+    out.buf     = std::move(buf_);
+    out.undo    = std::move(undo_);
+    out.index   = std::move(index_);
+    out.curRow  = curRow_;  out.curCol  = curCol_;
+    out.viewRow = viewRow_; out.viewCol = viewCol_; out.viewSub = viewSub_;
+    out.dirty   = dirty_;
+    out.undo.seal();
+    index_.reset(new TrigramIndex());
+    clear();
+}
+
+// Como setBuffer, pero conservando historial e índice
+void Editor::unpark(Parked&& in) {
+    buf_ = std::move(in.buf);
+    // El historial vuelve con el presupuesto que tenga el editor
+    size_t budget = undo_.budget();
+    undo_ = std::move(in.undo);
+    undo_.setBudget(budget);
+    if (in.index) index_ = std::move(in.index);
+    else index_->reset();
+    hl_.reset();
+    cols_.reset();
+    layout_.reset(width_);
+    dirty_ = in.dirty;
+
+    // Con carga en segundo plano puede que aún no estén esas líneas
+    buf_.ensureLines(std::max(in.curRow, in.viewRow) + height_);
+    curRow_  = std::max(0, std::min(in.curRow, lineCount() - 1));
+    curCol_  = std::min(in.curCol, lineLen(curRow_));
+    viewRow_ = std::min(in.viewRow, curRow_);
+    viewCol_ = in.viewCol;
+    viewSub_ = viewRow_ == in.viewRow ? in.viewSub : 0;
+    scrollToCursor();
+    damageAll();
+    maintainIndex();
+}
+
+size_t Editor::memoryBytes() const {
+    return buf_.memoryBytes() + undo_.memoryBytes() + index_->memoryBytes();
 }
 
 void Editor::insertText(const std::string& text) {
-    for (char c : text) {
-        if (c == '\n') insertNewline();
-        else           insertChar((unsigned char)c);
+    if (text.empty()) return;
+    uint64_t at = offsetOf(curRow_, curCol_);
+    const std::string& eol = buf_.eol();
+    uint64_t inserted = text.size();
+    undo_.seal();
+    if (eol == "\n") {
+        insertAt(at, text);
+    } else {
+        std::string conv;
+        conv.reserve(text.size() + text.size() / 32);
+        size_t pos = 0, nl;
+        while ((nl = text.find('\n', pos)) != std::string::npos) {
+            conv.append(text, pos, nl - pos);
+            conv += eol;
+            pos = nl + 1;
+        }
+        conv.append(text, pos, std::string::npos);
+        insertAt(at, conv);
+        inserted = conv.size();
+    }
+    undo_.seal();
+    dirty_ = true;
+    setCursorOffset(at + inserted);
+}
+
+void Editor::pasteText(const std::string& text) {
+    if (text.find('\r') == std::string::npos) {
+        insertText(text);
+        return;
+    }
+    std::string norm;
+    norm.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '\r') {
+            norm += text[i];
+            continue;
+        }
+        if (i + 1 < text.size() && text[i + 1] == '\n') ++i;
+        norm += '\n';
     }
+    insertText(norm);
 }
 
 std::string Editor::getText() const {
     std::ostringstream oss;
-    for (size_t i = 0; i < lines_.size(); ++i) {
+    for (int i = 0; i < lineCount(); ++i) {
         if (i) oss << '\n';
-        oss << lines_[i];
+        oss << buf_.line(i);
     }
     return oss.str();
 }
 
+void Editor::setSyntax(const std::string& format) {
+    hl_.setGrammar(GrammarRegistry::create(format));
+    damageAll();
+}
+
+bool Editor::pollHighlight() {
+    if (!hlPending_) return false;
+    hl_.settle(viewRow_, lineCount(), kHighlightIdle);
+    return true;
+}
+
+bool Editor::pollLoad() {
+    bool changed = buf_.pollBackgroundLoad();
+    if (changed && !buf_.backgroundLoading()) maintainIndex();
+    return changed;
+}
+
+void Editor::setCursorOffset(uint64_t offset) {
+    offset  = std::min(offset, buf_.size());
+    curRow_ = buf_.lineAt(offset);
+    curCol_ = (int)(offset - buf_.lineStart(curRow_));
+    scrollToCursor();
+}
+
+void Editor::visibleRange(uint64_t& from, uint64_t& to) const {
+    int last = std::min(viewRow_ + height_, lineCount());
+    from = buf_.lineStart(std::min(viewRow_, last));
+    to   = last < buf_.lineCount() ? buf_.lineStart(last) : buf_.size();
+}
+
+void Editor::setHighlights(const std::vector<uint64_t>* offsets, uint64_t length) {
+    if (offsets == hits_ && length == hitLen_) return;
+    hits_   = offsets;
+    hitLen_ = length;
+    damageAll();
+}
+
 void Editor::gotoLine(int line) {
-    line = std::max(1, std::min(line, (int)lines_.size()));
+    buf_.ensureLines(line);
+    line = std::max(1, std::min(line, lineCount()));
     curRow_ = line - 1;
     curCol_ = 0;
     scrollToCursor();
@@ -294,35 +811,72 @@ void Editor::gotoLine(int line) {
 int Editor::findReplace(const std::string& needle,
                         const std::string& replacement,
                         bool caseSensitive,
-                        bool replaceAll) {
+                        bool replaceAll,
+                        bool regex,
+                        const std::function<void(double)>& progress) {
     if (needle.empty()) return 0;
     int count = 0;
 
-    auto strFind = [&](const std::string& haystack, size_t from) -> size_t {
-        if (caseSensitive) {
-            return haystack.find(needle, from);
-        } else {
-            std::string h = haystack, n = needle;
-            std::transform(h.begin(), h.end(), h.begin(), ::tolower);
-            std::transform(n.begin(), n.end(), n.begin(), ::tolower);
-            return h.find(n, from);
+    // Un buscar y reemplazar es un único paso de deshacer
+    struct UndoGroup {
+        UndoLog& log;
+        explicit UndoGroup(UndoLog& l) : log(l) { log.beginGroup(); }
+        ~UndoGroup() { log.endGroup(); }
+    } group(undo_);
+
+    // Reemplazar todo abarca el documento completo: si hay carga en
+    // segundo plano, se espera a que termine. Un solo reemplazo busca
+    // sólo en lo ya cargado.
+    if (replaceAll || !buf_.backgroundLoading()) buf_.loadAll();
+
+    if (regex) {
+        std::string error;
+        std::shared_ptr<const Regex> re = Regex::compile(needle, caseSensitive, error);
+        if (!re) {
+            lastError_ = error;
+            return -1;
         }
-    };
+        return regexReplace(re, replacement, replaceAll, progress);
+    }
 
-    for (int r = 0; r < (int)lines_.size(); ++r) {
-        size_t pos = 0;
-        while ((pos = strFind(lines_[r], pos)) != std::string::npos) {
-            lines_[r].replace(pos, needle.size(), replacement);
-            pos += replacement.size();
-            ++count;
-            dirty_ = true;
-            if (!replaceAll) {
-                // Mover cursor al primer resultado
-                curRow_ = r;
-                curCol_ = (int)pos - (int)replacement.size();
+    // Una aguja sin saltos de línea no cruza líneas: se puede repartir
+    if (replaceAll && needle.find('\n') == std::string::npos)
+        return replaceAllParallel(needle, replacement, caseSensitive, progress);
+
+    // Se busca directamente sobre las piezas, sin copiar líneas. Para
+    // una sola coincidencia basta con los bloques candidatos del índice.
+    SearchKernel kernel(needle, caseSensitive);
+    if (!replaceAll) {
+        TrigramIndex::Ranges ranges;
+        if (searchRanges(needle, ranges)) {
+            for (auto& r : ranges) {
+                uint64_t at = kernel.find(buf_, r.first, r.second);
+                if (at == SearchKernel::npos) continue;
+                eraseAt(at, needle.size());
+                insertAt(at, replacement);
+                dirty_ = true;
+                curRow_ = buf_.lineAt(at);
+                curCol_ = (int)(at - buf_.lineStart(curRow_));
                 scrollToCursor();
-                return count;
+                return 1;
             }
+            return 0;
+        }
+    }
+    uint64_t pos = 0;
+    uint64_t at;
+    while ((at = kernel.find(buf_, pos, buf_.size())) != SearchKernel::npos) {
+        eraseAt(at, needle.size());
+        insertAt(at, replacement);
+        pos = at + replacement.size();
+        ++count;
+        dirty_ = true;
+        if (!replaceAll) {
+            // Mover cursor al primer resultado
+            curRow_ = buf_.lineAt(at);
+            curCol_ = (int)(at - buf_.lineStart(curRow_));
+            scrollToCursor();
+            return count;
         }
     }
     if (count > 0 && replaceAll) {
@@ -331,3 +885,284 @@ int Editor::findReplace(const std::string& needle,
     }
     return count;
 }
+
+// ── Índice de trigramas ───────────────────────────────────────────
+// Se construye en segundo plano cuando el documento está completo; las
+// ediciones lo mantienen (marcando bloques sucios) y al buscar con
+// bloques sucios se reconstruye sin dejar de usar el anterior.
+void Editor::maintainIndex() {
+    if (!buf_.fullyLoaded() || buf_.backgroundLoading() || index_->building()) return;
+    if (buf_.size() < kIndexMinBytes) return;
+    if (!index_->ready() || index_->stale()) index_->build(buf_.snapshot());
+}
+
+bool Editor::searchRanges(const std::string& needle, TrigramIndex::Ranges& out) {
+    bool ok = index_->candidates(needle, buf_.size(), out);
+    maintainIndex();
+    return ok;
+}
+
+// ── Reemplazar todo en paralelo ───────────────────────────────────
+// El documento se parte en rangos de líneas completas y cada tarea del
+// pool junta las coincidencias de su rango. Luego se aplican todas
+// juntas como una única edición: el resultado es el mismo que el del
+// recorrido secuencial (coincidencias más a la izquierda, sin solaparse).
+std::vector<uint64_t> Editor::lineRanges() const {
+    const TextBuffer& doc = buf_;
+    uint64_t size = doc.size();
+    uint64_t ranges = std::max<uint64_t>(1, std::min<uint64_t>(
+        size / kReplaceRangeBytes, (uint64_t)ThreadPool::shared().size() * 8));
+    std::vector<uint64_t> bounds{ 0 };
+    for (uint64_t k = 1; k < ranges; ++k) {
+        uint64_t b = doc.lineStart(doc.lineAt(size * k / ranges));
+        if (b > bounds.back()) bounds.push_back(b);
+    }
+    bounds.push_back(size);
+    return bounds;
+}
+
+void Editor::runRanges(size_t n, const std::function<void(size_t)>& task,
+                       const std::function<void(double)>& progress) const {
+    ThreadPool& pool = ThreadPool::shared();
+    std::atomic<size_t> finished(0);
+    std::vector<std::future<void>> tasks;
+    for (size_t i = 0; i < n; ++i) {
+        tasks.push_back(pool.submit([&, i] {
+            task(i);
+            ++finished;
+        }));
+    }
+    for (auto& t : tasks) {
+        while (t.wait_for(std::chrono::milliseconds(50)) != std::future_status::ready)
+            if (progress) progress((double)finished / (double)n);
+        t.get();
+    }
+}
+
+int Editor::replaceAllParallel(const std::string& needle,
+                               const std::string& replacement,
+                               bool caseSensitive,
+                               const std::function<void(double)>& progress) {
+    // Los rangos cubren el documento entero: con una carga en curso
+    // quedaría sin tocar lo que falta (findReplace espera antes)
+    if (!buf_.fullyLoaded() || buf_.backgroundLoading()) {
+        lastError_ = "El documento todavía se está cargando.";
+        return -1;
+    }
+    const TextBuffer& doc = buf_;
+    std::vector<uint64_t> bounds = lineRanges();
+    size_t n = bounds.size() - 1;
+
+    // Cada tarea recorre sólo la parte de su rango que el índice no descarta
+    TrigramIndex::Ranges candidates;
+    if (!searchRanges(needle, candidates)) candidates.push_back({ 0, doc.size() });
+
+    // Para deshacer: sin distinguir mayúsculas cada coincidencia puede
+    // ser distinta y se copia; si no, todas son `needle`
+    bool sameText = caseSensitive ||
+        std::none_of(needle.begin(), needle.end(), [](char c) { return std::isalpha((unsigned char)c); });
+
+    SearchKernel kernel(needle, caseSensitive);
+    std::vector<std::vector<uint64_t>> found(n);
+    std::vector<std::string> removed(sameText ? 0 : n);
+    runRanges(n, [&](size_t i) {
+        auto it = std::upper_bound(candidates.begin(), candidates.end(), bounds[i],
+            [](uint64_t v, const std::pair<uint64_t, uint64_t>& r) { return v < r.second; });
+        for (; it != candidates.end() && it->first < bounds[i + 1]; ++it) {
+            uint64_t pos = std::max(bounds[i], it->first);
+            uint64_t end = std::min(bounds[i + 1], it->second);
+            uint64_t at;
+            while ((at = kernel.find(doc, pos, end)) != SearchKernel::npos) {
+                found[i].push_back(at);
+                if (!sameText)
+                    doc.forEachSpan(at, needle.size(), [&](const char* p, size_t len) {
+                        removed[i].append(p, len);
+                    });
+                pos = at + needle.size();
+            }
+        }
+    }, progress);
+
+    std::vector<uint64_t> matches;
+    for (auto& f : found) matches.insert(matches.end(), f.begin(), f.end());
+    if (matches.empty()) return 0;
+
+    UndoLog::Step step;
+    step.deltas.reserve(matches.size());
+    for (uint64_t m : matches) step.deltas.push_back({ m, needle.size(), replacement.size() });
+    step.sameRemoved  = sameText;
+    step.sameInserted = true;
+    step.inserted     = replacement;
+    if (sameText) {
+        step.removed = needle;
+    } else {
+        step.removed.reserve(matches.size() * needle.size());
+        for (auto& r : removed) step.removed += r;
+    }
+
+    bulkReplace(matches, needle.size(), replacement);
+    undo_.recordBulk(std::move(step));
+    curRow_ = 0; curCol_ = 0;
+    scrollToCursor();
+    return (int)matches.size();
+}
+
+// ── Buscar y reemplazar con expresiones regulares ─────────────────
+// El DFA de cada RegexMatcher descarta las líneas sin coincidencia
+// recorriendo las piezas; sólo las candidatas se copian para extraer
+// las coincidencias y sus grupos. Reemplazar todo usa los mismos rangos
+// que la búsqueda literal, con un RegexMatcher por tarea.
+int Editor::regexReplace(const std::shared_ptr<const Regex>& re,
+                         const std::string& replacement,
+                         bool replaceAll,
+                         const std::function<void(double)>& progress) {
+    const TextBuffer& doc = buf_;
+
+    // Coincidencias de una línea candidata; false si no hubo ninguna
+    // `removed` (si no es nullptr) recibe lo que quita cada coincidencia
+    auto matchLine = [&](RegexMatcher& m, uint64_t start, uint64_t end,
+                         std::vector<TextEdit>& out, std::string* removed, bool firstOnly) {
+        std::string line = doc.substr(start, end - start);
+        std::vector<long> caps;
+        size_t before = out.size();
+        size_t pos = 0;
+        while (pos <= line.size() && m.search(line.data(), line.size(), pos, caps)) {
+            out.push_back({ start + caps[0], (uint64_t)(caps[1] - caps[0]),
+                            re->expand(replacement, line.data(), caps) });
+            if (removed) removed->append(line, caps[0], caps[1] - caps[0]);
+            if (firstOnly) break;
+            pos = caps[1] > caps[0] ? caps[1] : caps[1] + 1;
+        }
+        return out.size() > before;
+    };
+
+    if (!replaceAll) {
+        RegexMatcher m(re);
+        std::vector<TextEdit> edit;
+        m.scanLines(doc, 0, doc.size(), [&](uint64_t start, uint64_t end) {
+            return !matchLine(m, start, end, edit, nullptr, true);
+        });
+        if (edit.empty()) return 0;
+
+        const TextEdit& e = edit[0];
+        eraseAt(e.offset, e.length);
+        insertAt(e.offset, e.text);
+        dirty_ = true;
+        curRow_ = buf_.lineAt(e.offset);
+        curCol_ = (int)(e.offset - buf_.lineStart(curRow_));
+        scrollToCursor();
+        return 1;
+    }
+
+    std::vector<uint64_t> bounds = lineRanges();
+    size_t n = bounds.size() - 1;
+    std::vector<std::vector<TextEdit>> found(n);
+    std::vector<std::string> removed(n);
+    runRanges(n, [&](size_t i) {
+        RegexMatcher m(re);
+        m.scanLines(doc, bounds[i], bounds[i + 1], [&](uint64_t start, uint64_t end) {
+            matchLine(m, start, end, found[i], &removed[i], false);
+            return true;
+        });
+    }, progress);
+
+    std::vector<TextEdit> edits;
+    size_t total = 0;
+    for (auto& f : found) total += f.size();
+    edits.reserve(total);
+    for (auto& f : found)
+        for (auto& e : f) edits.push_back(std::move(e));
+    if (edits.empty()) return 0;
+
+    UndoLog::Step step;
+    step.deltas.reserve(edits.size());
+    for (auto& r : removed) step.removed += r;
+    for (const TextEdit& e : edits) {
+        step.deltas.push_back({ e.offset, e.length, e.text.size() });
+        step.inserted += e.text;
+    }
+
+    bulkEdits(edits);
+    undo_.recordBulk(std::move(step));
+    curRow_ = 0; curCol_ = 0;
+    scrollToCursor();
+    return (int)edits.size();
+}
+
+// ── Deshacer / rehacer ────────────────────────────────────────────
+bool Editor::undo() {
+    const UndoLog::Step* step = undo_.undo();
+    if (!step) return false;
+    applyStep(*step, true);
+    return true;
+}
+
+bool Editor::redo() {
+    const UndoLog::Step* step = undo_.redo();
+    if (!step) return false;
+    applyStep(*step, false);
+    return true;
+}
+
+// Deshacer aplica cada tramo al revés: donde quedó lo puesto vuelve lo
+// quitado. Un paso masivo se invierte en bloque, igual que se hizo.
+void Editor::applyStep(const UndoLog::Step& step, bool undo) {
+    const std::vector<UndoLog::Delta>& ds = step.deltas;
+    const std::string& before = undo ? step.inserted : step.removed;   // lo que hay ahora
+    const std::string& after  = undo ? step.removed  : step.inserted;  // lo que tiene que quedar
+    bool sameBefore = undo ? step.sameInserted : step.sameRemoved;
+    bool sameAfter  = undo ? step.sameRemoved  : step.sameInserted;
+    auto lenBefore = [&](const UndoLog::Delta& d) { return undo ? d.inserted : d.removed; };
+    auto lenAfter  = [&](const UndoLog::Delta& d) { return undo ? d.removed : d.inserted; };
+
+    undo_.setPaused(true);
+    uint64_t cursor;
+    if (step.bulk) {
+        // Offsets del paso: del documento previo a hacerlo. Al deshacer,
+        // cada tramo anterior ya corrió los siguientes.
+        uint64_t added = 0, removed = 0;
+        if (sameBefore && sameAfter) {
+            std::vector<uint64_t> offsets;
+            offsets.reserve(ds.size());
+            for (const UndoLog::Delta& d : ds) {
+                offsets.push_back(undo ? d.offset + added - removed : d.offset);
+                added += d.inserted;
+                removed += d.removed;
+            }
+            bulkReplace(offsets, before.size(), after);
+        } else {
+            std::vector<TextEdit> edits;
+            edits.reserve(ds.size());
+            size_t at = 0;
+            for (const UndoLog::Delta& d : ds) {
+                uint64_t n = lenAfter(d);
+                edits.push_back({ undo ? d.offset + added - removed : d.offset, lenBefore(d),
+                                  sameAfter ? after : after.substr(at, (size_t)n) });
+                at += (size_t)n;
+                added += d.inserted;
+                removed += d.removed;
+            }
+            bulkEdits(edits);
+        }
+        cursor = ds.front().offset;
+    } else {
+        // Inicio del texto a poner de cada tramo
+        std::vector<size_t> posAfter(ds.size());
+        size_t pa = 0;
+        for (size_t i = 0; i < ds.size(); ++i) {
+            posAfter[i] = pa;
+            pa += (size_t)lenAfter(ds[i]);
+        }
+        for (size_t k = 0; k < ds.size(); ++k) {
+            size_t i = undo ? ds.size() - 1 - k : k;
+            const UndoLog::Delta& d = ds[i];
+            if (lenBefore(d)) eraseAt(d.offset, lenBefore(d));
+            if (lenAfter(d))  insertAt(d.offset, after.substr(posAfter[i], (size_t)lenAfter(d)));
+        }
+        const UndoLog::Delta& d = undo ? ds.front() : ds.back();
+        cursor = d.offset + lenAfter(d);
+        dirty_ = true;
+    }
+    undo_.setPaused(false);
+    setCursorOffset(cursor);
+}
@@ -0,0 +1,427 @@
+#include "exporter.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EXPORTER_X86 1
+#endif
+
+// ── Salida ────────────────────────────────────────────────────────
+// Buffer de salida; un volcado sale al llenarlo o al juntar kIovBatch
+// tramos / kWriteBatch bytes pendientes
+static const size_t kBufSize    = 8u << 20;
+static const int    kIovBatch   = 1024;
+static const size_t kWriteBatch = 8u << 20;
+// Por debajo de esto copiar es más barato que un tramo más en writev
+static const size_t kMinRef     = 4096;
+
+ExportSink::ExportSink(int fd, TextEncoding encoding)
+    : fd_(fd), buf_(new char[kBufSize]), used_(0), mark_(0), pending_(0),
+      enc_(encoding), carryLen_(0)
+{
+    std::string bom = Transcoder::bom(enc_);
+    memcpy(buf_.get(), bom.data(), bom.size());
+    used_ = bom.size();
+}
+
+void ExportSink::seal() {
+    if (used_ == mark_) return;
+    iov_.push_back({ buf_.get() + mark_, used_ - mark_ });
+    pending_ += used_ - mark_;
+    mark_ = used_;
+}
+
+bool ExportSink::put(const char* p, size_t n) {
+    if (enc_.charset != Charset::UTF8) return encode(p, n, false);
+    while (n > 0) {
+        if (used_ == kBufSize && !flush()) return false;
+        size_t k = std::min(n, kBufSize - used_);
+        memcpy(buf_.get() + used_, p, k);
+        used_ += k;
+        p += k;
+        n -= k;
+    }
+    return true;
+}
+
+bool ExportSink::putRef(const char* p, size_t n) {
+    if (n < kMinRef || enc_.charset != Charset::UTF8) return put(p, n);
+    seal();
+    iov_.push_back({ const_cast<char*>(p), n });
+    pending_ += n;
+    if ((int)iov_.size() >= kIovBatch || pending_ >= kWriteBatch) return flush();
+    return true;
+}
+
+// De UTF-8 a la codificación del archivo, directo al buffer. Los
+// tramos de la instantánea pueden cortar un carácter: sus primeros
+// bytes esperan en carry_ al put siguiente.
+bool ExportSink::encode(const char* p, size_t n, bool last) {
+    size_t written;
+    if (carryLen_ > 0) {
+        char   tmp[8];
+        size_t take = std::min(n, (size_t)(4 - carryLen_));
+        memcpy(tmp, carry_, carryLen_);
+        memcpy(tmp + carryLen_, p, take);
+        size_t len = carryLen_ + take;
+        if (kBufSize - used_ < 16 && !flush()) return false;
+        size_t used = Transcoder::fromUtf8(enc_.charset, tmp, len, buf_.get() + used_, written,
+                                           last && take == n);
+        used_ += written;
+        if (used < (size_t)carryLen_) {
+            // Todavía incompleto: el tramo era más corto que el carácter
+            memcpy(carry_, tmp, len);
+            carryLen_ = (int)len;
+            return true;
+        }
+        p += used - carryLen_;
+        n -= used - carryLen_;
+        carryLen_ = 0;
+    }
+    while (n > 0) {
+        if (kBufSize - used_ < 16 && !flush()) return false;
+        // Cada byte de UTF-8 da a lo sumo dos
+        size_t k    = std::min(n, (kBufSize - used_) / 2);
+        size_t used = Transcoder::fromUtf8(enc_.charset, p, k, buf_.get() + used_, written,
+                                           last && k == n);
+        used_ += written;
+        if (used == 0) {
+            memcpy(carry_, p, n);
+            carryLen_ = (int)n;
+            return true;
+        }
+        p += used;
+        n -= used;
+    }
+    return true;
+}
+
+bool ExportSink::finish() {
+    if (carryLen_ > 0 && !encode("", 0, true)) return false;
+    return flush();
+}
+
+bool ExportSink::flush() {
+    seal();
+    size_t i = 0;
+    while (i < iov_.size()) {
+        int cnt = (int)std::min<size_t>(iov_.size() - i, kIovBatch);
+        ssize_t n = ::writev(fd_, &iov_[i], cnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        // Escritura parcial: avanzar dentro de los tramos
+        size_t left = (size_t)n;
+        while (left > 0 && i < iov_.size()) {
+            if (left >= iov_[i].iov_len) {
+                left -= iov_[i].iov_len;
+                ++i;
+            } else {
+                iov_[i].iov_base = (char*)iov_[i].iov_base + left;
+                iov_[i].iov_len -= left;
+                left = 0;
+            }
+        }
+    }
+    iov_.clear();
+    pending_ = 0;
+    used_ = mark_ = 0;
+    return true;
+}
+
+// ── Bytes especiales ──────────────────────────────────────────────
+// Se clasifica el texto de a bloques de kChunk bytes: un bit por byte
+// que está en el conjunto (hasta kMaxSet bytes). Entre bit y bit hay
+// tramos limpios que se copian (o referencian) de una vez.
+static const int    kMaxSet = 6;
+static const size_t kChunk  = 4096;
+
+struct ByteSet {
+    int  n;
+    char c[kMaxSet];
+    bool table[256];
+
+    explicit ByteSet(const char* chars) : n(0), c(), table() {
+        for (; chars[n]; ++n) {
+            c[n] = chars[n];
+            table[(unsigned char)chars[n]] = true;
+        }
+    }
+};
+
+// Llena masks[0 .. ceil(n/64)) para p[0 .. n), n <= kChunk
+typedef void (*MaskFn)(const char*, size_t, const ByteSet&, uint64_t*);
+
+static void maskScalar(const char* p, size_t n, const ByteSet& set, uint64_t* masks) {
+    for (size_t w = 0; w * 64 < n; ++w) {
+        uint64_t m = 0;
+        size_t end = std::min<size_t>(64, n - w * 64);
+        for (size_t i = 0; i < end; ++i)
+            if (set.table[(unsigned char)p[w * 64 + i]]) m |= (uint64_t)1 << i;
+        masks[w] = m;
+    }
+}
+
+#ifdef EXPORTER_X86
+#ifdef __SSE2__
+static void maskSse2(const char* p, size_t n, const ByteSet& set, uint64_t* masks) {
+    __m128i v[kMaxSet];
+    for (int k = 0; k < set.n; ++k) v[k] = _mm_set1_epi8(set.c[k]);
+    size_t w = 0;
+    for (; (w + 1) * 64 <= n; ++w) {
+        uint64_t m = 0;
+        for (int j = 0; j < 4; ++j) {
+            __m128i x   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + w * 64 + j * 16));
+            __m128i acc = _mm_cmpeq_epi8(x, v[0]);
+            for (int k = 1; k < set.n; ++k) acc = _mm_or_si128(acc, _mm_cmpeq_epi8(x, v[k]));
+            m |= (uint64_t)(unsigned)_mm_movemask_epi8(acc) << (j * 16);
+        }
+        masks[w] = m;
+    }
+    if (w * 64 < n) maskScalar(p + w * 64, n - w * 64, set, masks + w);
+}
+#endif
+
+__attribute__((target("avx2")))
+static void maskAvx2(const char* p, size_t n, const ByteSet& set, uint64_t* masks) {
+    __m256i v[kMaxSet];
+    for (int k = 0; k < set.n; ++k) v[k] = _mm256_set1_epi8(set.c[k]);
+    size_t w = 0;
+    for (; (w + 1) * 64 <= n; ++w) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + w * 64));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + w * 64 + 32));
+        __m256i a  = _mm256_cmpeq_epi8(lo, v[0]);
+        __m256i b  = _mm256_cmpeq_epi8(hi, v[0]);
+        for (int k = 1; k < set.n; ++k) {
+            a = _mm256_or_si256(a, _mm256_cmpeq_epi8(lo, v[k]));
+            b = _mm256_or_si256(b, _mm256_cmpeq_epi8(hi, v[k]));
+        }
+        masks[w] = (uint64_t)(unsigned)_mm256_movemask_epi8(a) |
+                   (uint64_t)(unsigned)_mm256_movemask_epi8(b) << 32;
+    }
+    if (w * 64 < n) maskScalar(p + w * 64, n - w * 64, set, masks + w);
+}
+#endif
+
+static MaskFn pickMask() {
+#ifdef EXPORTER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return maskAvx2;
+#ifdef __SSE2__
+    return maskSse2;
+#endif
+#endif
+    return maskScalar;
+}
+
+static MaskFn gMask = pickMask();
+
+// Llama fn(i) por cada byte especial de p[0 .. n), en orden
+template <class Fn>
+static bool forEachSpecial(const char* p, size_t n, const ByteSet& set, Fn&& fn) {
+    uint64_t masks[kChunk / 64];
+    for (size_t base = 0; base < n; base += kChunk) {
+        size_t len = std::min(kChunk, n - base);
+        gMask(p + base, len, set, masks);
+        for (size_t w = 0; w * 64 < len; ++w) {
+            for (uint64_t m = masks[w]; m; m &= m - 1)
+                if (!fn(base + w * 64 + (size_t)__builtin_ctzll(m))) return false;
+        }
+    }
+    return true;
+}
+
+// ── Texto plano (TXT, MD) ─────────────────────────────────────────
+// Se vuelcan las piezas tal cual (respeta CRLF), sin copiarlas
+class RawExporter : public Exporter {
+public:
+    bool write(const TextSnapshot& snap, ExportSink& out,
+               std::atomic<uint64_t>* written) override {
+        return snap.forEachSpanWhile(0, snap.size(), [&](const char* p, size_t n) {
+            if (!out.putRef(p, n)) return false;
+            if (written) *written += n;
+            return true;
+        });
+    }
+};
+
+// ── HTML ──────────────────────────────────────────────────────────
+// Cada línea (sin el '\r' de CRLF) termina en "<br>\n", también la
+// última; & < > " se escapan.
+class HtmlExporter : public Exporter {
+public:
+    bool write(const TextSnapshot& snap, ExportSink& out,
+               std::atomic<uint64_t>* written) override {
+        static const ByteSet special("&<>\"\n\r");
+        if (!out.put("<!DOCTYPE html>\n<html>\n<head>\n"
+                     "<meta charset=\"UTF-8\">\n"
+                     "<title>Documento</title>\n"
+                     "<style>body{font-family:monospace;white-space:pre-wrap;}</style>\n"
+                     "</head>\n<body>\n"))
+            return false;
+
+        // '\r' al final de un tramo: sólo se sabe si es de un CRLF al
+        // ver el siguiente
+        bool cr = false;
+        bool ok = snap.forEachSpanWhile(0, snap.size(), [&](const char* p, size_t n) {
+            if (cr && n > 0) {
+                cr = false;
+                if (p[0] != '\n' && !out.put('\r')) return false;
+            }
+            size_t from = 0;   // inicio del tramo limpio en curso
+            bool ok = forEachSpecial(p, n, special, [&](size_t i) {
+                const char* rep;
+                size_t      len;
+                switch (p[i]) {
+                case '&':  rep = "&amp;";  len = 5; break;
+                case '<':  rep = "&lt;";   len = 4; break;
+                case '>':  rep = "&gt;";   len = 4; break;
+                case '"':  rep = "&quot;"; len = 6; break;
+                case '\n': rep = "<br>\n"; len = 5; break;
+                default:
+                    // '\r': se quita si le sigue '\n'; si no, queda en el tramo
+                    if (i + 1 < n && p[i + 1] != '\n') return true;
+                    if (i + 1 == n) cr = true;
+                    rep = "";
+                    len = 0;
+                    break;
+                }
+                if (!out.putRef(p + from, i - from) || !out.put(rep, len)) return false;
+                from = i + 1;
+                return true;
+            });
+            if (!ok || !out.putRef(p + from, n - from)) return false;
+            if (written) *written += n;
+            return true;
+        });
+        // Un '\r' al final del documento también se quita
+        return ok && out.put("<br>\n</body>\n</html>\n");
+    }
+};
+
+// ── CSV ───────────────────────────────────────────────────────────
+// Cada línea es una fila de una sola columna; si tiene comas o
+// comillas va entre comillas, con las comillas duplicadas.
+class CsvExporter : public Exporter {
+public:
+    bool write(const TextSnapshot& snap, ExportSink& out,
+               std::atomic<uint64_t>* written) override {
+        static const ByteSet lineOrQuote("\n,\"");
+
+        // La línea en curso empieza en lineStart; quotes: ya se vio , o "
+        uint64_t lineStart = 0;
+        uint64_t spanStart = 0;
+        bool     quotes    = false;
+        bool ok = snap.forEachSpanWhile(0, snap.size(), [&](const char* p, size_t n) {
+            bool ok = forEachSpecial(p, n, lineOrQuote, [&](size_t i) {
+                if (p[i] != '\n') {
+                    quotes = true;
+                    return true;
+                }
+                uint64_t end = spanStart + i;
+                if (!row(snap, out, lineStart, end, p, spanStart, quotes)) return false;
+                lineStart = end + 1;
+                quotes    = false;
+                return true;
+            });
+            if (!ok) return false;
+            spanStart += n;
+            if (written) *written += n;
+            return true;
+        });
+        // La última línea va siempre, aunque esté vacía
+        return ok && row(snap, out, lineStart, snap.size(), nullptr, spanStart, quotes);
+    }
+
+private:
+    // Escribe la fila [start, end) (sin '\n'). Si empieza en el tramo
+    // actual (p, desde spanStart) se toma de ahí; si no, de la instantánea.
+    static bool row(const TextSnapshot& snap, ExportSink& out, uint64_t start, uint64_t end,
+                    const char* p, uint64_t spanStart, bool quotes) {
+        if (end > start) {
+            char last = (p && end > spanStart) ? p[end - 1 - spanStart]
+                                               : snap.substr(end - 1, 1)[0];
+            if (last == '\r') --end;
+        }
+        auto emit = [&](const char* s, size_t n) {
+            if (!quotes) return out.putRef(s, n);
+            // Comillas duplicadas
+            while (n > 0) {
+                const char* q = (const char*)memchr(s, '"', n);
+                size_t k = q ? (size_t)(q - s) + 1 : n;
+                if (!out.putRef(s, k)) return false;
+                if (q && !out.put('"')) return false;
+                s += k;
+                n -= k;
+            }
+            return true;
+        };
+
+        if (quotes && !out.put('"')) return false;
+        bool ok;
+        if (p && start >= spanStart)
+            ok = emit(p + (start - spanStart), (size_t)(end - start));
+        else
+            ok = snap.forEachSpanWhile(start, end - start, emit);
+        if (!ok) return false;
+        if (quotes && !out.put('"')) return false;
+        return out.put('\n');
+    }
+};
+
+// ── Registro ──────────────────────────────────────────────────────
+static std::vector<ExportFormat>& registry() {
+    static std::vector<ExportFormat> formats = {
+        { FileFormat::TXT,  "txt",  "TXT  - Texto plano",       { "txt" },            true,
+          [] { return std::unique_ptr<Exporter>(new RawExporter()); } },
+        { FileFormat::MD,   "md",   "MD   - Markdown",          { "md", "markdown" }, true,
+          [] { return std::unique_ptr<Exporter>(new RawExporter()); } },
+        { FileFormat::HTML, "html", "HTML - Página web",        { "html", "htm" },    false,
+          [] { return std::unique_ptr<Exporter>(new HtmlExporter()); } },
+        { FileFormat::CSV,  "csv",  "CSV  - Valores separados", { "csv" },            false,
+          [] { return std::unique_ptr<Exporter>(new CsvExporter()); } },
+    };
+    return formats;
+}
+
+void ExporterRegistry::add(ExportFormat fmt) {
+    std::vector<ExportFormat>& formats = registry();
+    for (ExportFormat& f : formats) {
+        if (f.format == fmt.format) {
+            f = std::move(fmt);
+            return;
+        }
+    }
+    formats.push_back(std::move(fmt));
+}
+
+const std::vector<ExportFormat>& ExporterRegistry::formats() {
+    return registry();
+}
+
+const ExportFormat* ExporterRegistry::find(FileFormat fmt) {
+    for (const ExportFormat& f : registry())
+        if (f.format == fmt) return &f;
+    return nullptr;
+}
+
+const ExportFormat* ExporterRegistry::byExtension(const std::string& ext) {
+    for (const ExportFormat& f : registry())
+        if (std::find(f.extensions.begin(), f.extensions.end(), ext) != f.extensions.end())
+            return &f;
+    return nullptr;
+}
+
+std::unique_ptr<Exporter> ExporterRegistry::create(FileFormat fmt) {
+    const ExportFormat* f = find(fmt);
+    return f && f->create ? f->create() : nullptr;
+}
+
+bool ExporterRegistry::isRaw(FileFormat fmt) {
+    const ExportFormat* f = find(fmt);
+    return f && f->raw;
+}
@@ -1,89 +1,189 @@
 #include "filemanager.h"
-#include <fstream>
-#include <sstream>
+#include "saveworker.h"
+#include "exporter.h"
+#include "mappedfile.h"
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Archivos de carga perezosa: la codificación se deduce del comienzo,
+// sin leerlos enteros al abrir
+static const size_t kSniffBytes = 1u << 20;
+
+// ── Helpers internos ──────────────────────────────────────────────
+
+// Parche en el lugar: escribe sólo los tramos que cambiaron respecto
+// del original mapeado. Las piezas que siguen leyendo del mapeo nunca
+// cubren esos tramos, así que pisarlos en disco no altera el documento.
+enum class PatchResult { NotApplicable, Done, Failed };
+
+static PatchResult patchInPlace(const std::string& path, const TextSnapshot& snap,
+                                FsyncPolicy policy, std::atomic<uint64_t>* written,
+                                std::string* error) {
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    if (!snap.patchRanges(ranges)) return PatchResult::NotApplicable;
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return PatchResult::NotApplicable;
+
+    // Otro inodo (p. ej. tras un guardado con rename) o tocado por
+    // otro programa: el mapeo ya no describe lo que hay en disco
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !snap.original()->unchangedOnDisk(st)) {
+        ::close(fd);
+        return PatchResult::NotApplicable;
+    }
+
+    bool ok = true;
+    for (const auto& r : ranges) {
+        uint64_t pos = r.first;
+        ok = snap.forEachSpanWhile(r.first, r.second - r.first, [&](const char* p, size_t n) {
+            while (n > 0) {
+                ssize_t w = ::pwrite(fd, p, n, (off_t)pos);
+                if (w < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                p += w; n -= (size_t)w; pos += (uint64_t)w;
+            }
+            return true;
+        });
+        if (!ok) break;
+    }
+    // Lo agregado al final en un parche anterior pudo acortarse después
+    if (ok && (uint64_t)st.st_size > snap.size())
+        ok = ftruncate(fd, (off_t)snap.size()) == 0;
+    if (ok && policy != FsyncPolicy::None)
+        ok = fsync(fd) == 0;
+    if (ok && fstat(fd, &st) == 0)
+        snap.original()->noteWritten(st);
+
+    if (!ok && error) *error = std::string("No se pudo parchear: ") + strerror(errno);
+    ::close(fd);
+    if (!ok) return PatchResult::Failed;
+    if (written) *written = snap.size();
+    return PatchResult::Done;
+}
 
 // ── Cargar archivo ────────────────────────────────────────────────
-bool FileManager::load(const std::string& path, std::vector<std::string>& lines) {
-    std::ifstream f(path);
-    if (!f.is_open()) return false;
-
-    lines.clear();
-    std::string line;
-    while (std::getline(f, line)) {
-        // Eliminar \r si el archivo tiene terminaciones CRLF
-        if (!line.empty() && line.back() == '\r')
-            line.pop_back();
-        lines.push_back(line);
+bool FileManager::load(const std::string& path, TextBuffer& buf, LoadMode mode) {
+    auto file = MappedFile::open(path);
+    if (!file) return false;
+
+    bool big  = (mode == LoadMode::Auto && file->size() >= kLazyThreshold);
+    bool lazy = (mode == LoadMode::Lazy) || big;
+
+    // UTF-8 sin BOM (lo común) se usa tal cual. Lo demás se pasa a UTF-8
+    // de una vez y se suelta el mapeo; al guardar se vuelve a codificar.
+    bool         sniff = lazy && file->size() >= kLazyThreshold;
+    TextEncoding enc   = Transcoder::detect(file->data(), file->size(), sniff ? kSniffBytes : 0);
+    if (!enc.plain()) {
+        std::unique_ptr<char[]> text(new char[Transcoder::utf8Bound(enc, file->size())]);
+        size_t len = Transcoder::toUtf8(enc, file->data(), file->size(), text.get());
+        file = MappedFile::fromMemory(std::move(text), len, enc);
     }
-    // Si el archivo estaba vacío, al menos una línea vacía
-    if (lines.empty()) lines.push_back("");
+
+    // El contenido queda mapeado: la tabla de piezas sólo lo referencia
+    buf = TextBuffer(file, lazy);
+    // Archivos grandes: el resto se indexa en un hilo mientras se edita
+    if (big) buf.startBackgroundLoad();
     return true;
 }
 
 // ── Guardar archivo ────────────────────────────────────────────────
 bool FileManager::save(const std::string& path,
-                       const std::vector<std::string>& lines,
+                       const TextBuffer& buf,
                        FileFormat fmt) {
-    std::ofstream f(path);
-    if (!f.is_open()) return false;
+    return writeSnapshot(path, buf.snapshot(true), fmt, FsyncPolicy::File);
+}
 
-    switch (fmt) {
+std::unique_ptr<SaveWorker> FileManager::saveAsync(const std::string& path,
+                                                   const TextBuffer& buf,
+                                                   FileFormat fmt,
+                                                   FsyncPolicy policy) {
+    return std::make_unique<SaveWorker>(path, buf.snapshot(true), fmt, policy);
+}
 
-    case FileFormat::TXT:
-    case FileFormat::MD:
-        // Texto plano — una línea por salto de línea
-        for (size_t i = 0; i < lines.size(); ++i) {
-            f << lines[i];
-            if (i + 1 < lines.size()) f << '\n';
-        }
-        break;
-
-    case FileFormat::HTML: {
-        f << "<!DOCTYPE html>\n<html>\n<head>\n"
-          << "<meta charset=\"UTF-8\">\n"
-          << "<title>Documento</title>\n"
-          << "<style>body{font-family:monospace;white-space:pre-wrap;}</style>\n"
-          << "</head>\n<body>\n";
-        for (const auto& line : lines) {
-            // Escapar caracteres especiales HTML
-            std::string escaped;
-            for (char c : line) {
-                if      (c == '&')  escaped += "&amp;";
-                else if (c == '<')  escaped += "&lt;";
-                else if (c == '>')  escaped += "&gt;";
-                else if (c == '"')  escaped += "&quot;";
-                else                escaped += c;
-            }
-            f << escaped << "<br>\n";
-        }
-        f << "</body>\n</html>\n";
-        break;
+bool FileManager::writeSnapshot(const std::string& path,
+                                const TextSnapshot& snap,
+                                FileFormat fmt,
+                                FsyncPolicy policy,
+                                std::atomic<uint64_t>* written,
+                                std::string* error) {
+    // Texto plano: en la codificación del archivo que se cargó. Las
+    // exportaciones (HTML, CSV) salen siempre en UTF-8.
+    TextEncoding enc;
+    if (ExporterRegistry::isRaw(fmt) && snap.original()) enc = snap.original()->encoding();
+
+    // Archivos enormes con pocos bytes cambiados: sólo esos tramos. Si
+    // el parche falla, la reescritura completa deja el archivo correcto.
+    if (ExporterRegistry::isRaw(fmt) && enc.plain() &&
+        snap.size() >= kInPlaceThreshold &&
+        patchInPlace(path, snap, policy, written, error) == PatchResult::Done)
+        return true;
+    if (written) *written = 0;
+
+    // El documento puede estar leyendo del archivo mapeado: se escribe
+    // en un temporal y se renombra encima, nunca se trunca el original
+    std::string tmp = path + ".tmp";
+    auto fail = [&](const char* what) {
+        if (error) *error = std::string(what) + ": " + strerror(errno);
+        return false;
+    };
+
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) return fail("No se pudo crear el temporal");
+
+    // Conservar los permisos del archivo reemplazado
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0)
+        fchmod(fd, st.st_mode & 07777);
+
+    // El exportador registrado para el formato (ver ExporterRegistry)
+    std::unique_ptr<Exporter> exporter = ExporterRegistry::create(fmt);
+    if (!exporter) {
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        if (error) *error = "Formato sin exportador";
+        return false;
+    }
+    ExportSink out(fd, enc);
+    bool ok = exporter->write(snap, out, written);
+    ok = ok && out.finish();
+    if (ok && policy != FsyncPolicy::None && fsync(fd) != 0) ok = false;
+    if (!ok) {
+        fail("No se pudo escribir");
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    if (::close(fd) != 0) {
+        fail("No se pudo escribir");
+        ::unlink(tmp.c_str());
+        return false;
     }
 
-    case FileFormat::CSV:
-        // Guardar como CSV: cada línea es una fila con una sola columna
-        // (el usuario puede editar para añadir más columnas con comas)
-        for (const auto& line : lines) {
-            // Si la línea contiene comas o comillas, envolver en comillas
-            bool needsQuotes = (line.find(',') != std::string::npos ||
-                                line.find('"') != std::string::npos ||
-                                line.find('\n') != std::string::npos);
-            if (needsQuotes) {
-                f << '"';
-                for (char c : line) {
-                    if (c == '"') f << '"'; // escapar comilla doble
-                    f << c;
-                }
-                f << '"';
-            } else {
-                f << line;
-            }
-            f << '\n';
-        }
-        break;
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        fail("No se pudo reemplazar el archivo");
+        ::unlink(tmp.c_str());
+        return false;
     }
 
+    // El rename vive en el directorio: sin esto podría no sobrevivir a un corte
+    if (policy == FsyncPolicy::FileAndDir) {
+        auto slash = path.rfind('/');
+        std::string dir = slash == std::string::npos ? "." :
+                          slash == 0 ? "/" : path.substr(0, slash);
+        int dfd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dfd >= 0) {
+            fsync(dfd);
+            ::close(dfd);
+        }
+    }
     return true;
 }
 
@@ -96,10 +196,8 @@ FileFormat FileManager::detectFormat(const std::string& path) {
     // Convertir a minúsculas
     std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
 
-    if (ext == "md" || ext == "markdown") return FileFormat::MD;
-    if (ext == "html" || ext == "htm")    return FileFormat::HTML;
-    if (ext == "csv")                     return FileFormat::CSV;
-    return FileFormat::TXT;
+    const ExportFormat* f = ExporterRegistry::byExtension(ext);
+    return f ? f->format : FileFormat::TXT;
 }
 
 // ── Nombre base del archivo ────────────────────────────────────────
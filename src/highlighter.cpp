@@ -0,0 +1,497 @@
+#include "highlighter.h"
+#include "textbuffer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// Sin marca vieja cerca, el estado provisorio parte de 0 en la fila
+static const int kLookBack = Highlighter::kStride;
+
+static void emit(std::vector<Token>* out, size_t a, size_t b, TokenStyle style) {
+    if (out && b > a) out->push_back({ (uint32_t)a, (uint32_t)(b - a), style });
+}
+
+// Posición de `needle` en [from, n) o n
+static size_t find(const char* p, size_t n, size_t from, const char* needle) {
+    size_t k = strlen(needle);
+    for (size_t i = from; i + k <= n; ++i)
+        if (p[i] == needle[0] && memcmp(p + i, needle, k) == 0) return i;
+    return n;
+}
+
+static size_t findChar(const char* p, size_t n, size_t from, char c) {
+    if (from >= n) return n;
+    const char* hit = (const char*)memchr(p + from, c, n - from);
+    return hit ? (size_t)(hit - p) : n;
+}
+
+// ── Markdown ──────────────────────────────────────────────────────
+class MarkdownGrammar : public Grammar {
+public:
+    enum : uint32_t { Text = 0, FenceTick = 1, FenceTilde = 2, InComment = 3 };
+
+    uint32_t tokenize(const char* p, size_t n, uint32_t state,
+                      std::vector<Token>* out) const override {
+        size_t i = 0;
+        while (i < n && i < 3 && p[i] == ' ') ++i;
+
+        if (state == FenceTick || state == FenceTilde) {
+            emit(out, 0, n, TokenStyle::Code);
+            return fence(p + i, n - i) == (state == FenceTick ? '`' : '~') ? Text : state;
+        }
+        if (state == InComment) {
+            size_t e = find(p, n, 0, "-->");
+            if (e == n) {
+                emit(out, 0, n, TokenStyle::Comment);
+                return InComment;
+            }
+            emit(out, 0, e + 3, TokenStyle::Comment);
+            return inlines(p, n, e + 3, out);
+        }
+
+        if (char f = fence(p + i, n - i)) {
+            emit(out, 0, n, TokenStyle::Code);
+            return f == '`' ? FenceTick : FenceTilde;
+        }
+        size_t h = i;
+        while (h < n && p[h] == '#') ++h;
+        if (h > i && h - i <= 6 && (h == n || p[h] == ' ')) {
+            emit(out, 0, n, TokenStyle::Heading);
+            return Text;
+        }
+        if (rule(p + i, n - i)) {
+            emit(out, 0, n, TokenStyle::Punctuation);
+            return Text;
+        }
+        // Cita, viñeta o número de lista
+        if (i < n && p[i] == '>') {
+            emit(out, i, i + 1, TokenStyle::Tag);
+            ++i;
+        } else if (i + 1 < n && (p[i] == '-' || p[i] == '*' || p[i] == '+') && p[i + 1] == ' ') {
+            emit(out, i, i + 1, TokenStyle::Tag);
+            ++i;
+        } else {
+            size_t d = i;
+            while (d < n && isdigit((unsigned char)p[d])) ++d;
+            if (d > i && d + 1 < n && (p[d] == '.' || p[d] == ')') && p[d + 1] == ' ') {
+                emit(out, i, d + 1, TokenStyle::Tag);
+                i = d + 1;
+            }
+        }
+        return inlines(p, n, i, out);
+    }
+
+private:
+    // '`' o '~' si la línea abre o cierra un bloque cercado
+    static char fence(const char* p, size_t n) {
+        if (n < 3 || (p[0] != '`' && p[0] != '~')) return 0;
+        return p[1] == p[0] && p[2] == p[0] ? p[0] : 0;
+    }
+
+    // ---, *** o ___ (con espacios en medio)
+    static bool rule(const char* p, size_t n) {
+        if (n == 0 || (p[0] != '-' && p[0] != '*' && p[0] != '_')) return false;
+        int count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (p[i] == p[0]) ++count;
+            else if (p[i] != ' ') return false;
+        }
+        return count >= 3;
+    }
+
+    static uint32_t inlines(const char* p, size_t n, size_t i, std::vector<Token>* out) {
+        while (i < n) {
+            char c = p[i];
+            if (c == '\\') {
+                i += 2;
+            } else if (c == '`') {
+                size_t k = i;
+                while (k < n && p[k] == '`') ++k;
+                std::string run(k - i, '`');
+                size_t e = find(p, n, k, run.c_str());
+                if (e == n) { i = k; continue; }
+                emit(out, i, e + run.size(), TokenStyle::Code);
+                i = e + run.size();
+            } else if ((c == '*' || c == '_') &&
+                       !(c == '_' && i > 0 && isalnum((unsigned char)p[i - 1]))) {
+                size_t k = i;
+                while (k < n && p[k] == c && k - i < 2) ++k;
+                std::string run(k - i, c);
+                size_t e = k < n && p[k] != ' ' ? find(p, n, k + 1, run.c_str()) : n;
+                if (e == n) { i = k; continue; }
+                emit(out, i, e + run.size(), TokenStyle::Emphasis);
+                i = e + run.size();
+            } else if (c == '[' || (c == '!' && i + 1 < n && p[i + 1] == '[')) {
+                size_t close = findChar(p, n, i + 1, ']');
+                if (close + 1 < n && p[close + 1] == '(') {
+                    size_t end = findChar(p, n, close + 2, ')');
+                    if (end < n) {
+                        emit(out, i, end + 1, TokenStyle::Link);
+                        i = end + 1;
+                        continue;
+                    }
+                }
+                ++i;
+            } else if (c == '<') {
+                if (n - i >= 4 && memcmp(p + i, "<!--", 4) == 0) {
+                    size_t e = find(p, n, i + 4, "-->");
+                    if (e == n) {
+                        emit(out, i, n, TokenStyle::Comment);
+                        return InComment;
+                    }
+                    emit(out, i, e + 3, TokenStyle::Comment);
+                    i = e + 3;
+                    continue;
+                }
+                size_t e = findChar(p, n, i + 1, '>');
+                if (e < n && i + 1 < n && (isalpha((unsigned char)p[i + 1]) || p[i + 1] == '/')) {
+                    bool url = find(p, e, i + 1, "://") < e;
+                    emit(out, i, e + 1, url ? TokenStyle::Link : TokenStyle::Tag);
+                    i = e + 1;
+                } else {
+                    ++i;
+                }
+            } else {
+                ++i;
+            }
+        }
+        return Text;
+    }
+};
+
+// ── HTML ──────────────────────────────────────────────────────────
+class HtmlGrammar : public Grammar {
+public:
+    enum : uint32_t { Text = 0, InTag = 1, InDouble = 2, InSingle = 3, InComment = 4 };
+
+    uint32_t tokenize(const char* p, size_t n, uint32_t state,
+                      std::vector<Token>* out) const override {
+        size_t i = 0;
+        while (i < n) {
+            switch (state) {
+            case InComment: {
+                size_t e = find(p, n, i, "-->");
+                if (e == n) {
+                    emit(out, i, n, TokenStyle::Comment);
+                    return InComment;
+                }
+                emit(out, i, e + 3, TokenStyle::Comment);
+                i = e + 3;
+                state = Text;
+                break;
+            }
+            case InDouble:
+            case InSingle: {
+                size_t e = findChar(p, n, i, state == InDouble ? '"' : '\'');
+                if (e == n) {
+                    emit(out, i, n, TokenStyle::String);
+                    return state;
+                }
+                emit(out, i, e + 1, TokenStyle::String);
+                i = e + 1;
+                state = InTag;
+                break;
+            }
+            case InTag: {
+                char c = p[i];
+                if (c == '>' || (c == '/' && i + 1 < n && p[i + 1] == '>')) {
+                    size_t e = c == '>' ? i + 1 : i + 2;
+                    emit(out, i, e, TokenStyle::Tag);
+                    i = e;
+                    state = Text;
+                } else if (c == '"' || c == '\'') {
+                    emit(out, i, i + 1, TokenStyle::String);
+                    ++i;
+                    state = c == '"' ? InDouble : InSingle;
+                } else if (c == ' ' || c == '\t' || c == '=' || c == '/') {
+                    ++i;
+                } else {
+                    size_t e = i;
+                    while (e < n && !strchr(" \t=/>\"'", p[e])) ++e;
+                    emit(out, i, e, TokenStyle::Attribute);
+                    i = e;
+                }
+                break;
+            }
+            default: {
+                size_t lt = findChar(p, n, i, '<');
+                size_t amp = findChar(p, std::min(n, lt), i, '&');
+                if (amp < lt) {
+                    size_t e = amp + 1;
+                    while (e < n && e - amp < 32 && (isalnum((unsigned char)p[e]) || p[e] == '#')) ++e;
+                    if (e < n && p[e] == ';') emit(out, amp, e + 1, TokenStyle::Punctuation);
+                    i = e;
+                    break;
+                }
+                if (lt == n) return Text;
+                if (n - lt >= 4 && memcmp(p + lt, "<!--", 4) == 0) {
+                    size_t e = find(p, n, lt + 4, "-->");
+                    emit(out, lt, e == n ? n : e + 3, TokenStyle::Comment);
+                    if (e == n) return InComment;
+                    i = e + 3;
+                    break;
+                }
+                size_t e = lt + 1;
+                if (e < n && (p[e] == '/' || p[e] == '!' || p[e] == '?')) ++e;
+                if (e == n || !isalpha((unsigned char)p[e])) {
+                    i = lt + 1;
+                    break;
+                }
+                while (e < n && (isalnum((unsigned char)p[e]) || p[e] == '-' || p[e] == ':')) ++e;
+                emit(out, lt, e, TokenStyle::Tag);
+                i = e;
+                state = InTag;
+                break;
+            }
+            }
+        }
+        return state;
+    }
+};
+
+// ── CSV ───────────────────────────────────────────────────────────
+// Columnas alternadas. Estado: bit 0 = dentro de comillas (un campo
+// que sigue en la línea siguiente), el resto = columna en curso.
+class CsvGrammar : public Grammar {
+public:
+    explicit CsvGrammar(char delimiter) : delim_(delimiter) {}
+
+    uint32_t tokenize(const char* p, size_t n, uint32_t state,
+                      std::vector<Token>* out) const override {
+        bool     quoted = state & 1;
+        uint32_t column = quoted ? state >> 1 : 0;
+        size_t   field  = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (p[i] == '"') {
+                quoted = !quoted;
+            } else if (p[i] == delim_ && !quoted) {
+                emit(out, field, i, column & 1 ? TokenStyle::Alternate : TokenStyle::Normal);
+                emit(out, i, i + 1, TokenStyle::Punctuation);
+                field = i + 1;
+                if (column < 0x7FFFFFFF) ++column;
+            }
+        }
+        emit(out, field, n, column & 1 ? TokenStyle::Alternate : TokenStyle::Normal);
+        return quoted ? (column << 1) | 1 : 0;
+    }
+
+private:
+    char delim_;
+};
+
+// ── Registro ──────────────────────────────────────────────────────
+static std::vector<GrammarFormat>& registry() {
+    static std::vector<GrammarFormat> grammars = {
+        { "md",   [] { return std::unique_ptr<Grammar>(new MarkdownGrammar()); } },
+        { "html", [] { return std::unique_ptr<Grammar>(new HtmlGrammar()); } },
+        { "csv",  [] { return std::unique_ptr<Grammar>(new CsvGrammar(',')); } },
+    };
+    return grammars;
+}
+
+void GrammarRegistry::add(GrammarFormat fmt) {
+    std::vector<GrammarFormat>& grammars = registry();
+    for (GrammarFormat& g : grammars) {
+        if (g.name == fmt.name) {
+            g = std::move(fmt);
+            return;
+        }
+    }
+    grammars.push_back(std::move(fmt));
+}
+
+std::unique_ptr<Grammar> GrammarRegistry::create(const std::string& name) {
+    for (const GrammarFormat& g : registry())
+        if (g.name == name && g.create) return g.create();
+    return nullptr;
+}
+
+// ── Highlighter ───────────────────────────────────────────────────
+Highlighter::Highlighter(const TextBuffer& buf) : buf_(buf) {
+    reset();
+}
+
+void Highlighter::setGrammar(std::unique_ptr<Grammar> grammar) {
+    grammar_ = std::move(grammar);
+    reset();
+}
+
+void Highlighter::reset() {
+    marks_.assign(1, Mark{ 0, 0 });
+    clean_      = 1;
+    frontLine_  = 0;
+    frontState_ = 0;
+    dirtyTo_    = -1;
+}
+
+// Las marcas hasta `row` siguen valiendo (el estado con que empieza una
+// línea no depende de ella); las siguientes se corren con sus líneas y
+// quedan como estimación
+void Highlighter::noteEdit(int row, int lineDelta) {
+    if (!grammar_) return;
+    auto after = [](int line, const Mark& m) { return line < m.line; };
+    size_t first = std::upper_bound(marks_.begin(), marks_.end(), row, after) - marks_.begin();
+    if (lineDelta < 0) {
+        size_t last = std::upper_bound(marks_.begin() + first, marks_.end(),
+                                       row - lineDelta, after) - marks_.begin();
+        marks_.erase(marks_.begin() + first, marks_.begin() + last);
+    }
+    for (size_t i = first; i < marks_.size(); ++i) marks_[i].line += lineDelta;
+
+    if (frontLine_ > row) {
+        clean_      = first;
+        frontLine_  = marks_[first - 1].line;
+        frontState_ = marks_[first - 1].state;
+    }
+    if (dirtyTo_ > row) dirtyTo_ = std::max(row, dirtyTo_ + lineDelta);
+    dirtyTo_ = std::max(dirtyTo_, row + std::max(lineDelta, 0));
+}
+
+bool Highlighter::settle(int row, int lines, std::chrono::microseconds budget) {
+    row = std::min(row, lines - 1);
+    if (!grammar_ || frontLine_ >= row) return true;
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point deadline = Clock::now() + budget;
+    bool expired = false;
+    while (frontLine_ < row && !expired) {
+        size_t   next     = clean_;
+        int      lastMark = marks_[clean_ - 1].line;
+        int      line     = frontLine_;
+        uint32_t state    = frontState_;
+        bool     converged = false;
+        std::vector<Mark> fresh;   // se insertan juntas, antes de marks_[next]
+        auto flush = [&] {
+            marks_.insert(marks_.begin() + next, fresh.begin(), fresh.end());
+            next += fresh.size();
+            fresh.clear();
+        };
+
+        forEachLine(frontLine_, row, [&](const char* p, size_t n) {
+            state = advance(p, n, state);
+            ++line;
+            if (next < marks_.size() && marks_[next].line == line) {
+                flush();
+                // Pasada la zona editada, lo que sigue no cambió
+                if (line > dirtyTo_ && marks_[next].state == state) {
+                    converged = true;
+                    return false;
+                }
+                marks_[next++].state = state;
+                lastMark = line;
+            } else if (line - lastMark >= kStride) {
+                fresh.push_back({ line, state });
+                lastMark = line;
+            }
+            if ((line & 63) == 0 && Clock::now() >= deadline) {
+                expired = true;
+                return false;
+            }
+            return true;
+        });
+        flush();
+
+        if (converged) {
+            clean_      = marks_.size();
+            frontLine_  = marks_.back().line;
+            frontState_ = marks_.back().state;
+            dirtyTo_    = -1;
+        } else {
+            // Las marcas viejas siguen la cadena de estados de antes: sólo
+            // se puede empalmar con ellas más allá de donde quedó el frente
+            clean_      = next;
+            frontLine_  = line;
+            frontState_ = state;
+            dirtyTo_    = clean_ < marks_.size() ? std::max(dirtyTo_, frontLine_) : -1;
+        }
+    }
+    return frontLine_ >= row;
+}
+
+bool Highlighter::states(int row, int n, int lines, std::chrono::microseconds budget,
+                         std::vector<uint32_t>& out) {
+    out.clear();
+    if (n <= 0) return true;
+    if (!grammar_) {
+        out.assign((size_t)n, 0);
+        return true;
+    }
+    // El frente pasa toda la pantalla: lo editado en ella deja de frenar
+    // el empalme con las marcas viejas
+    bool exact = settle(row + n - 1, lines, budget);
+
+    // Punto de partida: la marca (o el frente) más cercana antes de `row`
+    auto after = [](int line, const Mark& m) { return line < m.line; };
+    exact = exact || frontLine_ >= row;
+    auto end = exact ? marks_.begin() + clean_ : marks_.end();
+    const Mark& m = *(std::upper_bound(marks_.begin(), end, row, after) - 1);
+    int      from  = m.line;
+    uint32_t state = m.state;
+    if (frontLine_ <= row && frontLine_ > from) {
+        from  = frontLine_;
+        state = frontState_;
+    }
+    if (!exact && row - from > kLookBack) {
+        from  = row;
+        state = 0;
+    }
+
+    int line = from;
+    forEachLine(from, row + n - 1, [&](const char* p, size_t len) {
+        if (line++ >= row) out.push_back(state);
+        state = advance(p, len, state);
+        return true;
+    });
+    out.push_back(state);
+    return exact;
+}
+
+uint32_t Highlighter::advance(const char* p, size_t n, uint32_t state) const {
+    return p ? grammar_->tokenize(p, n, state, nullptr) : state;
+}
+
+bool Highlighter::forEachLine(int from, int to,
+                              const std::function<bool(const char*, size_t)>& fn) {
+    while (from < to) {
+        uint64_t a    = buf_.lineStart(from);
+        uint64_t b    = buf_.lineStart(to);
+        bool     skip = false;   // la línea `from` pasa de kMaxLineLength
+        scratch_.clear();
+        bool more = buf_.forEachSpanWhile(a, b - a, [&](const char* p, size_t n) {
+            size_t pos = 0;
+            while (pos < n) {
+                // No se busca el '\n' más allá del límite (con lugar para
+                // un '\r'): una línea larguísima no se recorre ni se copia
+                size_t room  = kMaxLineLength + 2 - scratch_.size();
+                size_t limit = std::min(n - pos, room);
+                const char* nl = (const char*)memchr(p + pos, '\n', limit);
+                if (!nl) {
+                    if (limit == room) {
+                        skip = true;
+                        return false;
+                    }
+                    scratch_.append(p + pos, n - pos);
+                    return true;
+                }
+                size_t      len  = (size_t)(nl - (p + pos));
+                const char* line = p + pos;
+                if (!scratch_.empty()) {
+                    scratch_.append(line, len);
+                    line = scratch_.data();
+                    len  = scratch_.size();
+                }
+                if (len > 0 && line[len - 1] == '\r') --len;
+                bool go = fn(len > kMaxLineLength ? nullptr : line, len);
+                scratch_.clear();
+                ++from;
+                pos = (size_t)(nl - p) + 1;
+                if (!go) return false;
+            }
+            return true;
+        });
+        if (!skip) return more;
+        if (!fn(nullptr, buf_.lineLength(from))) return false;
+        ++from;
+    }
+    return true;
+}
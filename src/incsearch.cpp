@@ -0,0 +1,147 @@
+#include "incsearch.h"
+#include "searchkernel.h"
+#include "textbuffer.h"
+#include <algorithm>
+
+// Bytes (búsqueda nueva) o candidatos (refinamiento) entre cada
+// comprobación de cancelación
+static const uint64_t kChunkBytes      = 1u << 20;
+static const size_t   kChunkCandidates = 4096;
+
+IncrementalSearch::~IncrementalSearch() {
+    stop();
+}
+
+void IncrementalSearch::stop() {
+    cancel_ = true;
+    if (thread_.joinable()) thread_.join();
+    cancel_   = false;
+    finished_ = false;
+    scanned_  = 0;
+    result_.reset();
+}
+
+double IncrementalSearch::progress() const {
+    if (done_ || total_ == 0) return 1.0;
+    return std::min(1.0, (double)scanned_ / (double)total_);
+}
+
+void IncrementalSearch::update(const TextBuffer& buf, const std::string& query,
+                               bool caseSensitive, uint64_t visFrom, uint64_t visTo,
+                               const TrigramIndex::Ranges* ranges) {
+    // La búsqueda anterior ya no sirve
+    stop();
+    query_         = query;
+    caseSensitive_ = caseSensitive;
+
+    if (query.empty()) {
+        levels_.clear();
+        current_ = std::make_shared<Matches>();
+        done_    = true;
+        return;
+    }
+
+    // Conservar sólo los niveles que son prefijo de la nueva consulta
+    while (!levels_.empty()) {
+        const Level& lv = levels_.back();
+        if (lv.caseSensitive == caseSensitive &&
+            query.compare(0, lv.query.size(), lv.query) == 0)
+            break;
+        levels_.pop_back();
+    }
+    if (!levels_.empty() && levels_.back().query == query) {
+        // Se borró hasta una consulta ya resuelta
+        current_ = levels_.back().matches;
+        done_    = true;
+        return;
+    }
+
+    std::shared_ptr<const Matches> base =
+        levels_.empty() ? nullptr : levels_.back().matches;
+
+    // Región visible, en el acto
+    TextSnapshot snap = buf.snapshot();
+    SearchKernel kernel(query, caseSensitive);
+    uint64_t n = query.size();
+    auto visible = std::make_shared<Matches>();
+    if (base) {
+        auto it = std::lower_bound(base->begin(), base->end(), visFrom);
+        for (; it != base->end() && *it < visTo; ++it)
+            if (kernel.find(snap, *it, *it + n) == *it) visible->push_back(*it);
+    } else {
+        uint64_t pos = visFrom, at;
+        uint64_t end = std::min(snap.size(), visTo + n - 1);
+        while ((at = kernel.find(snap, pos, end)) != SearchKernel::npos && at < visTo) {
+            visible->push_back(at);
+            pos = at + 1;
+        }
+    }
+    current_ = visible;
+    done_    = false;
+
+    TrigramIndex::Ranges scan;
+    if (ranges) scan = *ranges;
+    else        scan.push_back({ 0, snap.size() });
+    start(std::move(snap), base, std::move(scan));
+}
+
+// ── Hilo ──────────────────────────────────────────────────────────
+void IncrementalSearch::start(TextSnapshot snap, std::shared_ptr<const Matches> base,
+                              TrigramIndex::Ranges ranges) {
+    total_ = 0;
+    if (base) total_ = base->size();
+    else      for (auto& r : ranges) total_ += r.second - r.first;
+    thread_ = std::thread([this, snap = std::move(snap), base, ranges = std::move(ranges),
+                           query = query_, cs = caseSensitive_] {
+        SearchKernel kernel(query, cs);
+        uint64_t n = query.size();
+        auto out = std::make_shared<Matches>();
+
+        if (base) {
+            // Refinar: cada aparición nueva empieza en una de la consulta anterior
+            for (size_t i = 0; i < base->size(); ++i) {
+                if (i % kChunkCandidates == 0) {
+                    if (cancel_) return;
+                    scanned_ = i;
+                }
+                uint64_t o = (*base)[i];
+                if (kernel.find(snap, o, o + n) == o) out->push_back(o);
+            }
+        } else {
+            uint64_t scanned = 0;
+            for (auto& r : ranges) {
+                uint64_t size = std::min(r.second, snap.size());
+                for (uint64_t a = r.first; a < size; a += kChunkBytes) {
+                    if (cancel_) return;
+                    uint64_t b = std::min(size, a + kChunkBytes);
+                    uint64_t end = std::min(size, b + n - 1);
+                    uint64_t pos = a, at;
+                    while ((at = kernel.find(snap, pos, end)) != SearchKernel::npos && at < b) {
+                        out->push_back(at);
+                        pos = at + 1;
+                    }
+                    scanned += b - a;
+                    scanned_ = scanned;
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        result_   = out;
+        finished_ = true;
+    });
+}
+
+bool IncrementalSearch::poll() {
+    if (!finished_) return false;
+    thread_.join();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        current_ = result_;
+        result_.reset();
+    }
+    finished_ = false;
+    done_     = true;
+    levels_.push_back({ query_, caseSensitive_, current_ });
+    return true;
+}
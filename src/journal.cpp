@@ -0,0 +1,365 @@
+#include "journal.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ── Formato ───────────────────────────────────────────────────────
+// Cabecera: "NPJ1", 4 bytes libres, tamaño (u64) y mtime en ns (i64)
+// del archivo base. Lote: longitud (u64), suma (u32) y los registros.
+// Registro: offset, bytes quitados y largo del texto (varints), texto.
+static const char     kMagic[4]    = { 'N', 'P', 'J', '1' };
+static const size_t   kHeaderSize  = 24;
+static const size_t   kFrameHeader = 12;
+
+// Un lote se escribe a los kFlushMs del primer registro pendiente, o
+// antes si junta kFlushBytes
+static const std::chrono::milliseconds kFlushMs(200);
+static const size_t                    kFlushBytes = 1u << 20;
+
+// ── Helpers internos ──────────────────────────────────────────────
+static void putVarint(std::string& out, uint64_t v) {
+    while (v >= 0x80) {
+        out += (char)((v & 0x7f) | 0x80);
+        v >>= 7;
+    }
+    out += (char)v;
+}
+
+static bool getVarint(const std::string& in, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        unsigned char b = (unsigned char)in[pos++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// FNV-1a de a 8 bytes: basta para reconocer un lote escrito a medias
+static uint32_t checksum(const char* p, size_t n) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        memcpy(&w, p + i, 8);
+        h = (h ^ w) * 0x100000001b3ull;
+    }
+    for (; i < n; ++i) h = (h ^ (unsigned char)p[i]) * 0x100000001b3ull;
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+static bool writeAll(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return true;
+}
+
+// ── Rutas e identidad ─────────────────────────────────────────────
+std::string Journal::pathFor(const std::string& path) {
+    return path + ".journal";
+}
+
+bool Journal::statBase(const std::string& path, Base& out) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    out.size    = (uint64_t)st.st_size;
+    out.mtimeNs = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+bool Journal::readFile(const std::string& file, Base& base,
+                       std::string& records, uint64_t& end) {
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    std::string data;
+    char chunk[1 << 16];
+    ssize_t n;
+    while ((n = ::read(fd, chunk, sizeof(chunk))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        data.append(chunk, (size_t)n);
+    }
+    ::close(fd);
+
+    if (data.size() < kHeaderSize || memcmp(data.data(), kMagic, 4) != 0) return false;
+    memcpy(&base.size,    data.data() + 8,  8);
+    memcpy(&base.mtimeNs, data.data() + 16, 8);
+
+    // Lotes íntegros; el primero cortado o alterado termina el diario
+    records.clear();
+    size_t pos = kHeaderSize;
+    while (pos + kFrameHeader <= data.size()) {
+        uint64_t len;
+        uint32_t sum;
+        memcpy(&len, data.data() + pos,     8);
+        memcpy(&sum, data.data() + pos + 8, 4);
+        if (len > data.size() - pos - kFrameHeader) break;
+        const char* p = data.data() + pos + kFrameHeader;
+        if (checksum(p, (size_t)len) != sum) break;
+        records.append(p, (size_t)len);
+        pos += kFrameHeader + (size_t)len;
+    }
+    end = pos;
+    return true;
+}
+
+// ── Recuperación ──────────────────────────────────────────────────
+size_t Journal::replay(const std::string& path, TextBuffer& buf) {
+    Base disk, base;
+    std::string rec;
+    uint64_t end;
+    if (!statBase(path, disk) || !readFile(pathFor(path), base, rec, end)) return 0;
+    // Ediciones sobre otra versión del archivo: no se pueden aplicar
+    if (base.size != disk.size || base.mtimeNs != disk.mtimeNs || rec.empty()) return 0;
+
+    buf.loadAll();
+    size_t applied = 0;
+    size_t pos = 0;
+    while (pos < rec.size()) {
+        uint64_t offset, removed, len;
+        if (!getVarint(rec, pos, offset) || !getVarint(rec, pos, removed) ||
+            !getVarint(rec, pos, len) || len > rec.size() - pos)
+            break;
+        if (offset > buf.size() || removed > buf.size() - offset) break;
+        if (removed) buf.erase(offset, removed);
+        if (len)     buf.insert(offset, rec.data() + pos, (size_t)len);
+        pos += (size_t)len;
+        ++applied;
+    }
+    return applied;
+}
+
+void Journal::discard(const std::string& path) {
+    ::unlink(pathFor(path).c_str());
+}
+
+// ── Abrir / cerrar ────────────────────────────────────────────────
+Journal::~Journal() {
+    close(false);
+}
+
+bool Journal::open(const std::string& path) {
+    close(false);
+    Base disk;
+    if (!statBase(path, disk)) return false;
+
+    path_      = path;
+    file_      = pathFor(path);
+    base_      = disk;
+    fd_        = -1;
+    fileStart_ = enqueued_;
+
+    // Continuar un diario válido (sin el lote cortado, si lo hay)
+    Base base;
+    std::string rec;
+    uint64_t end;
+    if (readFile(file_, base, rec, end) &&
+        base.size == disk.size && base.mtimeNs == disk.mtimeNs) {
+        int fd = ::open(file_.c_str(), O_RDWR | O_CLOEXEC);
+        if (fd >= 0 && ftruncate(fd, (off_t)end) == 0 && lseek(fd, 0, SEEK_END) >= 0) {
+            fd_        = fd;
+            fileStart_ = enqueued_ - rec.size();
+        } else if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    stop_   = false;
+    thread_ = std::thread(&Journal::run, this);
+    return true;
+}
+
+void Journal::close(bool discard) {
+    if (!active()) return;
+    if (discard) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        pending_.clear();
+    }
+    stopThread();
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+    if (discard) ::unlink(file_.c_str());
+    path_.clear();
+}
+
+void Journal::stopThread() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    if (thread_.joinable()) thread_.join();
+    stop_ = false;
+}
+
+// ── Registro (hilo de la interfaz) ────────────────────────────────
+void Journal::lockedAppend(uint64_t offset, uint64_t removed, const char* text, size_t len) {
+    size_t before = pending_.size();
+    putVarint(pending_, offset);
+    putVarint(pending_, removed);
+    putVarint(pending_, len);
+    pending_.append(text, len);
+    enqueued_ += pending_.size() - before;
+}
+
+void Journal::wake(size_t before) {
+    // Sólo al primer registro del lote o al llenarlo: el resto espera
+    if (before == 0 || (before < kFlushBytes && pending_.size() >= kFlushBytes))
+        cv_.notify_one();
+}
+
+void Journal::noteEdit(uint64_t offset, uint64_t removed, const char* text, size_t len) {
+    if (!active()) return;
+    std::lock_guard<std::mutex> lock(mtx_);
+    size_t before = pending_.size();
+    lockedAppend(offset, removed, text, len);
+    wake(before);
+}
+
+void Journal::noteReplaceMatches(const std::vector<uint64_t>& offsets, uint64_t len,
+                                 const std::string& replacement) {
+    if (!active() || offsets.empty()) return;
+    std::lock_guard<std::mutex> lock(mtx_);
+    size_t before = pending_.size();
+    // Offsets del documento original: cada reemplazo previo los corre
+    for (size_t i = 0; i < offsets.size(); ++i)
+        lockedAppend(offsets[i] + i * replacement.size() - i * len, len,
+                     replacement.data(), replacement.size());
+    wake(before);
+}
+
+void Journal::noteEdits(const std::vector<TextEdit>& edits) {
+    if (!active() || edits.empty()) return;
+    std::lock_guard<std::mutex> lock(mtx_);
+    size_t before = pending_.size();
+    uint64_t added = 0, removed = 0;
+    for (const TextEdit& e : edits) {
+        lockedAppend(e.offset + added - removed, e.length, e.text.data(), e.text.size());
+        added   += e.text.size();
+        removed += e.length;
+    }
+    wake(before);
+}
+
+uint64_t Journal::mark() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return enqueued_;
+}
+
+void Journal::rebase(uint64_t mark, const std::string& path) {
+    Base disk;
+    if (!statBase(path, disk)) return;
+    if (!active()) {
+        open(path);
+        return;
+    }
+    path_ = path;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        rebases_.push_back({ mark, pathFor(path), disk });
+    }
+    cv_.notify_one();
+}
+
+// ── Hilo de escritura ─────────────────────────────────────────────
+void Journal::run() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    for (;;) {
+        cv_.wait(lock, [&] { return stop_ || !pending_.empty() || !rebases_.empty(); });
+        // Juntar un lote: lo que llegue durante kFlushMs
+        if (!stop_ && rebases_.empty())
+            cv_.wait_for(lock, kFlushMs, [&] {
+                return stop_ || !rebases_.empty() || pending_.size() >= kFlushBytes;
+            });
+
+        std::string batch;
+        batch.swap(pending_);
+        std::vector<Rebase> rebases;
+        rebases.swap(rebases_);
+        bool stop = stop_;
+        lock.unlock();
+
+        if (!batch.empty()) writeBatch(batch);
+        for (const Rebase& r : rebases) applyRebase(r);
+
+        lock.lock();
+        if (stop && pending_.empty() && rebases_.empty()) return;
+    }
+}
+
+bool Journal::createFile(const std::string& file, const Base& base) {
+    int fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+    char header[kHeaderSize] = {};
+    memcpy(header, kMagic, 4);
+    memcpy(header + 8,  &base.size,    8);
+    memcpy(header + 16, &base.mtimeNs, 8);
+    if (!writeAll(fd, header, kHeaderSize)) {
+        ::close(fd);
+        return false;
+    }
+    fd_ = fd;
+    return true;
+}
+
+void Journal::writeBatch(const std::string& batch) {
+    // El diario es un resguardo: si no se puede escribir, se sigue editando
+    if (fd_ < 0 && !createFile(file_, base_)) return;
+    char frame[kFrameHeader];
+    uint64_t len = batch.size();
+    uint32_t sum = checksum(batch.data(), batch.size());
+    memcpy(frame,     &len, 8);
+    memcpy(frame + 8, &sum, 4);
+    if (writeAll(fd_, frame, kFrameHeader) && writeAll(fd_, batch.data(), batch.size()))
+        fdatasync(fd_);
+}
+
+void Journal::applyRebase(const Rebase& r) {
+    // Lo registrado después de la marca sobrevive al cambio de base
+    std::string tail;
+    if (fd_ >= 0) {
+        Base old;
+        std::string rec;
+        uint64_t end;
+        uint64_t skip = r.mark - fileStart_;
+        if (readFile(file_, old, rec, end) && skip <= rec.size())
+            tail = rec.substr((size_t)skip);
+        ::close(fd_);
+        fd_ = -1;
+    }
+
+    std::string old = file_;
+    file_      = r.file;
+    base_      = r.base;
+    fileStart_ = r.mark;
+    if (tail.empty()) {
+        ::unlink(old.c_str());
+        return;
+    }
+    // El diario nuevo se arma aparte y se renombra encima
+    std::string tmp = file_ + ".tmp";
+    if (!createFile(tmp, base_)) return;
+    writeBatch(tail);
+    if (std::rename(tmp.c_str(), file_.c_str()) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+        ::unlink(tmp.c_str());
+        return;
+    }
+    if (old != file_) ::unlink(old.c_str());
+}
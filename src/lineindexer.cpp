@@ -0,0 +1,131 @@
+#include "lineindexer.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LINEINDEXER_X86 1
+#endif
+
+// Por debajo de este tamaño no compensa lanzar hilos
+static const size_t kParallelMin = 4u << 20;
+
+typedef void (*ScanFn)(const char*, size_t, uint64_t, std::vector<uint64_t>&);
+
+// ── Respaldo escalar ──────────────────────────────────────────────
+static void scanScalar(const char* data, size_t len, uint64_t base,
+                       std::vector<uint64_t>& out) {
+    const char* p   = data;
+    const char* end = data + len;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!nl) break;
+        out.push_back(base + (uint64_t)(nl - data));
+        p = nl + 1;
+    }
+}
+
+#ifdef LINEINDEXER_X86
+// Vuelca los bits encendidos de una máscara como offsets
+static inline void emitMask(uint64_t mask, uint64_t at, std::vector<uint64_t>& out) {
+    while (mask) {
+        out.push_back(at + (uint64_t)__builtin_ctzll(mask));
+        mask &= mask - 1;
+    }
+}
+
+#ifdef __SSE2__
+// ── SSE2: 16 bytes por comparación ────────────────────────────────
+static void scanSse2(const char* data, size_t len, uint64_t base,
+                     std::vector<uint64_t>& out) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        const __m128i* p = reinterpret_cast<const __m128i*>(data + i);
+        uint64_t m0 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + 0), nl));
+        uint64_t m1 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + 1), nl));
+        uint64_t m2 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + 2), nl));
+        uint64_t m3 = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p + 3), nl));
+        emitMask(m0 | (m1 << 16) | (m2 << 32) | (m3 << 48), base + i, out);
+    }
+    scanScalar(data + i, len - i, base + i, out);
+}
+#endif
+
+// ── AVX2: 32 bytes por comparación ────────────────────────────────
+__attribute__((target("avx2")))
+static void scanAvx2(const char* data, size_t len, uint64_t base,
+                     std::vector<uint64_t>& out) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        const __m256i* p = reinterpret_cast<const __m256i*>(data + i);
+        uint64_t lo = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(p + 0), nl));
+        uint64_t hi = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(p + 1), nl));
+        emitMask(lo | (hi << 32), base + i, out);
+    }
+    scanScalar(data + i, len - i, base + i, out);
+}
+#endif
+
+// ── Selección de implementación ───────────────────────────────────
+static ScanFn pickScan(const char** name) {
+#ifdef LINEINDEXER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) { *name = "avx2"; return scanAvx2; }
+#ifdef __SSE2__
+    *name = "sse2";
+    return scanSse2;
+#endif
+#endif
+    *name = "scalar";
+    return scanScalar;
+}
+
+static const char* gBackend = nullptr;
+static ScanFn      gScan    = pickScan(&gBackend);
+
+const char* LineIndexer::backend() {
+    return gBackend;
+}
+
+// ── API ───────────────────────────────────────────────────────────
+void LineIndexer::scan(const char* data, size_t len, uint64_t base,
+                       std::vector<uint64_t>& out) {
+    gScan(data, len, base, out);
+}
+
+void LineIndexer::scanParallel(const char* data, size_t len, uint64_t base,
+                               std::vector<uint64_t>& out, unsigned threads) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    if (threads > len / kParallelMin) threads = (unsigned)(len / kParallelMin);
+    if (threads <= 1) {
+        // Reservar de forma geométrica: la carga perezosa llama por tramos
+        size_t need = out.size() + len / 64;
+        if (need > out.capacity()) out.reserve(std::max(need, out.capacity() * 2));
+        scan(data, len, base, out);
+        return;
+    }
+
+    // Un tramo por hilo; el último absorbe el resto
+    std::vector<std::vector<uint64_t>> parts(threads);
+    std::vector<std::thread> workers;
+    size_t step = len / threads;
+    for (unsigned t = 0; t < threads; ++t) {
+        size_t from = t * step;
+        size_t to   = (t + 1 == threads) ? len : from + step;
+        workers.emplace_back([=, &parts] {
+            parts[t].reserve((to - from) / 64);
+            gScan(data + from, to - from, base + from, parts[t]);
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    // Unir en orden
+    size_t total = out.size();
+    for (auto& p : parts) total += p.size();
+    out.reserve(total);
+    for (auto& p : parts) out.insert(out.end(), p.begin(), p.end());
+}
@@ -0,0 +1,56 @@
+#include "loadworker.h"
+#include "lineindexer.h"
+#include <algorithm>
+
+// Bytes que se recorren por lote publicado
+static const uint64_t kBatchBytes = 32u << 20;
+
+LoadWorker::LoadWorker(std::shared_ptr<const MappedFile> file, uint64_t from)
+    : file_(std::move(file)), from_(from),
+      cancel_(false), done_(false), scanned_(from), pendingUpTo_(from)
+{
+    thread_ = std::thread(&LoadWorker::run, this);
+}
+
+LoadWorker::~LoadWorker() {
+    cancel();
+    wait();
+}
+
+void LoadWorker::cancel() {
+    cancel_ = true;
+}
+
+void LoadWorker::wait() {
+    if (thread_.joinable()) thread_.join();
+}
+
+uint64_t LoadWorker::take(std::vector<uint64_t>& lfs) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (lfs.empty()) lfs.swap(pending_);
+    else             lfs.insert(lfs.end(), pending_.begin(), pending_.end());
+    pending_.clear();
+    return pendingUpTo_;
+}
+
+// ── Hilo ──────────────────────────────────────────────────────────
+void LoadWorker::run() {
+    const char* data = file_->data();
+    uint64_t    size = file_->size();
+
+    std::vector<uint64_t> batch;
+    for (uint64_t pos = from_; pos < size && !cancel_; ) {
+        uint64_t end = std::min(size, pos + kBatchBytes);
+        batch.clear();
+        LineIndexer::scanParallel(data + pos, (size_t)(end - pos), pos, batch);
+
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            pending_.insert(pending_.end(), batch.begin(), batch.end());
+            pendingUpTo_ = end;
+        }
+        scanned_ = end;
+        pos = end;
+    }
+    done_ = true;
+}
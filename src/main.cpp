@@ -1,9 +1,16 @@
 #include <ncurses.h>
+#include <clocale>
 #include <cstdio>
+#include <cstring>
+#include <langinfo.h>
 #include "app.h"
 
 int main(int argc, char* argv[]) {
     // ── 1. Inicializar ncurses ──────────────────────────────────
+    // El texto es UTF-8: ncursesw y wcwidth lo decodifican según el
+    // locale, que se fuerza a UTF-8 si el del entorno no lo es
+    setlocale(LC_ALL, "");
+    if (!strstr(nl_langinfo(CODESET), "UTF-8")) setlocale(LC_CTYPE, "C.UTF-8");
     initscr();
     cbreak();
     noecho();
@@ -0,0 +1,79 @@
+#include "mappedfile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() {
+    if (map_) munmap(map_, size_);
+}
+
+static int64_t mtimeNs(const struct stat& st) {
+    return (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+// ── Abrir y mapear ────────────────────────────────────────────────
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& path,
+                                             const TextEncoding& encoding) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    std::shared_ptr<MappedFile> mf(new MappedFile());
+    mf->size_     = (size_t)st.st_size;
+    mf->dev_      = st.st_dev;
+    mf->ino_      = st.st_ino;
+    mf->diskSize_ = (uint64_t)st.st_size;
+    mf->mtimeNs_  = mtimeNs(st);
+    mf->encoding_ = encoding;
+
+    // mmap no admite longitud 0: un archivo vacío queda sin mapear
+    if (mf->size_ > 0) {
+        void* p = mmap(nullptr, mf->size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            return nullptr;
+        }
+        mf->map_  = p;
+        mf->data_ = static_cast<const char*>(p);
+    }
+
+    // El mapeo sobrevive al descriptor
+    ::close(fd);
+    return mf;
+}
+
+// ── Texto en memoria ──────────────────────────────────────────────
+std::shared_ptr<MappedFile> MappedFile::fromMemory(std::unique_ptr<char[]> data, size_t size,
+                                                   TextEncoding encoding) {
+    std::shared_ptr<MappedFile> mf(new MappedFile());
+    mf->mem_      = std::move(data);
+    mf->data_     = mf->mem_.get();
+    mf->size_     = size;
+    mf->encoding_ = encoding;
+    return mf;
+}
+
+// ── Páginas residentes ────────────────────────────────────────────
+void MappedFile::release() const {
+    // Mapeo privado de solo lectura: nunca hay páginas propias que perder
+    if (map_) madvise(map_, size_, MADV_DONTNEED);
+}
+
+// ── Identidad en disco ────────────────────────────────────────────
+bool MappedFile::unchangedOnDisk(const struct stat& st) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return st.st_dev == dev_ && st.st_ino == ino_ &&
+           (uint64_t)st.st_size == diskSize_ && mtimeNs(st) == mtimeNs_;
+}
+
+void MappedFile::noteWritten(const struct stat& st) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    diskSize_ = (uint64_t)st.st_size;
+    mtimeNs_  = mtimeNs(st);
+}
@@ -58,7 +58,7 @@ void MenuBar::draw() {
     mvwprintw(win_, 0, width_ - (int)hint.size(), "%s", hint.c_str());
 
     wattroff(win_, COLOR_PAIR(COLOR_MENUBAR));
-    wrefresh(win_);
+    wnoutrefresh(win_);
 
     if (open_) drawDropdown();
 }
@@ -127,7 +127,7 @@ void MenuBar::drawDropdown() {
         else     wattroff(dropWin_, COLOR_PAIR(COLOR_DROPDOWN));
     }
 
-    wrefresh(dropWin_);
+    wnoutrefresh(dropWin_);
 }
 
 void MenuBar::executeItem() {
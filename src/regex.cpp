@@ -0,0 +1,720 @@
+#include "regex.h"
+#include "textbuffer.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+// Límites del compilador: repeticiones {m,n} y tamaño del programa
+static const int kMaxRepeat = 1000;
+static const int kMaxProgram = 100000;
+
+// Estados del DFA antes de vaciar la caché (cada fila ocupa 1 KiB)
+static const size_t kMaxDfaStates = 4096;
+
+// Caracter de palabra para \w, \b y \B (ASCII, sin depender del locale)
+static bool isWordByte(int c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+// ── Árbol sintáctico ──────────────────────────────────────────────
+namespace {
+
+struct Node {
+    enum Kind { Empty, Lit, Cls, Cat, Alt, Rep, Group, Bol, Eol, WordB, NotWordB };
+    Kind kind;
+    unsigned char c = 0;   // Lit
+    int  cls   = 0;        // Cls
+    int  min   = 0;        // Rep
+    int  max   = 0;        // Rep (-1 = sin tope)
+    bool greedy = true;    // Rep
+    int  group = 0;        // Group
+    std::vector<std::unique_ptr<Node>> kids;
+
+    explicit Node(Kind k) : kind(k) {}
+};
+
+typedef std::unique_ptr<Node> NodePtr;
+
+} // namespace
+
+// ── Compilador ────────────────────────────────────────────────────
+// Descenso recursivo sobre el patrón y emisión del programa de Thompson
+class RegexCompiler {
+public:
+    RegexCompiler(const std::string& pat, bool caseSensitive, Regex& re)
+        : pat_(pat), pos_(0), cs_(caseSensitive), re_(re) {}
+
+    bool run(std::string& error) {
+        NodePtr root = parseAlt();
+        if (err_.empty() && pos_ < pat_.size()) err_ = "')' sin '('";
+        if (err_.empty()) {
+            emit({ Regex::Save, 0, 0, 0 });
+            gen(*root);
+            emit({ Regex::Save, 0, 1, 0 });
+            emit({ Regex::Match, 0, 0, 0 });
+            if (re_.prog_.size() > (size_t)kMaxProgram) err_ = "patrón demasiado grande";
+        }
+        error = err_;
+        return err_.empty();
+    }
+
+private:
+    const std::string& pat_;
+    size_t      pos_;
+    bool        cs_;
+    Regex&      re_;
+    std::string err_;
+
+    bool end() const        { return pos_ >= pat_.size(); }
+    char peek() const       { return pat_[pos_]; }
+    bool fail(const char* m) { if (err_.empty()) err_ = m; return false; }
+
+    // ── Parser ────────────────────────────────────────────────────
+    NodePtr parseAlt() {
+        NodePtr first = parseCat();
+        if (end() || peek() != '|') return first;
+        NodePtr alt(new Node(Node::Alt));
+        alt->kids.push_back(std::move(first));
+        while (!end() && peek() == '|') {
+            ++pos_;
+            alt->kids.push_back(parseCat());
+        }
+        return alt;
+    }
+
+    NodePtr parseCat() {
+        NodePtr cat(new Node(Node::Cat));
+        while (err_.empty() && !end() && peek() != '|' && peek() != ')')
+            cat->kids.push_back(parseRepeat());
+        if (cat->kids.size() == 1) return std::move(cat->kids[0]);
+        if (cat->kids.empty()) cat->kind = Node::Empty;
+        return cat;
+    }
+
+    NodePtr parseRepeat() {
+        NodePtr atom = parseAtom();
+        while (err_.empty() && !end()) {
+            int mn, mx;
+            char q = peek();
+            if (q == '*')      { mn = 0; mx = -1; ++pos_; }
+            else if (q == '+') { mn = 1; mx = -1; ++pos_; }
+            else if (q == '?') { mn = 0; mx = 1;  ++pos_; }
+            else if (q == '{') { if (!parseBraces(mn, mx)) break; }
+            else break;
+
+            NodePtr rep(new Node(Node::Rep));
+            rep->min = mn;
+            rep->max = mx;
+            if (!end() && peek() == '?') { rep->greedy = false; ++pos_; }
+            rep->kids.push_back(std::move(atom));
+            atom = std::move(rep);
+        }
+        return atom;
+    }
+
+    // {m} {m,} {m,n}; si no tiene esa forma, la '{' es un literal
+    bool parseBraces(int& mn, int& mx) {
+        size_t p = pos_ + 1;
+        auto number = [&](int& v) {
+            size_t s = p;
+            long n = 0;
+            while (p < pat_.size() && std::isdigit((unsigned char)pat_[p]) && n <= kMaxRepeat)
+                n = n * 10 + (pat_[p++] - '0');
+            v = (int)n;
+            return p > s;
+        };
+        if (!number(mn)) return false;
+        mx = mn;
+        if (p < pat_.size() && pat_[p] == ',') {
+            ++p;
+            if (!number(mx)) mx = -1;
+        }
+        if (p >= pat_.size() || pat_[p] != '}') return false;
+        pos_ = p + 1;
+        if (mn > kMaxRepeat || mx > kMaxRepeat) return fail("repetición demasiado grande");
+        if (mx != -1 && mx < mn) return fail("repetición {m,n} con n < m");
+        return true;
+    }
+
+    NodePtr parseAtom() {
+        char ch = pat_[pos_++];
+        switch (ch) {
+        case '(': {
+            int group = 0;
+            if (pat_.compare(pos_, 2, "?:") == 0) pos_ += 2;
+            else group = ++re_.groups_;
+            NodePtr inner = parseAlt();
+            if (end() || peek() != ')') { fail("falta ')'"); return inner; }
+            ++pos_;
+            if (!group) return inner;
+            NodePtr g(new Node(Node::Group));
+            g->group = group;
+            g->kids.push_back(std::move(inner));
+            return g;
+        }
+        case '[': return parseClass();
+        case '.': {
+            std::bitset<256> any;
+            any.set();
+            any.reset('\n');
+            return cls(any);
+        }
+        case '^': return NodePtr(new Node(Node::Bol));
+        case '$': return NodePtr(new Node(Node::Eol));
+        case '*': case '+': case '?':
+            fail("nada que repetir");
+            return NodePtr(new Node(Node::Empty));
+        case '\\': {
+            if (end()) { fail("'\\' al final del patrón"); return NodePtr(new Node(Node::Empty)); }
+            char e = pat_[pos_];
+            if (e == 'b') { ++pos_; return NodePtr(new Node(Node::WordB)); }
+            if (e == 'B') { ++pos_; return NodePtr(new Node(Node::NotWordB)); }
+            std::bitset<256> set;
+            if (classEscape(set)) return cls(set);
+            return lit(escapeChar());
+        }
+        default:
+            return lit((unsigned char)ch);
+        }
+    }
+
+    // \d \w \s y sus negaciones; avanza sólo si reconoce el escape
+    bool classEscape(std::bitset<256>& set) {
+        char e = pat_[pos_];
+        std::bitset<256> s;
+        switch (std::tolower((unsigned char)e)) {
+        case 'd': for (int c = '0'; c <= '9'; ++c) s.set(c); break;
+        case 'w': for (int c = 0; c < 256; ++c) if (isWordByte(c)) s.set(c); break;
+        case 's': for (char c : std::string(" \t\r\n\f\v")) s.set((unsigned char)c); break;
+        default:  return false;
+        }
+        ++pos_;
+        if (std::isupper((unsigned char)e)) s.flip();
+        set |= s;
+        return true;
+    }
+
+    // Escape de un solo byte (ya consumida la '\')
+    unsigned char escapeChar() {
+        char e = pat_[pos_++];
+        switch (e) {
+        case 't': return '\t';
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case 'x': {
+            int v = 0, n = 0;
+            while (n < 2 && !end() && std::isxdigit((unsigned char)peek())) {
+                char h = pat_[pos_++];
+                v = v * 16 + (std::isdigit((unsigned char)h) ? h - '0' : std::tolower(h) - 'a' + 10);
+                ++n;
+            }
+            if (!n) fail("\\x sin dígitos hexadecimales");
+            return (unsigned char)v;
+        }
+        default: return (unsigned char)e;
+        }
+    }
+
+    NodePtr parseClass() {
+        std::bitset<256> set;
+        bool negate = false;
+        if (!end() && peek() == '^') { negate = true; ++pos_; }
+        bool first = true;
+        while (!end() && (peek() != ']' || first)) {
+            first = false;
+            unsigned char lo;
+            if (peek() == '\\') {
+                ++pos_;
+                if (end()) break;
+                if (classEscape(set)) continue;
+                lo = escapeChar();
+            } else {
+                lo = (unsigned char)pat_[pos_++];
+            }
+            unsigned char hi = lo;
+            if (pos_ + 1 < pat_.size() && peek() == '-' && pat_[pos_ + 1] != ']') {
+                ++pos_;
+                if (peek() == '\\') { ++pos_; hi = escapeChar(); }
+                else hi = (unsigned char)pat_[pos_++];
+                if (hi < lo) { fail("rango inválido en [...]"); break; }
+            }
+            for (int c = lo; c <= hi; ++c) set.set(c);
+        }
+        if (end()) { fail("falta ']'"); return NodePtr(new Node(Node::Empty)); }
+        ++pos_;
+        if (!cs_) fold(set);
+        if (negate) { set.flip(); set.reset('\n'); }
+        NodePtr n(new Node(Node::Cls));
+        n->cls = addClass(set);
+        return n;
+    }
+
+    // ── Nodos hoja ────────────────────────────────────────────────
+    NodePtr lit(unsigned char c) {
+        if (!cs_ && std::isalpha(c)) {
+            std::bitset<256> set;
+            set.set(c);
+            return cls(set);
+        }
+        NodePtr n(new Node(Node::Lit));
+        n->c = c;
+        return n;
+    }
+
+    NodePtr cls(std::bitset<256> set) {
+        if (!cs_) fold(set);
+        NodePtr n(new Node(Node::Cls));
+        n->cls = addClass(set);
+        return n;
+    }
+
+    // Pliegue ASCII de mayúsculas, como ::tolower en la búsqueda literal
+    static void fold(std::bitset<256>& set) {
+        for (int c = 'a'; c <= 'z'; ++c)
+            if (set[c] || set[c - 'a' + 'A']) { set.set(c); set.set(c - 'a' + 'A'); }
+    }
+
+    int addClass(const std::bitset<256>& set) {
+        re_.classes_.push_back(set);
+        return (int)re_.classes_.size() - 1;
+    }
+
+    // ── Emisión ───────────────────────────────────────────────────
+    int pc() const { return (int)re_.prog_.size(); }
+
+    int emit(Regex::Inst in) {
+        re_.prog_.push_back(in);
+        return pc() - 1;
+    }
+
+    int emitSplit(bool greedy) {
+        return emit({ Regex::Split, 0, greedy ? 0 : -1, greedy ? -1 : 0 });
+    }
+
+    // Completa la rama "seguir" (x si es perezoso, y si es codicioso)
+    void patchSplit(int at, int cont, int skip) {
+        Regex::Inst& in = re_.prog_[at];
+        if (in.x == 0) { in.x = cont; in.y = skip; }
+        else           { in.x = skip; in.y = cont; }
+    }
+
+    void gen(const Node& n) {
+        if (pc() > kMaxProgram) return;
+        switch (n.kind) {
+        case Node::Empty: break;
+        case Node::Lit:   emit({ Regex::Char, n.c, 0, 0 }); break;
+        case Node::Cls:   emit({ Regex::Class, 0, n.cls, 0 }); break;
+        case Node::Bol:   emit({ Regex::Bol, 0, 0, 0 }); break;
+        case Node::Eol:   emit({ Regex::Eol, 0, 0, 0 }); break;
+        case Node::WordB:    emit({ Regex::WordB, 0, 0, 0 }); break;
+        case Node::NotWordB: emit({ Regex::NotWordB, 0, 0, 0 }); break;
+        case Node::Cat:
+            for (const auto& k : n.kids) gen(*k);
+            break;
+        case Node::Group:
+            emit({ Regex::Save, 0, 2 * n.group, 0 });
+            gen(*n.kids[0]);
+            emit({ Regex::Save, 0, 2 * n.group + 1, 0 });
+            break;
+        case Node::Alt: {
+            std::vector<int> jumps;
+            for (size_t i = 0; i + 1 < n.kids.size(); ++i) {
+                int split = emit({ Regex::Split, 0, 0, 0 });
+                re_.prog_[split].x = pc();
+                gen(*n.kids[i]);
+                jumps.push_back(emit({ Regex::Jmp, 0, 0, 0 }));
+                re_.prog_[split].y = pc();
+            }
+            gen(*n.kids.back());
+            for (int j : jumps) re_.prog_[j].x = pc();
+            break;
+        }
+        case Node::Rep:
+            genRepeat(n);
+            break;
+        }
+    }
+
+    void genRepeat(const Node& n) {
+        const Node& body = *n.kids[0];
+        if (n.max == -1) {
+            // m-1 copias y luego e+ (o e* si m == 0)
+            for (int i = 1; i < n.min; ++i) gen(body);
+            if (n.min == 0) {
+                int split = emitSplit(n.greedy);
+                gen(body);
+                emit({ Regex::Jmp, 0, split, 0 });
+                patchSplit(split, split + 1, pc());
+            } else {
+                int top = pc();
+                gen(body);
+                int split = emitSplit(n.greedy);
+                patchSplit(split, top, pc());
+            }
+            return;
+        }
+        for (int i = 0; i < n.min; ++i) gen(body);
+        // Opcionales anidados: e{0,k} = (e(e(...)?)?)?
+        std::vector<int> splits;
+        for (int i = n.min; i < n.max; ++i) {
+            splits.push_back(emitSplit(n.greedy));
+            gen(body);
+        }
+        for (int s : splits) patchSplit(s, s + 1, pc());
+    }
+};
+
+// ── Regex ─────────────────────────────────────────────────────────
+std::shared_ptr<const Regex> Regex::compile(const std::string& pattern,
+                                            bool caseSensitive,
+                                            std::string& error) {
+    std::shared_ptr<Regex> re(new Regex());
+    RegexCompiler comp(pattern, caseSensitive, *re);
+    if (!comp.run(error)) return nullptr;
+    return re;
+}
+
+std::string Regex::expand(const std::string& tmpl, const char* line,
+                          const std::vector<long>& caps) const {
+    std::string out;
+    out.reserve(tmpl.size());
+    for (size_t i = 0; i < tmpl.size(); ++i) {
+        char ch = tmpl[i];
+        if (ch != '$' || i + 1 >= tmpl.size()) { out += ch; continue; }
+
+        char nx = tmpl[i + 1];
+        int  g  = -1;
+        size_t skip = 0;
+        if (nx == '$') {
+            out += '$';
+            ++i;
+            continue;
+        } else if (std::isdigit((unsigned char)nx)) {
+            g = nx - '0';
+            skip = 1;
+        } else if (nx == '{') {
+            size_t close = tmpl.find('}', i + 2);
+            if (close != std::string::npos && close > i + 2 &&
+                std::all_of(tmpl.begin() + i + 2, tmpl.begin() + close,
+                            [](char d) { return std::isdigit((unsigned char)d); })) {
+                g = std::atoi(tmpl.c_str() + i + 2);
+                skip = close - i;
+            }
+        }
+        if (g < 0 || g > groups_) { out += ch; continue; }
+
+        long a = caps[2 * g], b = caps[2 * g + 1];
+        if (a >= 0 && b >= a) out.append(line + a, b - a);
+        i += skip;
+    }
+    return out;
+}
+
+// ── RegexMatcher ──────────────────────────────────────────────────
+RegexMatcher::RegexMatcher(std::shared_ptr<const Regex> re)
+    : re_(std::move(re))
+{
+    size_t n = re_->prog_.size();
+    size_t slots = 2 * (re_->groups_ + 1);
+    for (Threads* l : { &clist_, &nlist_ }) {
+        l->sparse.assign(n, 0);
+        l->caps.assign(n * slots, -1);
+        l->dense.reserve(n);
+    }
+    scratch_.assign(slots, -1);
+    resetCache();
+}
+
+// ── DFA perezoso ──────────────────────────────────────────────────
+// Un estado es el conjunto de instrucciones que consumen (más Match y
+// los '$' pendientes) alcanzables tras la clausura. \b y \B se tratan
+// como siempre ciertos: el DFA puede dar falsos positivos, nunca
+// falsos negativos, y la máquina de Pike confirma cada línea.
+void RegexMatcher::closure(int pc, bool atBol, bool atEol,
+                           std::vector<char>& seen, std::vector<int>& out) const {
+    const std::vector<Regex::Inst>& prog = re_->prog_;
+    std::vector<int> stack{ pc };
+    while (!stack.empty()) {
+        int p = stack.back();
+        stack.pop_back();
+        if (seen[p]) continue;
+        seen[p] = 1;
+        const Regex::Inst& in = prog[p];
+        switch (in.op) {
+        case Regex::Jmp:   stack.push_back(in.x); break;
+        case Regex::Split: stack.push_back(in.y); stack.push_back(in.x); break;
+        case Regex::Save:
+        case Regex::WordB:
+        case Regex::NotWordB:
+            stack.push_back(p + 1);
+            break;
+        case Regex::Bol:
+            if (atBol) stack.push_back(p + 1);
+            break;
+        case Regex::Eol:
+            if (atEol) stack.push_back(p + 1);
+            else       out.push_back(p);
+            break;
+        default:
+            out.push_back(p);
+            break;
+        }
+    }
+}
+
+int RegexMatcher::intern(std::vector<int>& pcs) {
+    std::sort(pcs.begin(), pcs.end());
+    auto it = ids_.find(pcs);
+    if (it != ids_.end()) return it->second;
+
+    std::unique_ptr<DState> st(new DState());
+    st->pcs      = pcs;
+    st->match    = false;
+    st->eolMatch = -1;
+    for (int p : pcs)
+        if (re_->prog_[p].op == Regex::Match) st->match = true;
+
+    int id = (int)states_.size();
+    states_.push_back(std::move(st));
+    ids_.emplace(pcs, id);
+    table_.resize(table_.size() + 256, -1);
+    return id;
+}
+
+void RegexMatcher::resetCache() {
+    states_.clear();
+    ids_.clear();
+    table_.clear();
+
+    size_t n = re_->prog_.size();
+    std::vector<char> seen(n, 0);
+    restart_.clear();
+    closure(0, false, false, seen, restart_);
+
+    std::vector<int> pcs;
+    seen.assign(n, 0);
+    closure(0, true, false, seen, pcs);
+    startBol_ = intern(pcs);
+
+    pcs = restart_;
+    startMid_ = intern(pcs);
+}
+
+int RegexMatcher::step(int& s, unsigned char b) {
+    const std::vector<Regex::Inst>& prog = re_->prog_;
+    std::vector<char> seen(prog.size(), 0);
+    std::vector<int>  pcs;
+    for (int p : states_[s]->pcs) {
+        const Regex::Inst& in = prog[p];
+        if ((in.op == Regex::Char || in.op == Regex::Class) && re_->consumes(in, b))
+            closure(p + 1, false, false, seen, pcs);
+    }
+    // Búsqueda no anclada: en cada posición puede empezar otra coincidencia
+    for (int p : restart_)
+        if (!seen[p]) { seen[p] = 1; pcs.push_back(p); }
+
+    if (states_.size() >= kMaxDfaStates) {
+        // Caché llena: se vacía y se reconstruyen el origen y el destino
+        std::vector<int> src = states_[s]->pcs;
+        resetCache();
+        s = intern(src);
+    }
+    int id = intern(pcs);
+    if (b != '\n')
+        table_[s * 256 + b] = (b == '\r' || states_[id]->match) ? -id - 2 : id * 256;
+    return id;
+}
+
+bool RegexMatcher::acceptsAtEol(int s) {
+    DState& st = *states_[s];
+    if (st.eolMatch < 0) {
+        bool ok = st.match;
+        std::vector<char> seen(re_->prog_.size(), 0);
+        std::vector<int>  pcs;
+        for (int p : st.pcs) {
+            if (ok) break;
+            if (re_->prog_[p].op != Regex::Eol) continue;
+            pcs.clear();
+            closure(p + 1, true, true, seen, pcs);
+            for (int q : pcs)
+                if (re_->prog_[q].op == Regex::Match) ok = true;
+        }
+        st.eolMatch = ok;
+    }
+    return st.eolMatch == 1;
+}
+
+void RegexMatcher::scanLines(const TextBuffer& buf, uint64_t from, uint64_t to,
+                             const std::function<bool(uint64_t, uint64_t)>& fn) {
+    int      cur       = startBol_ * 256;   // fila del estado actual
+    int      beforeCr  = startBol_;
+    bool     lastCr    = false;             // el byte anterior fue '\r'
+    bool     hit       = states_[startBol_]->match;
+    uint64_t lineStart = from;
+    uint64_t at        = from;
+
+    bool go = buf.forEachSpanWhile(from, to - from, [&](const char* data, size_t n) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+        const int* tbl = table_.data();
+        size_t i = 0;
+        while (i < n) {
+            if (hit) {
+                // La línea ya es candidata: saltar hasta su fin
+                const void* nl = memchr(p + i, '\n', n - i);
+                size_t k = nl ? (size_t)((const unsigned char*)nl - p) : n;
+                if (k > i) lastCr = p[k - 1] == '\r';
+                i = k;
+                if (i == n) break;
+            } else {
+                // Ruta rápida: transiciones ya calculadas (nunca '\r')
+                size_t i0 = i;
+                int v;
+                while (i < n && (v = tbl[cur + p[i]]) >= 0) {
+                    cur = v;
+                    ++i;
+                }
+                if (i > i0) lastCr = false;
+                if (i == n) break;
+            }
+
+            unsigned char b = p[i];
+            if (b == '\n') {
+                uint64_t lineEnd = at + i - (lastCr ? 1 : 0);
+                int      st      = lastCr ? beforeCr : cur / 256;
+                if ((hit || acceptsAtEol(st)) && !fn(lineStart, lineEnd))
+                    return false;
+                cur       = startBol_ * 256;
+                hit       = states_[startBol_]->match;
+                lastCr    = false;
+                lineStart = at + i + 1;
+                ++i;
+                continue;
+            }
+
+            int prev = cur / 256;
+            int v    = tbl[cur + b];
+            int id   = v == -1 ? step(prev, b) : -v - 2;   // prev cambia si se vació la caché
+            tbl = table_.data();
+            if (b == '\r') beforeCr = prev;
+            lastCr = (b == '\r');
+            cur = id * 256;
+            hit = states_[id]->match;
+            ++i;
+        }
+        at += n;
+        return true;
+    });
+
+    // Última línea del documento (sin '\n' final)
+    if (go && to == buf.size()) {
+        uint64_t lineEnd = to - (lastCr ? 1 : 0);
+        if (hit || acceptsAtEol(lastCr ? beforeCr : cur / 256)) fn(lineStart, lineEnd);
+    }
+}
+
+bool RegexMatcher::mayMatch(const char* line, size_t len, size_t from) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(line);
+    const int* tbl = table_.data();
+    int cur = (from == 0 ? startBol_ : startMid_) * 256;
+    if (states_[cur / 256]->match) return true;
+    for (size_t i = from; i < len; ++i) {
+        int v = tbl[cur + p[i]];
+        if (v >= 0) {
+            cur = v;
+            continue;
+        }
+        int prev = cur / 256;
+        int id   = v == -1 ? step(prev, p[i]) : -v - 2;
+        tbl = table_.data();
+        if (states_[id]->match) return true;
+        cur = id * 256;
+    }
+    return acceptsAtEol(cur / 256);
+}
+
+// ── Máquina de Pike ───────────────────────────────────────────────
+// Hilos en orden de prioridad; cada pc entra una sola vez por posición.
+// Al llegar a Match se descartan los hilos de menor prioridad, lo que
+// da la semántica "primera alternativa" de Perl.
+void RegexMatcher::addThread(Threads& l, int pc, long* caps, const char* line,
+                             size_t len, size_t pos) {
+    if (l.has(pc)) return;
+    l.sparse[pc] = (int)l.dense.size();
+    l.dense.push_back(pc);
+
+    const Regex::Inst& in = re_->prog_[pc];
+    switch (in.op) {
+    case Regex::Jmp:
+        addThread(l, in.x, caps, line, len, pos);
+        break;
+    case Regex::Split:
+        addThread(l, in.x, caps, line, len, pos);
+        addThread(l, in.y, caps, line, len, pos);
+        break;
+    case Regex::Save: {
+        long old = caps[in.x];
+        caps[in.x] = (long)pos;
+        addThread(l, pc + 1, caps, line, len, pos);
+        caps[in.x] = old;
+        break;
+    }
+    case Regex::Bol:
+        if (pos == 0) addThread(l, pc + 1, caps, line, len, pos);
+        break;
+    case Regex::Eol:
+        if (pos == len) addThread(l, pc + 1, caps, line, len, pos);
+        break;
+    case Regex::WordB:
+    case Regex::NotWordB: {
+        bool a = pos > 0   && isWordByte((unsigned char)line[pos - 1]);
+        bool b = pos < len && isWordByte((unsigned char)line[pos]);
+        if ((a != b) == (in.op == Regex::WordB)) addThread(l, pc + 1, caps, line, len, pos);
+        break;
+    }
+    default: {
+        size_t slots = scratch_.size();
+        std::copy(caps, caps + slots, l.caps.begin() + pc * slots);
+        break;
+    }
+    }
+}
+
+bool RegexMatcher::search(const char* line, size_t len, size_t from,
+                          std::vector<long>& caps) {
+    // El DFA descarta rápido las líneas (o restos de línea) sin coincidencia
+    if (!mayMatch(line, len, from)) return false;
+
+    const std::vector<Regex::Inst>& prog = re_->prog_;
+    size_t slots = scratch_.size();
+    bool matched = false;
+
+    clist_.dense.clear();
+    for (size_t pos = from; ; ++pos) {
+        if (!matched) {
+            std::fill(scratch_.begin(), scratch_.end(), -1);
+            addThread(clist_, 0, scratch_.data(), line, len, pos);
+        }
+        if (clist_.dense.empty()) break;
+
+        nlist_.dense.clear();
+        for (size_t i = 0; i < clist_.dense.size(); ++i) {
+            int pc = clist_.dense[i];
+            const Regex::Inst& in = prog[pc];
+            long* tc = clist_.caps.data() + pc * slots;
+            if (in.op == Regex::Match) {
+                caps.assign(tc, tc + slots);
+                matched = true;
+                break;
+            }
+            if ((in.op == Regex::Char || in.op == Regex::Class) && pos < len &&
+                re_->consumes(in, (unsigned char)line[pos]))
+                addThread(nlist_, pc + 1, tc, line, len, pos + 1);
+        }
+        std::swap(clist_, nlist_);
+        if (pos >= len) break;
+    }
+    return matched;
+}
@@ -0,0 +1,26 @@
+#include "saveworker.h"
+#include <algorithm>
+
+SaveWorker::SaveWorker(std::string path, TextSnapshot snap, FileFormat fmt, FsyncPolicy policy)
+    : path_(std::move(path)), snap_(std::move(snap)), fmt_(fmt), policy_(policy),
+      written_(0), done_(false), ok_(false)
+{
+    thread_ = std::thread([this] {
+        // ok_ y error_ se publican con done_ (atomic)
+        ok_   = FileManager::writeSnapshot(path_, snap_, fmt_, policy_, &written_, &error_);
+        done_ = true;
+    });
+}
+
+SaveWorker::~SaveWorker() {
+    wait();
+}
+
+void SaveWorker::wait() {
+    if (thread_.joinable()) thread_.join();
+}
+
+double SaveWorker::progress() const {
+    if (done_ || snap_.size() == 0) return 1.0;
+    return std::min(1.0, (double)written_ / (double)snap_.size());
+}
@@ -0,0 +1,188 @@
+#include "searchkernel.h"
+#include "textbuffer.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SEARCHKERNEL_X86 1
+#endif
+
+typedef uint64_t (*FindFn)(const char*, size_t, size_t, const std::string&, bool);
+
+// ── Pliegue ASCII ─────────────────────────────────────────────────
+static inline unsigned char fold(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c;
+}
+
+// Compara la aguja completa en p (la aguja ya viene plegada)
+static inline bool verifyAt(const char* p, const std::string& nd, bool cs) {
+    size_t n = nd.size();
+    if (cs) return memcmp(p, nd.data(), n) == 0;
+    for (size_t i = 0; i < n; ++i)
+        if (fold((unsigned char)p[i]) != (unsigned char)nd[i]) return false;
+    return true;
+}
+
+// ── Respaldo escalar ──────────────────────────────────────────────
+static uint64_t findScalar(const char* hay, size_t len, size_t from,
+                           const std::string& nd, bool cs) {
+    size_t n = nd.size();
+    if (n == 0 || len < n || from > len - n) return SearchKernel::npos;
+    unsigned char first = (unsigned char)nd[0];
+    for (size_t i = from; i <= len - n; ++i) {
+        unsigned char c = (unsigned char)hay[i];
+        if ((cs ? c : fold(c)) == first && verifyAt(hay + i, nd, cs))
+            return i;
+    }
+    return SearchKernel::npos;
+}
+
+#ifdef SEARCHKERNEL_X86
+#ifdef __SSE2__
+// ── SSE2: 16 candidatos por iteración ─────────────────────────────
+static inline __m128i fold16(__m128i v) {
+    __m128i ge = _mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1));
+    __m128i le = _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1));
+    return _mm_or_si128(v, _mm_and_si128(_mm_and_si128(ge, le), _mm_set1_epi8(0x20)));
+}
+
+static uint64_t findSse2(const char* hay, size_t len, size_t from,
+                         const std::string& nd, bool cs) {
+    size_t n = nd.size();
+    if (n == 0 || len < n || from > len - n) return SearchKernel::npos;
+
+    const __m128i first = _mm_set1_epi8(nd[0]);
+    const __m128i last  = _mm_set1_epi8(nd[n - 1]);
+    size_t i = from;
+    for (; i + n - 1 + 16 <= len; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i + n - 1));
+        if (!cs) { a = fold16(a); b = fold16(b); }
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while (mask) {
+            size_t k = i + (size_t)__builtin_ctz(mask);
+            if (verifyAt(hay + k, nd, cs)) return k;
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(hay, len, i, nd, cs);
+}
+#endif
+
+// ── AVX2: 32 candidatos por iteración ─────────────────────────────
+__attribute__((target("avx2")))
+static inline __m256i fold32(__m256i v) {
+    __m256i ge = _mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1));
+    __m256i le = _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v);
+    return _mm256_or_si256(v, _mm256_and_si256(_mm256_and_si256(ge, le), _mm256_set1_epi8(0x20)));
+}
+
+__attribute__((target("avx2")))
+static uint64_t findAvx2(const char* hay, size_t len, size_t from,
+                         const std::string& nd, bool cs) {
+    size_t n = nd.size();
+    if (n == 0 || len < n || from > len - n) return SearchKernel::npos;
+
+    const __m256i first = _mm256_set1_epi8(nd[0]);
+    const __m256i last  = _mm256_set1_epi8(nd[n - 1]);
+    size_t i = from;
+    for (; i + n - 1 + 32 <= len; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hay + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hay + i + n - 1));
+        if (!cs) { a = fold32(a); b = fold32(b); }
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        while (mask) {
+            size_t k = i + (size_t)__builtin_ctz(mask);
+            if (verifyAt(hay + k, nd, cs)) return k;
+            mask &= mask - 1;
+        }
+    }
+    return findScalar(hay, len, i, nd, cs);
+}
+#endif
+
+// ── Selección de implementación ───────────────────────────────────
+static FindFn pickFind(const char** name) {
+#ifdef SEARCHKERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) { *name = "avx2"; return findAvx2; }
+#ifdef __SSE2__
+    *name = "sse2";
+    return findSse2;
+#endif
+#endif
+    *name = "scalar";
+    return findScalar;
+}
+
+static const char* gBackend = nullptr;
+static FindFn      gFind    = pickFind(&gBackend);
+
+const char* SearchKernel::backend() {
+    return gBackend;
+}
+
+// ── API ───────────────────────────────────────────────────────────
+SearchKernel::SearchKernel(const std::string& needle, bool caseSensitive)
+    : needle_(needle), caseSensitive_(caseSensitive)
+{
+    // La aguja se pliega una sola vez
+    if (!caseSensitive_)
+        for (char& c : needle_) c = (char)fold((unsigned char)c);
+}
+
+uint64_t SearchKernel::find(const char* hay, size_t len, size_t from) const {
+    return gFind(hay, len, from, needle_, caseSensitive_);
+}
+
+// Recorrido por tramos común a TextBuffer y TextSnapshot
+template <class Source>
+uint64_t SearchKernel::findSpans(const Source& buf, uint64_t from, uint64_t to) const {
+    size_t n = needle_.size();
+    if (n == 0 || to <= from || to - from < n) return npos;
+
+    // carry: últimos n-1 bytes ya vistos, para coincidencias que
+    // empiezan en una pieza y terminan en la siguiente
+    std::string carry;
+    uint64_t carryStart = from;
+    uint64_t pos   = from;
+    uint64_t found = npos;
+
+    buf.forEachSpanWhile(from, to - from, [&](const char* p, size_t len) {
+        if (!carry.empty()) {
+            size_t old = carry.size();
+            carry.append(p, std::min(len, n - 1));
+            uint64_t k = find(carry.data(), carry.size(), 0);
+            if (k != npos && k < old) { found = carryStart + k; return false; }
+            carry.resize(old);
+        }
+
+        uint64_t k = find(p, len, 0);
+        if (k != npos) { found = pos + k; return false; }
+        pos += len;
+
+        // Conservar la cola para el siguiente tramo
+        if (n > 1) {
+            if (len >= n - 1) {
+                carry.assign(p + len - (n - 1), n - 1);
+            } else {
+                carry.append(p, len);
+                if (carry.size() > n - 1) carry.erase(0, carry.size() - (n - 1));
+            }
+            carryStart = pos - carry.size();
+        }
+        return true;
+    });
+    return found;
+}
+
+uint64_t SearchKernel::find(const TextBuffer& buf, uint64_t from, uint64_t to) const {
+    return findSpans(buf, from, to);
+}
+
+uint64_t SearchKernel::find(const TextSnapshot& snap, uint64_t from, uint64_t to) const {
+    return findSpans(snap, from, to);
+}
@@ -1,4 +1,5 @@
 #include "statusbar.h"
+#include <algorithm>
 #include <sstream>
 #include <cstring>
 
@@ -23,7 +24,7 @@ void StatusBar::resize(int y, int x, int width) {
 
 void StatusBar::draw(int row, int col,
                      const std::string& filename,
-                     bool dirty, int totalLines)
+                     bool dirty, int totalLines, bool totalKnown)
 {
     werase(win_);
     wbkgd(win_, COLOR_PAIR(COLOR_STATUS));
@@ -43,6 +44,7 @@ void StatusBar::draw(int row, int col,
         // Derecha: posición del cursor
         std::ostringstream right;
         right << "Ln " << (row + 1) << "/" << totalLines
+              << (totalKnown ? "" : "+")
               << "  Col " << (col + 1)
               << "  F1:Ayuda";
 
@@ -56,7 +58,26 @@ void StatusBar::draw(int row, int col,
     }
 
     wattroff(win_, COLOR_PAIR(COLOR_STATUS));
-    wrefresh(win_);
+    wnoutrefresh(win_);
+}
+
+void StatusBar::drawPrompt(const std::string& label, const std::string& text,
+                           const std::string& info) {
+    werase(win_);
+    wbkgd(win_, COLOR_PAIR(COLOR_STATUS));
+    wattron(win_, COLOR_PAIR(COLOR_STATUS));
+
+    int infoLen = (int)info.size();
+    mvwprintw(win_, 0, width_ - infoLen - 1, "%s", info.c_str());
+
+    // Si no entra, se muestra el final del texto (donde se escribe)
+    int room = std::max(0, width_ - infoLen - (int)label.size() - 4);
+    std::string shown = (int)text.size() > room ? text.substr(text.size() - room) : text;
+    mvwprintw(win_, 0, 1, "%s %s", label.c_str(), shown.c_str());
+
+    wattroff(win_, COLOR_PAIR(COLOR_STATUS));
+    wmove(win_, 0, 2 + (int)label.size() + (int)shown.size());
+    wnoutrefresh(win_);
 }
 
 void StatusBar::showMessage(const std::string& msg, int /*durationMs*/) {
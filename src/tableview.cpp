@@ -0,0 +1,156 @@
+#include "tableview.h"
+#include "csvtable.h"
+#include <algorithm>
+#include <vector>
+
+#define COLOR_TABLE_HEADER 8
+#define COLOR_TABLE_CELL   9
+
+// Columnas de pantalla entre celda y celda (" │ ")
+static const int kSeparator = 3;
+
+// ── Constructor / Destructor ──────────────────────────────────────
+TableView::TableView(int y, int x, int height, int width)
+    : height_(height), width_(width), table_(nullptr),
+      curRow_(0), curCol_(0), topRow_(0), leftCol_(0)
+{
+    init_pair(COLOR_TABLE_HEADER, COLOR_BLACK, COLOR_CYAN);
+    init_pair(COLOR_TABLE_CELL,   COLOR_BLACK, COLOR_WHITE);
+    win_ = newwin(height, width, y, x);
+    wbkgd(win_, COLOR_PAIR(1));
+}
+
+TableView::~TableView() {
+    if (win_) delwin(win_);
+}
+
+void TableView::resize(int y, int x, int height, int width) {
+    height_ = height;
+    width_  = width;
+    wresize(win_, height, width);
+    mvwin(win_, y, x);
+    scrollToCursor();
+}
+
+void TableView::setTable(const CsvTable* table) {
+    table_  = table;
+    curRow_ = curCol_ = topRow_ = leftCol_ = 0;
+}
+
+// ── Navegación ────────────────────────────────────────────────────
+void TableView::gotoRow(size_t i) {
+    size_t n = table_ ? table_->viewCount() : 0;
+    curRow_ = n == 0 ? 0 : std::min(i, n - 1);
+    scrollToCursor();
+}
+
+void TableView::gotoColumn(size_t col) {
+    size_t n = table_ ? table_->columnCount() : 0;
+    curCol_ = n == 0 ? 0 : std::min(col, n - 1);
+    scrollToCursor();
+}
+
+bool TableView::handleInput(int ch) {
+    if (!table_) return false;
+    size_t page = std::max(1, dataHeight() - 1);
+    switch (ch) {
+    case KEY_UP:    if (curRow_ > 0) --curRow_;                        break;
+    case KEY_DOWN:  gotoRow(curRow_ + 1);                              break;
+    case KEY_PPAGE: curRow_ = curRow_ > page ? curRow_ - page : 0;     break;
+    case KEY_NPAGE: gotoRow(curRow_ + page);                           break;
+    case KEY_LEFT:
+    case KEY_BTAB:  if (curCol_ > 0) --curCol_;                        break;
+    case KEY_RIGHT:
+    case '\t':      gotoColumn(curCol_ + 1);                           break;
+    case KEY_HOME:  curCol_ = 0;                                       break;
+    case KEY_END:   gotoColumn(table_->columnCount());                 break;
+    default:        return false;
+    }
+    scrollToCursor();
+    return true;
+}
+
+int TableView::gutterWidth() const {
+    size_t n = table_ ? table_->rowCount() : 0;
+    int digits = 1;
+    for (; n >= 10; n /= 10) ++digits;
+    return digits + 1;
+}
+
+void TableView::scrollToCursor() {
+    if (!table_) return;
+    size_t h = (size_t)std::max(1, dataHeight());
+    if (curRow_ < topRow_) topRow_ = curRow_;
+    if (curRow_ >= topRow_ + h) topRow_ = curRow_ - h + 1;
+
+    // La columna del cursor entra entera si cabe
+    const std::vector<int>& w = table_->widths();
+    if (curCol_ < leftCol_) leftCol_ = curCol_;
+    int avail = width_ - gutterWidth();
+    for (;;) {
+        int used = 0;
+        for (size_t c = leftCol_; c <= curCol_ && c < w.size(); ++c) used += w[c] + kSeparator;
+        if (used <= avail || leftCol_ >= curCol_) break;
+        ++leftCol_;
+    }
+}
+
+// ── Dibujo ────────────────────────────────────────────────────────
+// Hasta `cells` caracteres de pantalla (UTF-8), rellenado con espacios
+static std::string fit(const std::string& s, int cells) {
+    std::string out;
+    int w = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        bool lead = ((unsigned char)s[i] & 0xC0) != 0x80;
+        if (lead && w == cells) break;
+        if (lead) ++w;
+        out += s[i];
+    }
+    out.append((size_t)(cells - w), ' ');
+    return out;
+}
+
+void TableView::drawRow(int y, size_t row, bool header) {
+    const std::vector<int>& w = table_->widths();
+    int gutter = gutterWidth();
+    attr_t base = header ? (COLOR_PAIR(COLOR_TABLE_HEADER) | A_BOLD) : COLOR_PAIR(1);
+
+    wmove(win_, y, 0);
+    wattrset(win_, base);
+    std::string num = header ? "" : std::to_string(row + 1);
+    waddstr(win_, fit(std::string((size_t)std::max(0, gutter - 1 - (int)num.size()), ' ') + num,
+                      gutter).c_str());
+
+    std::vector<CsvTable::Field> fields;
+    table_->fields(row, fields);
+    int x = gutter;
+    for (size_t c = leftCol_; c < w.size() && x < width_; ++c) {
+        std::string cell;
+        if (c < fields.size()) cell = table_->text(fields[c], (size_t)w[c] * 4);
+        int cw = std::min(w[c], width_ - x);
+        bool cur = !header && c == curCol_ && row == table_->viewRow(curRow_);
+        wattrset(win_, cur ? COLOR_PAIR(COLOR_TABLE_CELL) : base);
+        waddstr(win_, fit(cell, cw).c_str());
+        x += cw;
+        wattrset(win_, base);
+        if (x + kSeparator <= width_) {
+            waddch(win_, ' ');
+            waddch(win_, ACS_VLINE);
+            waddch(win_, ' ');
+            x += kSeparator;
+        }
+    }
+    if (x < width_) waddstr(win_, std::string((size_t)(width_ - x), ' ').c_str());
+    wattrset(win_, A_NORMAL);
+}
+
+void TableView::draw() {
+    werase(win_);
+    if (table_ && table_->rowCount() > 0) {
+        drawRow(0, 0, true);
+        size_t n = table_->viewCount();
+        for (int y = 1; y < height_ && topRow_ + y - 1 < n; ++y)
+            drawRow(y, table_->viewRow(topRow_ + y - 1), false);
+    }
+    wnoutrefresh(win_);
+}
@@ -0,0 +1,636 @@
+#include "textbuffer.h"
+#include "lineindexer.h"
+#include <algorithm>
+#include <cstring>
+
+// Tamaño mínimo de cada bloque de añadidos
+static const size_t kAddBlockSize = 1 << 20;
+// Bytes del original que se indexan por tramo en carga perezosa
+static const uint64_t kIndexChunk = 1 << 20;
+
+struct TextBuffer::Node {
+    Piece    piece;
+    uint32_t prio;
+    Node*    left  = nullptr;
+    Node*    right = nullptr;
+    uint64_t len   = 0;   // bytes del subárbol
+    uint64_t lf    = 0;   // '\n' del subárbol
+};
+
+// ── Helpers internos ──────────────────────────────────────────────
+template <typename N> static inline uint64_t subLen(const N* n) { return n ? n->len : 0; }
+template <typename N> static inline uint64_t subLf (const N* n) { return n ? n->lf  : 0; }
+
+// ── Constructores ─────────────────────────────────────────────────
+TextBuffer::TextBuffer()
+    : root_(nullptr), seed_(0x9e3779b9u), eol_("\n"),
+      scanned_(0), loadedEnd_(0)
+{
+    // Bloque 0 vacío: el "original" de un documento nuevo
+    blocks_.push_back(std::make_shared<Block>());
+}
+
+TextBuffer::TextBuffer(std::shared_ptr<const MappedFile> file, bool lazy)
+    : TextBuffer()
+{
+    // Aun vacío, el original recuerda una codificación que no sea UTF-8
+    if (!file || (file->size() == 0 && file->encoding().plain())) return;
+
+    Block& orig = *blocks_[0];
+    orig.file = file;
+    if (file->size() == 0) return;
+
+    orig.data     = file->data();
+    orig.size     = file->size();
+    orig.capacity = file->size();
+
+    // Respetar el fin de línea del archivo
+    const char* nl = static_cast<const char*>(memchr(orig.data, '\n', orig.size));
+    if (nl && nl > orig.data && nl[-1] == '\r')
+        eol_ = "\r\n";
+
+    if (!lazy) loadAll();
+}
+
+TextEncoding TextBuffer::encoding() const {
+    return blocks_[0]->file ? blocks_[0]->file->encoding() : TextEncoding();
+}
+
+TextBuffer::~TextBuffer() {
+    worker_.reset();   // detener el hilo antes de soltar el mapeo
+    destroy(root_);
+}
+
+TextBuffer::TextBuffer(TextBuffer&& other) noexcept
+    : blocks_(std::move(other.blocks_)), root_(other.root_),
+      seed_(other.seed_), eol_(std::move(other.eol_)),
+      scanned_(other.scanned_), loadedEnd_(other.loadedEnd_),
+      worker_(std::move(other.worker_))
+{
+    other.root_ = nullptr;
+}
+
+TextBuffer& TextBuffer::operator=(TextBuffer&& other) noexcept {
+    if (this != &other) {
+        worker_.reset();
+        destroy(root_);
+        blocks_ = std::move(other.blocks_);
+        root_   = other.root_;
+        seed_   = other.seed_;
+        eol_    = std::move(other.eol_);
+        scanned_   = other.scanned_;
+        loadedEnd_ = other.loadedEnd_;
+        worker_     = std::move(other.worker_);
+        other.root_ = nullptr;
+    }
+    return *this;
+}
+
+// ── Treap ─────────────────────────────────────────────────────────
+uint32_t TextBuffer::nextPrio() {
+    // xorshift32: prioridades pseudoaleatorias para balancear el treap
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    return seed_;
+}
+
+TextBuffer::Node* TextBuffer::newNode(const Piece& p) {
+    Node* n  = new Node();
+    n->piece = p;
+    n->prio  = nextPrio();
+    update(n);
+    return n;
+}
+
+void TextBuffer::update(Node* t) {
+    t->len = subLen(t->left) + t->piece.length  + subLen(t->right);
+    t->lf  = subLf(t->left)  + t->piece.lfCount + subLf(t->right);
+}
+
+TextBuffer::Node* TextBuffer::merge(Node* a, Node* b) {
+    if (!a) return b;
+    if (!b) return a;
+    if (a->prio > b->prio) {
+        a->right = merge(a->right, b);
+        update(a);
+        return a;
+    }
+    b->left = merge(a, b->left);
+    update(b);
+    return b;
+}
+
+// Separa el árbol en [0, off) y [off, fin), partiendo una pieza si hace falta
+void TextBuffer::split(Node* t, uint64_t off, Node*& l, Node*& r) {
+    if (!t) { l = r = nullptr; return; }
+
+    uint64_t ll = subLen(t->left);
+    if (off <= ll) {
+        split(t->left, off, l, t->left);
+        update(t);
+        r = t;
+    } else if (off >= ll + t->piece.length) {
+        split(t->right, off - ll - t->piece.length, t->right, r);
+        update(t);
+        l = t;
+    } else {
+        uint64_t m   = off - ll;
+        Node*    tail = newNode(pieceTail(t->piece, m));
+        t->piece = pieceHead(t->piece, m);
+        Node* rest = t->right;
+        t->right = nullptr;
+        update(t);
+        l = t;
+        r = merge(tail, rest);
+    }
+}
+
+void TextBuffer::destroy(Node* t) {
+    if (!t) return;
+    destroy(t->left);
+    destroy(t->right);
+    delete t;
+}
+
+// Agrega la pieza al final del árbol. Si la última pieza termina justo
+// donde empieza la nueva (tecleo consecutivo, carga perezosa) se
+// extiende en lugar de crear otro nodo.
+TextBuffer::Node* TextBuffer::appendPiece(Node* t, const Piece& p) {
+    Node* tail = t;
+    while (tail && tail->right) tail = tail->right;
+    if (tail && tail->piece.buf == p.buf &&
+        tail->piece.start + tail->piece.length == p.start) {
+        for (Node* n = t; n; n = n->right) {
+            n->len += p.length;
+            n->lf  += p.lfCount;
+        }
+        tail->piece.length  += p.length;
+        tail->piece.lfCount += p.lfCount;
+        return t;
+    }
+    return merge(t, newNode(p));
+}
+
+// Recorrido en orden de todas las piezas
+void TextBuffer::collect(const Node* t, std::vector<Piece>& out) const {
+    if (!t) return;
+    collect(t->left, out);
+    out.push_back(t->piece);
+    collect(t->right, out);
+}
+
+// Árbol balanceado a partir de piezas en orden. Las prioridades se
+// sortean y se reparten de mayor a menor por niveles, así el resultado
+// sigue siendo un treap válido para las ediciones posteriores.
+TextBuffer::Node* TextBuffer::build(const std::vector<Piece>& pieces) {
+    if (pieces.empty()) return nullptr;
+
+    std::vector<Node*> nodes(pieces.size());
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        nodes[i] = new Node();
+        nodes[i]->piece = pieces[i];
+    }
+
+    std::function<Node*(size_t, size_t)> link = [&](size_t lo, size_t hi) -> Node* {
+        if (lo >= hi) return nullptr;
+        size_t mid = lo + (hi - lo) / 2;
+        Node* n  = nodes[mid];
+        n->left  = link(lo, mid);
+        n->right = link(mid + 1, hi);
+        update(n);
+        return n;
+    };
+    Node* root = link(0, nodes.size());
+
+    std::vector<uint32_t> prios(nodes.size());
+    for (auto& p : prios) p = nextPrio();
+    std::sort(prios.begin(), prios.end(), std::greater<uint32_t>());
+    std::vector<Node*> level{ root };
+    size_t next = 0;
+    for (size_t i = 0; i < level.size(); ++i) {
+        level[i]->prio = prios[next++];
+        if (level[i]->left)  level.push_back(level[i]->left);
+        if (level[i]->right) level.push_back(level[i]->right);
+    }
+    return root;
+}
+
+// ── Piezas ────────────────────────────────────────────────────────
+// Cantidad de '\n' entre el inicio de la pieza y su byte n
+uint64_t TextBuffer::lfBefore(const Piece& p, uint64_t n) const {
+    if (p.lfCount == 0) return 0;
+    const auto& lfs = blocks_[p.buf]->lfs;
+    auto first = lfs.begin() + p.lfFirst;
+    auto last  = first + p.lfCount;
+    return (uint64_t)(std::lower_bound(first, last, p.start + n) - first);
+}
+
+Piece TextBuffer::pieceHead(const Piece& p, uint64_t n) const {
+    return { p.buf, p.start, n, p.lfFirst, lfBefore(p, n) };
+}
+
+Piece TextBuffer::pieceTail(const Piece& p, uint64_t n) const {
+    uint64_t before = lfBefore(p, n);
+    return { p.buf, p.start + n, p.length - n,
+             p.lfFirst + before, p.lfCount - before };
+}
+
+Piece TextBuffer::pieceSlice(const Piece& p, uint64_t from, uint64_t to) const {
+    return pieceTail(pieceHead(p, to), from);
+}
+
+Piece TextBuffer::append(const char* data, size_t len) {
+    std::shared_ptr<Block> blk = blocks_.size() > 1 ? blocks_.back() : nullptr;
+    if (!blk || blk->capacity - blk->size < len) {
+        blk = std::make_shared<Block>();
+        blk->capacity = std::max(kAddBlockSize, len);
+        blk->mem.reset(new char[blk->capacity]);
+        blk->data = blk->mem.get();
+        blocks_.push_back(blk);
+    }
+
+    Piece p;
+    p.buf     = (uint32_t)(blocks_.size() - 1);
+    p.start   = blk->size;
+    p.length  = len;
+    p.lfFirst = blk->lfs.size();
+
+    memcpy(blk->mem.get() + blk->size, data, len);
+    LineIndexer::scan(data, len, blk->size, blk->lfs);
+    blk->size += len;
+
+    p.lfCount = blk->lfs.size() - p.lfFirst;
+    return p;
+}
+
+// ── Consultas ─────────────────────────────────────────────────────
+uint64_t TextBuffer::size() const {
+    return subLen(root_);
+}
+
+size_t TextBuffer::pieceCount() const {
+    size_t n = 0;
+    std::vector<const Node*> stack;
+    if (root_) stack.push_back(root_);
+    while (!stack.empty()) {
+        const Node* t = stack.back();
+        stack.pop_back();
+        ++n;
+        if (t->left)  stack.push_back(t->left);
+        if (t->right) stack.push_back(t->right);
+    }
+    return n;
+}
+
+size_t TextBuffer::memoryBytes() const {
+    size_t bytes = pieceCount() * sizeof(Node);
+    for (const auto& b : blocks_) {
+        bytes += b->lfs.capacity() * sizeof(uint64_t);
+        if (b->mem) bytes += b->capacity;
+    }
+    const Block& orig = *blocks_[0];
+    if (orig.file) {
+        uint64_t touched = std::max(scanned_, worker_ ? worker_->scanned() : 0);
+        bytes += orig.file->inMemory() ? orig.size : (size_t)std::min<uint64_t>(touched, orig.size);
+    }
+    return bytes;
+}
+
+int TextBuffer::lineCount() const {
+    return (int)subLf(root_) + 1;
+}
+
+uint64_t TextBuffer::lfOffset(uint64_t k) const {
+    const Node* t = root_;
+    uint64_t base = 0;
+    while (t) {
+        uint64_t llf = subLf(t->left);
+        if (k <= llf) { t = t->left; continue; }
+        k    -= llf;
+        base += subLen(t->left);
+        if (k <= t->piece.lfCount) {
+            const auto& lfs = blocks_[t->piece.buf]->lfs;
+            return base + lfs[t->piece.lfFirst + k - 1] - t->piece.start;
+        }
+        k    -= t->piece.lfCount;
+        base += t->piece.length;
+        t = t->right;
+    }
+    return size();
+}
+
+uint64_t TextBuffer::lineStart(int row) const {
+    if (row <= 0) return 0;
+    return lfOffset((uint64_t)row) + 1;
+}
+
+uint64_t TextBuffer::lineLength(int row) const {
+    uint64_t start = lineStart(row);
+    if (row + 1 >= lineCount()) return size() - start;
+
+    uint64_t nl  = lfOffset((uint64_t)row + 1);
+    uint64_t len = nl - start;
+    // "\r\n": el '\r' forma parte del terminador
+    if (len > 0 && at(nl - 1) == '\r') --len;
+    return len;
+}
+
+std::string TextBuffer::line(int row) const {
+    return substr(lineStart(row), lineLength(row));
+}
+
+int TextBuffer::lineAt(uint64_t offset) const {
+    const Node* t = root_;
+    uint64_t lines = 0;
+    while (t) {
+        uint64_t ll = subLen(t->left);
+        if (offset < ll) { t = t->left; continue; }
+        offset -= ll;
+        lines  += subLf(t->left);
+        if (offset < t->piece.length) {
+            lines += lfBefore(t->piece, offset);
+            break;
+        }
+        offset -= t->piece.length;
+        lines  += t->piece.lfCount;
+        t = t->right;
+    }
+    return (int)lines;
+}
+
+char TextBuffer::at(uint64_t offset) const {
+    const Node* t = root_;
+    while (t) {
+        uint64_t ll = subLen(t->left);
+        if (offset < ll) { t = t->left; continue; }
+        offset -= ll;
+        if (offset < t->piece.length)
+            return blocks_[t->piece.buf]->data[t->piece.start + offset];
+        offset -= t->piece.length;
+        t = t->right;
+    }
+    return '\0';
+}
+
+bool TextBuffer::visit(const Node* t, uint64_t base, uint64_t from, uint64_t to,
+                       const std::function<bool(const char*, size_t)>& fn) const {
+    if (!t || from >= to) return true;
+    uint64_t ll = subLen(t->left);
+    if (from < base + ll && !visit(t->left, base, from, to, fn))
+        return false;
+
+    uint64_t ps = base + ll;
+    uint64_t pe = ps + t->piece.length;
+    if (from < pe && to > ps) {
+        uint64_t a = std::max(from, ps);
+        uint64_t b = std::min(to, pe);
+        if (!fn(blocks_[t->piece.buf]->data + t->piece.start + (a - ps), (size_t)(b - a)))
+            return false;
+    }
+    if (to > pe)
+        return visit(t->right, pe, from, to, fn);
+    return true;
+}
+
+TextSnapshot TextBuffer::snapshot(bool withPendingTail) const {
+    std::vector<Piece> pieces;
+    collect(root_, pieces);
+
+    TextSnapshot snap;
+    snap.spans_.reserve(pieces.size() + 1);
+    for (const Piece& p : pieces) {
+        snap.spans_.push_back({ blocks_[p.buf]->data + p.start, p.length, snap.size_ });
+        snap.size_ += p.length;
+    }
+    std::string_view tail = pendingTail();
+    if (withPendingTail && !tail.empty()) {
+        snap.spans_.push_back({ tail.data(), tail.size(), snap.size_ });
+        snap.size_ += tail.size();
+    }
+    snap.keep_.assign(blocks_.begin(), blocks_.end());
+    snap.original_ = blocks_[0]->file;
+    return snap;
+}
+
+void TextBuffer::forEachSpan(uint64_t offset, uint64_t len,
+                             const std::function<void(const char*, size_t)>& fn) const {
+    forEachSpanWhile(offset, len, [&](const char* p, size_t n) { fn(p, n); return true; });
+}
+
+bool TextBuffer::forEachSpanWhile(uint64_t offset, uint64_t len,
+                                  const std::function<bool(const char*, size_t)>& fn) const {
+    return visit(root_, 0, offset, std::min(offset + len, size()), fn);
+}
+
+std::string TextBuffer::substr(uint64_t offset, uint64_t len) const {
+    std::string out;
+    out.reserve((size_t)std::min(len, size()));
+    forEachSpan(offset, len, [&](const char* p, size_t n) { out.append(p, n); });
+    return out;
+}
+
+std::string TextBuffer::text() const {
+    return substr(0, size());
+}
+
+void TextBuffer::replaceMatches(const std::vector<uint64_t>& offsets, uint64_t len,
+                                const std::string& replacement) {
+    if (offsets.empty()) return;
+
+    // Todas las coincidencias comparten la misma pieza de reemplazo
+    Piece repl{};
+    if (!replacement.empty()) repl = append(replacement.data(), replacement.size());
+
+    std::vector<Splice> splices;
+    splices.reserve(offsets.size());
+    for (uint64_t m : offsets) splices.push_back({ m, len, repl });
+    splice(splices);
+}
+
+void TextBuffer::applyEdits(const std::vector<TextEdit>& edits) {
+    if (edits.empty()) return;
+
+    // Los textos nuevos se copian juntos, en un solo append
+    std::string joined;
+    size_t total = 0;
+    for (const auto& e : edits) total += e.text.size();
+    joined.reserve(total);
+    for (const auto& e : edits) joined += e.text;
+    Piece all{};
+    if (!joined.empty()) all = append(joined.data(), joined.size());
+
+    std::vector<Splice> splices;
+    splices.reserve(edits.size());
+    uint64_t at = 0;
+    for (const auto& e : edits) {
+        Piece p{};
+        if (!e.text.empty()) p = pieceSlice(all, at, at + e.text.size());
+        splices.push_back({ e.offset, e.length, p });
+        at += e.text.size();
+    }
+    splice(splices);
+}
+
+void TextBuffer::splice(const std::vector<Splice>& splices) {
+    std::vector<Piece> in;
+    collect(root_, in);
+
+    std::vector<Piece> out;
+    out.reserve(in.size() + 2 * splices.size() + 1);
+
+    // Copia a `out` los tramos de pieza que cubren [from, to)
+    size_t   pi     = 0;
+    uint64_t pstart = 0;
+    auto keep = [&](uint64_t from, uint64_t to) {
+        while (from < to) {
+            while (pstart + in[pi].length <= from) pstart += in[pi++].length;
+            uint64_t a = from - pstart;
+            uint64_t b = std::min(to, pstart + in[pi].length) - pstart;
+            out.push_back(pieceSlice(in[pi], a, b));
+            from = pstart + b;
+        }
+    };
+
+    uint64_t cur = 0;
+    for (const auto& s : splices) {
+        keep(cur, s.offset);
+        if (s.piece.length) out.push_back(s.piece);
+        cur = s.offset + s.length;
+    }
+    keep(cur, size());
+
+    destroy(root_);
+    root_ = build(out);
+}
+
+// ── Carga perezosa ────────────────────────────────────────────────
+void TextBuffer::indexMore(uint64_t bytes) {
+    Block& orig = *blocks_[0];
+    if (fullyLoaded()) return;
+
+    uint64_t from = scanned_;
+    uint64_t to   = std::min<uint64_t>(orig.size, from + bytes);
+    // Los tramos grandes (loadAll) se reparten entre todos los núcleos
+    LineIndexer::scanParallel(orig.data + from, (size_t)(to - from), from, orig.lfs);
+    scanned_ = to;
+    commitScanned();
+}
+
+void TextBuffer::commitScanned() {
+    Block& orig = *blocks_[0];
+
+    // Sólo se agregan líneas completas; al final del archivo, todo
+    uint64_t end = (scanned_ == orig.size) ? scanned_
+                 : (!orig.lfs.empty() && orig.lfs.back() >= loadedEnd_)
+                 ? orig.lfs.back() + 1 : loadedEnd_;
+    if (end == loadedEnd_) return;
+
+    auto first = std::lower_bound(orig.lfs.begin(), orig.lfs.end(), loadedEnd_);
+    Piece p;
+    p.buf     = 0;
+    p.start   = loadedEnd_;
+    p.length  = end - loadedEnd_;
+    p.lfFirst = (uint64_t)(first - orig.lfs.begin());
+    p.lfCount = orig.lfs.size() - p.lfFirst;
+    root_ = appendPiece(root_, p);
+    loadedEnd_ = end;
+}
+
+void TextBuffer::ensureLines(int rows) {
+    if (worker_) {
+        pollBackgroundLoad();
+        return;
+    }
+    // La última línea del documento queda incompleta mientras falte carga
+    while (!fullyLoaded() && lineCount() - 1 < rows)
+        indexMore(kIndexChunk);
+}
+
+void TextBuffer::ensureLoaded(uint64_t offset) {
+    if (worker_) {
+        loadAll();
+        return;
+    }
+    // Se indexa de una vez (en paralelo) lo que falta hasta `offset`;
+    // después, de a kIndexChunk hasta cerrar la línea
+    if (offset > scanned_) indexMore(offset - scanned_);
+    while (!fullyLoaded() && loadedEnd_ < offset)
+        indexMore(kIndexChunk);
+}
+
+void TextBuffer::loadAll() {
+    if (worker_) {
+        worker_->wait();
+        pollBackgroundLoad();
+    }
+    while (!fullyLoaded())
+        indexMore(blocks_[0]->size - scanned_);
+}
+
+// ── Carga en segundo plano ────────────────────────────────────────
+void TextBuffer::startBackgroundLoad() {
+    if (worker_ || fullyLoaded()) return;
+    // La primera pantalla se indexa aquí mismo, sin esperar al hilo
+    indexMore(kIndexChunk);
+    if (!fullyLoaded())
+        worker_.reset(new LoadWorker(blocks_[0]->file, scanned_));
+}
+
+bool TextBuffer::pollBackgroundLoad() {
+    if (!worker_) return false;
+
+    Block& orig = *blocks_[0];
+    bool finished = worker_->done();
+    uint64_t before = loadedEnd_;
+    uint64_t upTo = worker_->take(orig.lfs);
+    if (upTo > scanned_) {
+        scanned_ = upTo;
+        commitScanned();
+    }
+    if (finished && fullyLoaded()) worker_.reset();
+    return loadedEnd_ != before;
+}
+
+void TextBuffer::cancelBackgroundLoad() {
+    if (!worker_) return;
+    worker_->cancel();
+    worker_->wait();
+    pollBackgroundLoad();
+    worker_.reset();
+}
+
+double TextBuffer::loadProgress() const {
+    uint64_t total = blocks_[0]->size;
+    if (total == 0) return 1.0;
+    uint64_t done = worker_ ? worker_->scanned() : scanned_;
+    return (double)done / (double)total;
+}
+
+std::string_view TextBuffer::pendingTail() const {
+    const Block& orig = *blocks_[0];
+    return std::string_view(orig.data + loadedEnd_, (size_t)(orig.size - loadedEnd_));
+}
+
+// ── Edición ───────────────────────────────────────────────────────
+void TextBuffer::insert(uint64_t offset, const char* data, size_t len) {
+    if (len == 0) return;
+    offset = std::min(offset, size());
+
+    Node *l, *r;
+    split(root_, offset, l, r);
+
+    // Escribir al final del bloque de añadidos actual
+    Piece p = append(data, len);
+    root_ = merge(appendPiece(l, p), r);
+}
+
+void TextBuffer::erase(uint64_t offset, uint64_t len) {
+    if (len == 0 || offset >= size()) return;
+
+    Node *l, *m, *r;
+    split(root_, offset, l, m);
+    split(m, len, m, r);
+    destroy(m);
+    root_ = merge(l, r);
+}
@@ -0,0 +1,65 @@
+#include "textsnapshot.h"
+#include "mappedfile.h"
+#include <algorithm>
+
+bool TextSnapshot::forEachSpanWhile(uint64_t offset, uint64_t len,
+                                    const std::function<bool(const char*, size_t)>& fn) const {
+    uint64_t to = std::min(offset + len, size_);
+    if (offset >= to) return true;
+
+    // Primer tramo que termina después de offset
+    auto it = std::upper_bound(spans_.begin(), spans_.end(), offset,
+        [](uint64_t off, const Span& s) { return off < s.start + s.length; });
+    for (; it != spans_.end() && it->start < to; ++it) {
+        uint64_t a = std::max(offset, it->start);
+        uint64_t b = std::min(to, it->start + it->length);
+        if (!fn(it->data + (a - it->start), (size_t)(b - a))) return false;
+    }
+    return true;
+}
+
+std::string TextSnapshot::substr(uint64_t offset, uint64_t len) const {
+    std::string out;
+    forEachSpanWhile(offset, len, [&](const char* p, size_t n) {
+        out.append(p, n);
+        return true;
+    });
+    return out;
+}
+
+const char* TextSnapshot::contiguous(uint64_t offset, uint64_t len) const {
+    if (offset + len > size_) return nullptr;
+    auto it = std::upper_bound(spans_.begin(), spans_.end(), offset,
+        [](uint64_t off, const Span& s) { return off < s.start + s.length; });
+    if (it == spans_.end()) return len == 0 ? "" : nullptr;
+    if (offset + len > it->start + it->length) return nullptr;
+    return it->data + (offset - it->start);
+}
+
+bool TextSnapshot::sameSpans(const TextSnapshot& other) const {
+    if (size_ != other.size_ || spans_.size() != other.spans_.size()) return false;
+    for (size_t i = 0; i < spans_.size(); ++i)
+        if (spans_[i].data != other.spans_[i].data || spans_[i].length != other.spans_[i].length)
+            return false;
+    return true;
+}
+
+bool TextSnapshot::patchRanges(std::vector<std::pair<uint64_t, uint64_t>>& out) const {
+    out.clear();
+    if (!original_ || size_ < original_->size()) return false;
+
+    const char* base = original_->data();
+    const char* end  = base + original_->size();
+    for (const Span& s : spans_) {
+        if (s.data >= base && s.data < end) {
+            // Del original: sólo vale si sigue en su lugar
+            if ((uint64_t)(s.data - base) != s.start) return false;
+            continue;
+        }
+        if (!out.empty() && out.back().second == s.start)
+            out.back().second += s.length;
+        else
+            out.push_back({ s.start, s.start + s.length });
+    }
+    return true;
+}
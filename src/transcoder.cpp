@@ -0,0 +1,782 @@
+#include "transcoder.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TRANSCODER_X86 1
+#endif
+#if defined(TRANSCODER_X86) && defined(__SSE2__)
+#define TRANSCODER_SSE2 1
+#endif
+
+// Bytes del comienzo en los que se buscan los nulos de UTF-16
+static const size_t kUtf16Sample = 4096;
+// Si no valida como UTF-8: bytes en los que se cuentan secuencias
+// válidas e inválidas para decidir entre UTF-8 y Latin-1
+static const size_t kStatsSample = 1u << 20;
+
+typedef bool   (*ValidFn)(const char*, size_t);
+typedef size_t (*Latin1Fn)(const uint8_t*, size_t, char*);
+typedef size_t (*Utf16Fn)(const uint8_t*, size_t, bool, char*);
+typedef size_t (*FromFn)(Charset, const uint8_t*, size_t, char*, size_t&, bool);
+
+// Las cuatro etapas de una misma implementación
+struct Kernels {
+    ValidFn  valid;
+    Latin1Fn latin1;   // Latin-1 -> UTF-8
+    Utf16Fn  utf16;    // UTF-16 -> UTF-8
+    FromFn   from;     // UTF-8 -> Latin-1 / UTF-16
+};
+
+// Windows-1252 en 0x80..0x9F; los cinco huecos quedan como el control
+// C1 del mismo valor, así todo byte ida y vuelta es el mismo byte
+static const uint16_t kCp1252[32] = {
+    0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+    0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178,
+};
+
+// ── Helpers internos ──────────────────────────────────────────────
+static inline size_t putUtf8(uint32_t cp, char* o) {
+    if (cp < 0x80) {
+        o[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        o[0] = (char)(0xC0 | (cp >> 6));
+        o[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        o[0] = (char)(0xE0 | (cp >> 12));
+        o[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        o[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    o[0] = (char)(0xF0 | (cp >> 18));
+    o[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    o[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    o[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Un carácter de UTF-8 desde p (n > 0): devuelve sus bytes, 1 con
+// U+FFFD si es inválido, o 0 si es válido pero el tramo lo corta
+static inline int decodeUtf8(const uint8_t* p, size_t n, uint32_t& cp) {
+    uint8_t c = p[0];
+    if (c < 0x80) {
+        cp = c;
+        return 1;
+    }
+    int     need;
+    uint8_t lo = 0x80, hi = 0xBF;   // rango del segundo byte
+    if (c >= 0xC2 && c <= 0xDF) {
+        need = 2;
+        cp   = c & 0x1F;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        need = 3;
+        cp   = c & 0x0F;
+        if (c == 0xE0) lo = 0xA0;        // sobrelargo
+        else if (c == 0xED) hi = 0x9F;   // sustitutos
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        need = 4;
+        cp   = c & 0x07;
+        if (c == 0xF0) lo = 0x90;        // sobrelargo
+        else if (c == 0xF4) hi = 0x8F;   // > U+10FFFF
+    } else {
+        cp = 0xFFFD;
+        return 1;
+    }
+    for (int k = 1; k < need; ++k) {
+        if ((size_t)k >= n) return 0;
+        uint8_t b = p[k];
+        if (b < lo || b > hi) {
+            cp = 0xFFFD;
+            return 1;
+        }
+        cp = (cp << 6) | (b & 0x3F);
+        lo = 0x80;
+        hi = 0xBF;
+    }
+    return need;
+}
+
+static inline char latin1Byte(uint32_t cp) {
+    if (cp < 0x80 || (cp >= 0xA0 && cp <= 0xFF)) return (char)cp;
+    for (int b = 0; b < 32; ++b)
+        if (kCp1252[b] == cp) return (char)(0x80 + b);
+    return '?';
+}
+
+static inline void putUnit(uint32_t u, bool big, char* o) {
+    o[big ? 1 : 0] = (char)(u & 0xFF);
+    o[big ? 0 : 1] = (char)(u >> 8);
+}
+
+static inline size_t putCharset(Charset cs, uint32_t cp, char* o) {
+    if (cs == Charset::Latin1) {
+        o[0] = latin1Byte(cp);
+        return 1;
+    }
+    bool big = cs == Charset::UTF16BE;
+    if (cp < 0x10000) {
+        putUnit(cp, big, o);
+        return 2;
+    }
+    cp -= 0x10000;
+    putUnit(0xD800 + (cp >> 10), big, o);
+    putUnit(0xDC00 + (cp & 0x3FF), big, o + 2);
+    return 4;
+}
+
+static inline uint32_t unitAt(const uint8_t* p, size_t k, bool big) {
+    return big ? (uint32_t)(p[2 * k] << 8 | p[2 * k + 1])
+               : (uint32_t)(p[2 * k] | p[2 * k + 1] << 8);
+}
+
+// Un carácter de UTF-16 desde la unidad i (la avanza); un sustituto
+// sin pareja es U+FFFD
+static inline size_t utf16Char(const uint8_t* p, size_t units, size_t& i, bool big, char* o) {
+    uint32_t u = unitAt(p, i++, big);
+    if (u >= 0xD800 && u <= 0xDBFF && i < units) {
+        uint32_t low = unitAt(p, i, big);
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            u = 0x10000 + ((u - 0xD800) << 10) + (low - 0xDC00);
+            ++i;
+        } else {
+            u = 0xFFFD;
+        }
+    } else if (u >= 0xD800 && u <= 0xDFFF) {
+        u = 0xFFFD;
+    }
+    return putUtf8(u, o);
+}
+
+// Un carácter de UTF-8 desde i hacia `cs`; false si el tramo lo corta
+// (y no es el último)
+static inline bool fromUtf8Char(Charset cs, const uint8_t* p, size_t n, size_t& i, char*& o,
+                                bool last) {
+    uint32_t cp;
+    int k = decodeUtf8(p + i, n - i, cp);
+    if (k == 0) {
+        if (!last) return false;
+        cp = 0xFFFD;
+        k  = 1;
+    }
+    i += (size_t)k;
+    o += putCharset(cs, cp, o);
+    return true;
+}
+
+// ── Respaldo escalar (con bloques ASCII de SSE2 en x86-64) ────────
+static bool validScalar(const char* data, size_t len) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    size_t i = 0;
+    while (i < len) {
+        // Ocho bytes ASCII de una vez
+        if (i + 8 <= len) {
+            uint64_t w;
+            memcpy(&w, p + i, 8);
+            if ((w & 0x8080808080808080ull) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+        if (p[i] < 0x80) {
+            ++i;
+            continue;
+        }
+        uint32_t cp;
+        int k = decodeUtf8(p + i, len - i, cp);
+        if (k <= 1) return false;   // fuera de ASCII, 1 es un error
+        i += (size_t)k;
+    }
+    return true;
+}
+
+static size_t latin1Scalar(const uint8_t* p, size_t n, char* out) {
+    char*  o = out;
+    size_t i = 0;
+    while (i < n) {
+#ifdef TRANSCODER_SSE2
+        if (i + 16 <= n) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            if (_mm_movemask_epi8(v) == 0) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o), v);
+                o += 16;
+                i += 16;
+                continue;
+            }
+        }
+#endif
+        uint8_t c = p[i++];
+        if (c < 0x80) *o++ = (char)c;
+        else o += putUtf8(c < 0xA0 ? kCp1252[c - 0x80] : c, o);
+    }
+    return (size_t)(o - out);
+}
+
+static size_t utf16Scalar(const uint8_t* p, size_t n, bool big, char* out) {
+    char*  o     = out;
+    size_t units = n / 2;
+    size_t i     = 0;
+    while (i < units) {
+#ifdef TRANSCODER_SSE2
+        // 16 unidades ASCII se estrechan a 16 bytes
+        if (i + 16 <= units) {
+            __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2 * i));
+            __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2 * i + 16));
+            if (big) {
+                v0 = _mm_or_si128(_mm_slli_epi16(v0, 8), _mm_srli_epi16(v0, 8));
+                v1 = _mm_or_si128(_mm_slli_epi16(v1, 8), _mm_srli_epi16(v1, 8));
+            }
+            __m128i high = _mm_and_si128(_mm_or_si128(v0, v1), _mm_set1_epi16((short)0xFF80));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(high, _mm_setzero_si128())) == 0xFFFF) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm_packus_epi16(v0, v1));
+                o += 16;
+                i += 16;
+                continue;
+            }
+        }
+#endif
+        o += utf16Char(p, units, i, big, o);
+    }
+    if (n & 1) o += putUtf8(0xFFFD, o);   // byte suelto al final
+    return (size_t)(o - out);
+}
+
+static size_t fromUtf8Scalar(Charset cs, const uint8_t* p, size_t n, char* out,
+                             size_t& written, bool last) {
+    char*  o   = out;
+    bool   big = cs == Charset::UTF16BE;
+    size_t i   = 0;
+    while (i < n) {
+#ifdef TRANSCODER_SSE2
+        // 16 bytes ASCII: tal cual en Latin-1, ensanchados en UTF-16
+        if (i + 16 <= n) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+            if (_mm_movemask_epi8(v) == 0) {
+                if (cs == Charset::Latin1) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), v);
+                    o += 16;
+                } else {
+                    __m128i z = _mm_setzero_si128();
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o),
+                                     big ? _mm_unpacklo_epi8(z, v) : _mm_unpacklo_epi8(v, z));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 16),
+                                     big ? _mm_unpackhi_epi8(z, v) : _mm_unpackhi_epi8(v, z));
+                    o += 32;
+                }
+                i += 16;
+                continue;
+            }
+        }
+#endif
+        if (!fromUtf8Char(cs, p, n, i, o, last)) break;   // sigue en el próximo tramo
+    }
+    written = (size_t)(o - out);
+    return i;
+}
+
+#ifdef TRANSCODER_X86
+#ifdef TRANSCODER_SSE2
+// ── SSE2: salta bloques ASCII de 16 bytes ─────────────────────────
+static bool validSse2(const char* data, size_t len) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    size_t i = 0;
+    while (i + 16 <= len) {
+        int m = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+        if (m == 0) {
+            i += 16;
+            continue;
+        }
+        i += (size_t)__builtin_ctz(m);
+        uint32_t cp;
+        int k = decodeUtf8(p + i, len - i, cp);
+        if (k <= 1) return false;
+        i += (size_t)k;
+    }
+    return validScalar(data + i, len - i);
+}
+#endif
+
+// ── AVX2: validación por nibbles, 64 bytes por paso ───────────────
+// Cada par (byte anterior, byte actual) se clasifica con tres tablas de
+// 16 entradas indexadas por nibbles (alto y bajo del anterior, alto del
+// actual); un bit que sobrevive al AND es un error. Los bytes que deben
+// ser el 3.º o 4.º de una secuencia se verifican aparte.
+enum : uint8_t {
+    TooShort   = 1 << 0,   // 11______ seguido de 0_______ / 11______
+    TooLong    = 1 << 1,   // 0_______ seguido de 10______
+    Overlong3  = 1 << 2,   // 11100000 100_____
+    TooLarge   = 1 << 3,   // 11110100 1001____ / 11110101+ ...
+    Surrogate  = 1 << 4,   // 11101101 101_____
+    Overlong2  = 1 << 5,   // 1100000_ 10______
+    TooLarge1k = 1 << 6,   // 11110101+ 1000____
+    Overlong4  = 1 << 6,   // 11110000 1000____
+    TwoConts   = 1 << 7,   // 10______ 10______
+    Carry      = TooShort | TooLong | TwoConts
+};
+
+alignas(16) static const uint8_t kByte1High[16] = {
+    TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong, TooLong,
+    TwoConts, TwoConts, TwoConts, TwoConts,
+    TooShort | Overlong2,
+    TooShort,
+    TooShort | Overlong3 | Surrogate,
+    TooShort | TooLarge | TooLarge1k | Overlong4,
+};
+
+alignas(16) static const uint8_t kByte1Low[16] = {
+    Carry | Overlong3 | Overlong2 | Overlong4,
+    Carry | Overlong2,
+    Carry,
+    Carry,
+    Carry | TooLarge,
+    Carry | TooLarge | TooLarge1k,
+    Carry | TooLarge | TooLarge1k,
+    Carry | TooLarge | TooLarge1k,
+    Carry | TooLarge | TooLarge1k,
+    Carry | TooLarge | TooLarge1k,
+    Carry | TooLarge | TooLarge1k,
+    Carry | TooLarge | TooLarge1k,
+    Carry | TooLarge | TooLarge1k,
+    Carry | TooLarge | TooLarge1k | Surrogate,
+    Carry | TooLarge | TooLarge1k,
+    Carry | TooLarge | TooLarge1k,
+};
+
+alignas(16) static const uint8_t kByte2High[16] = {
+    TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort, TooShort,
+    TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge1k | Overlong4,
+    TooLong | Overlong2 | TwoConts | Overlong3 | TooLarge,
+    TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+    TooLong | Overlong2 | TwoConts | Surrogate | TooLarge,
+    TooShort, TooShort, TooShort, TooShort,
+};
+
+// Los N bytes que preceden a cada posición de `in` (con el bloque anterior)
+template <int N>
+__attribute__((target("avx2")))
+static inline __m256i prevBytes(__m256i in, __m256i prev) {
+    return _mm256_alignr_epi8(in, _mm256_permute2x128_si256(prev, in, 0x21), 16 - N);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i nibbleLookup(const uint8_t* table, __m256i idx) {
+    __m256i t = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+    return _mm256_shuffle_epi8(t, idx);
+}
+
+// Bits de error del bloque `in` (precedido por `prev`)
+__attribute__((target("avx2")))
+static inline __m256i checkBlock(__m256i in, __m256i prev) {
+    const __m256i nib = _mm256_set1_epi8(0x0F);
+    __m256i prev1 = prevBytes<1>(in, prev);
+    __m256i sc = _mm256_and_si256(
+        _mm256_and_si256(nibbleLookup(kByte1High, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nib)),
+                         nibbleLookup(kByte1Low, _mm256_and_si256(prev1, nib))),
+        nibbleLookup(kByte2High, _mm256_and_si256(_mm256_srli_epi16(in, 4), nib)));
+    // Tras 111_____ a dos bytes o 1111____ a tres va una continuación
+    __m256i third  = _mm256_subs_epu8(prevBytes<2>(in, prev), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(prevBytes<3>(in, prev), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must   = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+    return _mm256_xor_si256(must, sc);
+}
+
+__attribute__((target("avx2")))
+static bool validAvx2(const char* data, size_t len) {
+    // Un bloque que termina con una secuencia sin completar
+    const __m256i maxLast = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+    __m256i err        = _mm256_setzero_si256();
+    __m256i prev       = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        __m256i in0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i in1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32));
+        if (_mm256_movemask_epi8(_mm256_or_si256(in0, in1)) == 0) {
+            err = _mm256_or_si256(err, incomplete);
+        } else {
+            err = _mm256_or_si256(err, _mm256_or_si256(checkBlock(in0, prev), checkBlock(in1, in0)));
+            incomplete = _mm256_subs_epu8(in1, maxLast);
+        }
+        prev = in1;
+    }
+    // Resto relleno con ceros (ASCII)
+    for (; i < len; i += 32) {
+        alignas(32) char tail[32] = {};
+        memcpy(tail, data + i, std::min<size_t>(32, len - i));
+        __m256i in = _mm256_load_si256(reinterpret_cast<const __m256i*>(tail));
+        err        = _mm256_or_si256(err, checkBlock(in, prev));
+        incomplete = _mm256_subs_epu8(in, maxLast);
+        prev       = in;
+    }
+    err = _mm256_or_si256(err, incomplete);
+    return _mm256_testz_si256(err, err);
+}
+
+// ── AVX2: caracteres de uno y dos bytes, de a dieciséis ───────────
+// Dieciséis caracteres de hasta U+07FF van en palabras de 16 bits; una
+// tabla de 256 barajados (pshufb) por máscara de cada mitad los junta o
+// los separa sin saltos. Lo demás (CJK, Windows-1252 de 3 bytes,
+// sustitutos) cae al camino escalar por ese tramo.
+alignas(16) static uint8_t kExpand[256][16];   // palabra -> 1 o 2 bytes (bit = 2 bytes)
+alignas(16) static uint8_t kKeep8[256][16];    // bytes que quedan (bit = queda)
+alignas(16) static uint8_t kKeep16[256][16];   // palabras que quedan
+static uint8_t             kExpandLen[256];
+
+static void buildShuffles() {
+    for (int m = 0; m < 256; ++m) {
+        int e = 0, k8 = 0, k16 = 0;
+        for (int lane = 0; lane < 8; ++lane) {
+            kExpand[m][e++] = (uint8_t)(2 * lane);
+            if (m & (1 << lane)) kExpand[m][e++] = (uint8_t)(2 * lane + 1);
+            if (m & (1 << lane)) {
+                kKeep8[m][k8++]   = (uint8_t)lane;
+                kKeep16[m][k16++] = (uint8_t)(2 * lane);
+                kKeep16[m][k16++] = (uint8_t)(2 * lane + 1);
+            }
+        }
+        kExpandLen[m] = (uint8_t)e;
+        while (e < 16) kExpand[m][e++] = 0x80;
+        while (k8 < 16) kKeep8[m][k8++] = 0x80;
+        while (k16 < 16) kKeep16[m][k16++] = 0x80;
+    }
+}
+
+// Un barajado distinto por mitad (pshufb no cruza mitades)
+__attribute__((target("avx2")))
+static inline __m256i shuffleHalves(__m256i v, const uint8_t (*table)[16], unsigned lo, unsigned hi) {
+    __m256i s = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table[lo]))),
+        _mm_load_si128(reinterpret_cast<const __m128i*>(table[hi])), 1);
+    return _mm256_shuffle_epi8(v, s);
+}
+
+// Escribe las dos mitades de `v`, la primera de `first` bytes
+__attribute__((target("avx2")))
+static inline void storeHalves(__m256i v, char* o, size_t first) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm256_castsi256_si128(v));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(o + first), _mm256_extracti128_si256(v, 1));
+}
+
+// Dieciséis palabras (< U+0800) a UTF-8 en `o`; devuelve los bytes
+// escritos (escribe hasta 16 más allá)
+__attribute__((target("avx2")))
+static inline size_t expandAvx2(__m256i w, char* o) {
+    __m256i ascii = _mm256_cmpgt_epi16(_mm256_set1_epi16(0x80), w);
+    __m256i lead  = _mm256_or_si256(_mm256_srli_epi16(w, 6), _mm256_set1_epi16(0xC0));
+    __m256i cont  = _mm256_or_si256(_mm256_and_si256(w, _mm256_set1_epi16(0x3F)), _mm256_set1_epi16(0x80));
+    __m256i pair  = _mm256_blendv_epi8(_mm256_or_si256(lead, _mm256_slli_epi16(cont, 8)), w, ascii);
+    unsigned m    = ~(unsigned)_mm256_movemask_epi8(_mm256_packs_epi16(ascii, ascii));
+    unsigned lo   = m & 0xFF, hi = (m >> 16) & 0xFF;
+    storeHalves(shuffleHalves(pair, kExpand, lo, hi), o, kExpandLen[lo]);
+    return (size_t)kExpandLen[lo] + kExpandLen[hi];
+}
+
+__attribute__((target("avx2")))
+static size_t latin1Avx2(const uint8_t* p, size_t n, char* out) {
+    char*  o = out;
+    size_t i = 0;
+    while (i + 32 <= n) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        unsigned high = (unsigned)_mm256_movemask_epi8(v);
+        if (high == 0) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), v);
+            o += 32;
+            i += 32;
+            continue;
+        }
+        // 0x80..0x9F son de Windows-1252 (casi todos de tres bytes): se
+        // ensancha el bloque igual, se conserva lo anterior al primero y
+        // ése va por el camino escalar
+        __m256i c1 = _mm256_sub_epi8(v, _mm256_set1_epi8((char)0x80));
+        unsigned special = (unsigned)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_min_epu8(c1, _mm256_set1_epi8(0x1F)), c1));
+        size_t len = expandAvx2(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(v)), o);
+        len += expandAvx2(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1)), o + len);
+        if (special == 0) {
+            o += len;
+            i += 32;
+            continue;
+        }
+        unsigned pos = (unsigned)__builtin_ctz(special);
+        o += pos + (size_t)__builtin_popcount(high & ((1u << pos) - 1));
+        o += putUtf8(kCp1252[p[i + pos] - 0x80], o);
+        i += pos + 1;
+    }
+    return (size_t)(o - out) + latin1Scalar(p + i, n - i, o);
+}
+
+__attribute__((target("avx2")))
+static size_t utf16Avx2(const uint8_t* p, size_t n, bool big, char* out) {
+    const __m256i swap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    char*  o     = out;
+    size_t units = n / 2;
+    size_t i     = 0;
+    while (i + 16 <= units) {
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 2 * i));
+        if (big) w = _mm256_shuffle_epi8(w, swap);
+        if (_mm256_testz_si256(w, _mm256_set1_epi16((short)0xF800))) {
+            o += expandAvx2(w, o);
+            i += 16;
+            continue;
+        }
+        // Tres bytes o sustitutos: estas unidades una por una
+        for (size_t stop = i + 16; i < stop;) o += utf16Char(p, units, i, big, o);
+    }
+    while (i < units) o += utf16Char(p, units, i, big, o);
+    if (n & 1) o += putUtf8(0xFFFD, o);   // byte suelto al final
+    return (size_t)(o - out);
+}
+
+// Hasta dieciséis bytes desde un inicio de carácter (con el siguiente
+// a mano): los caracteres ASCII y de dos bytes del comienzo, en `cs`.
+// Devuelve los bytes consumidos (17 si el último empieza una secuencia;
+// menos de 16 si aparece otra cosa, 0 si es el primero).
+__attribute__((target("avx2")))
+static inline size_t narrowAvx2(Charset cs, const uint8_t* p, char*& o) {
+    const __m256i x80 = _mm256_set1_epi16(0x80);
+    const __m256i xC0 = _mm256_set1_epi16(0xC0);
+    __m256i b     = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    __m256i next  = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)));
+    __m256i ascii = _mm256_cmpgt_epi16(x80, b);
+    __m256i cont  = _mm256_cmpeq_epi16(_mm256_and_si256(b, xC0), x80);
+    __m256i lead  = _mm256_and_si256(_mm256_cmpeq_epi16(_mm256_and_si256(b, _mm256_set1_epi16(0xE0)), xC0),
+                                     _mm256_cmpgt_epi16(b, _mm256_set1_epi16(0xC1)));
+    // Todo byte es ASCII, inicio o continuación, y tras cada inicio (y
+    // sólo ahí) viene una continuación; el primero no puede serlo
+    __m256i ok = _mm256_and_si256(_mm256_or_si256(_mm256_or_si256(ascii, cont), lead),
+                                  _mm256_cmpeq_epi16(lead, _mm256_cmpeq_epi16(_mm256_and_si256(next, xC0), x80)));
+    if ((p[0] & 0xC0) == 0x80) return 0;
+
+    __m256i cp = _mm256_blendv_epi8(
+        b, _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(b, _mm256_set1_epi16(0x1F)), 6),
+                           _mm256_and_si256(next, _mm256_set1_epi16(0x3F))), lead);
+    if (cs == Charset::Latin1) {
+        // Más allá de U+00FF o en U+0080..U+009F: pasa por la tabla
+        __m256i wide = _mm256_or_si256(
+            _mm256_cmpgt_epi16(cp, _mm256_set1_epi16(0xFF)),
+            _mm256_and_si256(_mm256_cmpgt_epi16(cp, _mm256_set1_epi16(0x7F)),
+                             _mm256_cmpgt_epi16(_mm256_set1_epi16(0xA0), cp)));
+        ok = _mm256_andnot_si256(wide, ok);
+    }
+    // Se convierte hasta el primer byte que no se pudo (sin partir un
+    // carácter); ése y los siguientes quedan para quien llama
+    unsigned bad  = ~(unsigned)_mm256_movemask_epi8(ok);
+    unsigned used = 16 + (((unsigned)_mm256_movemask_epi8(lead) >> 31) & 1);
+    if (bad != 0) {
+        used = (unsigned)__builtin_ctz(bad) / 2;
+        if (used > 0 && ((unsigned)_mm256_movemask_epi8(lead) >> (2 * used - 1) & 1)) --used;
+        if (used == 0) return 0;
+    }
+    unsigned keep = ~(unsigned)_mm256_movemask_epi8(_mm256_packs_epi16(cont, cont));
+    unsigned lo   = keep & 0xFF, hi = (keep >> 16) & 0xFF;
+    unsigned kept = (unsigned)__builtin_popcount((lo | hi << 8) & ((1u << std::min(used, 16u)) - 1));
+    if (cs == Charset::Latin1) {
+        storeHalves(shuffleHalves(_mm256_packus_epi16(cp, cp), kKeep8, lo, hi), o,
+                    (size_t)__builtin_popcount(lo));
+        o += kept;
+    } else {
+        if (cs == Charset::UTF16BE)
+            cp = _mm256_or_si256(_mm256_slli_epi16(cp, 8), _mm256_srli_epi16(cp, 8));
+        storeHalves(shuffleHalves(cp, kKeep16, lo, hi), o, 2 * (size_t)__builtin_popcount(lo));
+        o += 2 * kept;
+    }
+    return used;
+}
+
+__attribute__((target("avx2")))
+static size_t fromUtf8Avx2(Charset cs, const uint8_t* p, size_t n, char* out,
+                           size_t& written, bool last) {
+    char*  o   = out;
+    bool   big = cs == Charset::UTF16BE;
+    size_t i   = 0;
+    while (i + 32 <= n) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        if (_mm_movemask_epi8(v) == 0) {
+            if (cs == Charset::Latin1) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o), v);
+                o += 16;
+            } else {
+                __m256i w = _mm256_cvtepu8_epi16(v);
+                if (big) w = _mm256_slli_epi16(w, 8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(o), w);
+                o += 32;
+            }
+            i += 16;
+            continue;
+        }
+        size_t used = narrowAvx2(cs, p + i, o);
+        if (used > 0) {
+            i += used;
+            continue;
+        }
+        // Otra cosa (tres o cuatro bytes, fuera de Latin-1, inválido):
+        // ese carácter solo
+        fromUtf8Char(cs, p, n, i, o, last);
+    }
+    size_t tail;
+    i += fromUtf8Scalar(cs, p + i, n - i, o, tail, last);
+    written = (size_t)(o - out) + tail;
+    return i;
+}
+#endif
+
+// ── Selección de implementación ───────────────────────────────────
+static Kernels pickKernels(const char** name) {
+#ifdef TRANSCODER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        buildShuffles();
+        *name = "avx2";
+        return { validAvx2, latin1Avx2, utf16Avx2, fromUtf8Avx2 };
+    }
+#ifdef TRANSCODER_SSE2
+    *name = "sse2";
+    return { validSse2, latin1Scalar, utf16Scalar, fromUtf8Scalar };
+#endif
+#endif
+    *name = "scalar";
+    return { validScalar, latin1Scalar, utf16Scalar, fromUtf8Scalar };
+}
+
+static const char* gBackend = nullptr;
+static Kernels     gKernels = pickKernels(&gBackend);
+
+const char* Transcoder::backend() {
+    return gBackend;
+}
+
+// ── API ───────────────────────────────────────────────────────────
+bool Transcoder::validUtf8(const char* p, size_t n) {
+    return gKernels.valid(p, n);
+}
+
+TextEncoding Transcoder::detect(const char* p, size_t n, size_t sniff) {
+    const uint8_t* u = reinterpret_cast<const uint8_t*>(p);
+    TextEncoding enc;
+    if (n >= 3 && u[0] == 0xEF && u[1] == 0xBB && u[2] == 0xBF) {
+        enc.bom = true;
+        return enc;
+    }
+    if (n >= 2 && ((u[0] == 0xFF && u[1] == 0xFE) || (u[0] == 0xFE && u[1] == 0xFF))) {
+        enc.charset = u[0] == 0xFF ? Charset::UTF16LE : Charset::UTF16BE;
+        enc.bom     = true;
+        return enc;
+    }
+
+    // UTF-16 sin BOM: el texto latino deja un nulo en cada par, del
+    // mismo lado (los nulos son UTF-8 válido, así que va antes)
+    size_t m = std::min(n, kUtf16Sample) & ~(size_t)1;
+    size_t zeroEven = 0, zeroOdd = 0;
+    for (size_t i = 0; i < m; i += 2) {
+        zeroEven += u[i] == 0;
+        zeroOdd  += u[i + 1] == 0;
+    }
+    size_t pairs = m / 2;
+    if (pairs >= 2 && zeroOdd * 2 > pairs && zeroEven * 16 < zeroOdd) {
+        enc.charset = Charset::UTF16LE;
+        return enc;
+    }
+    if (pairs >= 2 && zeroEven * 2 > pairs && zeroOdd * 16 < zeroEven) {
+        enc.charset = Charset::UTF16BE;
+        return enc;
+    }
+
+    // Sólo el comienzo, sin cortar el último carácter
+    size_t len = n;
+    if (sniff > 0 && sniff < n) {
+        len = sniff;
+        while (len > 0 && sniff - len < 4 && (u[len] & 0xC0) == 0x80) --len;
+    }
+    if (validUtf8(p, len)) return enc;
+
+    // Un UTF-8 con algún byte suelto sigue siendo UTF-8 (se pinta U+FFFD
+    // y se guarda tal cual); en Latin-1 casi nada forma secuencias válidas
+    size_t multi = 0, bad = 0;
+    len = std::min(len, kStatsSample);
+    for (size_t i = 0; i < len;) {
+        if (u[i] < 0x80) {
+            ++i;
+            continue;
+        }
+        uint32_t cp;
+        int k = decodeUtf8(u + i, len - i, cp);
+        if (k > 1) {
+            ++multi;
+            i += (size_t)k;
+        } else {
+            ++bad;
+            ++i;
+        }
+    }
+    if (multi > 2 * bad) return enc;
+    enc.charset = Charset::Latin1;
+    return enc;
+}
+
+size_t Transcoder::utf8Bound(const TextEncoding& enc, size_t n) {
+    switch (enc.charset) {
+    case Charset::UTF8:    return n;
+    case Charset::Latin1:  return 3 * n;             // € y compañía: 3 bytes
+    case Charset::UTF16LE:
+    case Charset::UTF16BE: return n / 2 * 3 + 3;     // + U+FFFD de un byte suelto
+    }
+    return n;
+}
+
+size_t Transcoder::toUtf8(const TextEncoding& enc, const char* p, size_t n, char* out) {
+    const uint8_t* u = reinterpret_cast<const uint8_t*>(p);
+    size_t skip = std::min(bom(enc).size(), n);
+    switch (enc.charset) {
+    case Charset::UTF8:
+        memcpy(out, p + skip, n - skip);
+        return n - skip;
+    case Charset::Latin1:
+        return gKernels.latin1(u, n, out);
+    case Charset::UTF16LE:
+    case Charset::UTF16BE:
+        return gKernels.utf16(u + skip, n - skip, enc.charset == Charset::UTF16BE, out);
+    }
+    return 0;
+}
+
+size_t Transcoder::fromUtf8(Charset cs, const char* p, size_t n, char* out,
+                            size_t& written, bool last) {
+    if (cs == Charset::UTF8) {
+        memcpy(out, p, n);
+        written = n;
+        return n;
+    }
+    return gKernels.from(cs, reinterpret_cast<const uint8_t*>(p), n, out, written, last);
+}
+
+std::string Transcoder::bom(const TextEncoding& enc) {
+    if (!enc.bom) return "";
+    switch (enc.charset) {
+    case Charset::UTF8:    return "\xEF\xBB\xBF";
+    case Charset::UTF16LE: return "\xFF\xFE";
+    case Charset::UTF16BE: return "\xFE\xFF";
+    case Charset::Latin1:  break;
+    }
+    return "";
+}
+
+const char* Transcoder::name(const TextEncoding& enc) {
+    switch (enc.charset) {
+    case Charset::UTF8:    return enc.bom ? "UTF-8 BOM" : "UTF-8";
+    case Charset::UTF16LE: return "UTF-16 LE";
+    case Charset::UTF16BE: return "UTF-16 BE";
+    case Charset::Latin1:  return "Latin-1";
+    }
+    return "?";
+}
@@ -0,0 +1,220 @@
+#include "trigramindex.h"
+#include <algorithm>
+
+// Bloques de ~64 KiB (se cortan en el primer salto de línea siguiente)
+static const uint64_t kBlockBytes = 64u << 10;
+// 2^14 cubos: con unos pocos miles de trigramas distintos por bloque
+// cada bitmap queda poco lleno y el AND descarta casi todo
+static const int      kBucketBits = 14;
+static const uint32_t kBuckets    = 1u << kBucketBits;
+// Bytes entre cada comprobación de cancelación
+static const uint64_t kCheckBytes = 1u << 20;
+
+static inline uint8_t fold(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? (uint8_t)(c | 0x20) : c;
+}
+
+static inline uint32_t bucketOf(uint32_t trigram) {
+    return (trigram * 2654435761u) >> (32 - kBucketBits);
+}
+
+TrigramIndex::~TrigramIndex() {
+    stop();
+}
+
+void TrigramIndex::stop() {
+    cancel_ = true;
+    if (thread_.joinable()) thread_.join();
+    cancel_   = false;
+    finished_ = false;
+    builtBlocks_.clear();
+    builtPostings_.clear();
+    pendingEdits_.clear();
+}
+
+void TrigramIndex::reset() {
+    stop();
+    ready_ = false;
+    blocks_.clear();
+    postings_.clear();
+    dirtyCount_ = 0;
+}
+
+size_t TrigramIndex::memoryBytes() const {
+    size_t bytes = blocks_.capacity() * sizeof(Block);
+    for (const Bitmap& b : postings_) bytes += b.capacity() * sizeof(uint64_t);
+    return bytes;
+}
+
+// ── Construcción ──────────────────────────────────────────────────
+// El índice anterior (si lo hay) se sigue usando hasta que termine.
+void TrigramIndex::build(TextSnapshot snap) {
+    stop();
+    thread_ = std::thread([this, snap = std::move(snap)] {
+        std::vector<Block>  blocks;
+        std::vector<Bitmap> postings(kBuckets);
+
+        // Cubos vistos en el bloque actual
+        std::vector<uint64_t> seen(kBuckets / 64, 0);
+        std::vector<uint32_t> touched;
+
+        uint64_t blockStart = 0, pos = 0, nextCheck = kCheckBytes;
+        uint32_t trigram = 0;
+        int      have = 0;   // bytes acumulados en `trigram` desde el último '\n'
+
+        auto closeBlock = [&](uint64_t end) {
+            size_t idx = blocks.size();
+            blocks.push_back({ end - blockStart, false });
+            for (uint32_t b : touched) {
+                Bitmap& bits = postings[b];
+                if (bits.size() <= idx / 64) bits.resize(idx / 64 + 1, 0);
+                bits[idx / 64] |= 1ull << (idx % 64);
+                seen[b / 64] = 0;
+            }
+            touched.clear();
+            blockStart = end;
+        };
+
+        bool complete = snap.forEachSpanWhile(0, snap.size(), [&](const char* p, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                // Dentro del tramo: el original intacto es uno solo
+                if (pos >= nextCheck) {
+                    nextCheck = pos + kCheckBytes;
+                    if (cancel_) return false;
+                }
+                uint8_t c = (uint8_t)p[i];
+                ++pos;
+                if (c == '\n') {
+                    // Las agujas no cruzan líneas: trigramas sin '\n'
+                    have = 0;
+                    if (pos - blockStart >= kBlockBytes) closeBlock(pos);
+                    continue;
+                }
+                trigram = ((trigram << 8) | fold(c)) & 0xFFFFFF;
+                if (++have < 3) continue;
+                uint32_t b = bucketOf(trigram);
+                uint64_t bit = 1ull << (b % 64);
+                if (!(seen[b / 64] & bit)) {
+                    seen[b / 64] |= bit;
+                    touched.push_back(b);
+                }
+            }
+            return true;
+        });
+        if (!complete || cancel_) return;
+        if (pos > blockStart) closeBlock(pos);
+
+        size_t words = (blocks.size() + 63) / 64;
+        for (Bitmap& bits : postings) bits.resize(words, 0);
+
+        std::lock_guard<std::mutex> lock(mtx_);
+        builtBlocks_   = std::move(blocks);
+        builtPostings_ = std::move(postings);
+        finished_      = true;
+    });
+}
+
+bool TrigramIndex::adopt() {
+    if (!finished_) return false;
+    thread_.join();
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        blocks_   = std::move(builtBlocks_);
+        postings_ = std::move(builtPostings_);
+    }
+    finished_   = false;
+    ready_      = true;
+    dirtyCount_ = 0;
+    // Lo editado mientras tanto no está en la instantánea
+    for (const Edit& e : pendingEdits_) applyEdit(e);
+    pendingEdits_.clear();
+    return true;
+}
+
+// ── Ediciones ─────────────────────────────────────────────────────
+void TrigramIndex::noteEdit(uint64_t offset, uint64_t removed, uint64_t inserted) {
+    Edit e{ offset, removed, inserted };
+    if (building()) pendingEdits_.push_back(e);
+    if (ready_) applyEdit(e);
+}
+
+void TrigramIndex::applyEdit(const Edit& e) {
+    if (blocks_.empty()) return;
+    auto markDirty = [&](size_t i) {
+        if (!blocks_[i].dirty) {
+            blocks_[i].dirty = true;
+            ++dirtyCount_;
+        }
+    };
+
+    // Bloque que contiene `offset`
+    uint64_t start = 0;
+    size_t i = 0;
+    while (i < blocks_.size() && start + blocks_[i].length <= e.offset)
+        start += blocks_[i++].length;
+    if (i == blocks_.size()) {
+        // Más allá de lo indexado: esa cola siempre se recorre, pero
+        // puede continuar la última línea del último bloque
+        markDirty(blocks_.size() - 1);
+        return;
+    }
+
+    // Lo borrado puede abarcar varios bloques (alguno queda vacío)
+    uint64_t left = e.removed;
+    uint64_t off  = e.offset - start;
+    for (size_t j = i; j < blocks_.size(); ++j, off = 0) {
+        markDirty(j);
+        uint64_t take = std::min(left, blocks_[j].length - off);
+        blocks_[j].length -= take;
+        left -= take;
+        if (left == 0) break;
+    }
+    blocks_[i].length += e.inserted;
+}
+
+// ── Consulta ──────────────────────────────────────────────────────
+// Los límites entre bloques limpios siguen en inicio de línea, así que
+// una coincidencia queda dentro de un bloque... salvo junto a un bloque
+// sucio, cuyos límites pudieron moverse: con él se recorren sus vecinos.
+bool TrigramIndex::candidates(const std::string& needle, uint64_t docSize, Ranges& out) {
+    adopt();
+    out.clear();
+    if (!ready_ || needle.size() < 3 || needle.find('\n') != std::string::npos)
+        return false;
+
+    size_t nb = blocks_.size();
+    size_t words = (nb + 63) / 64;
+    Bitmap acc(words, ~0ull);
+    uint32_t trigram = 0;
+    for (size_t k = 0; k < needle.size(); ++k) {
+        trigram = ((trigram << 8) | fold((uint8_t)needle[k])) & 0xFFFFFF;
+        if (k < 2) continue;
+        const Bitmap& bits = postings_[bucketOf(trigram)];
+        for (size_t w = 0; w < words; ++w) acc[w] &= bits[w];
+    }
+    if (dirtyCount_ > 0) {
+        for (size_t i = 0; i < nb; ++i) {
+            if (!blocks_[i].dirty) continue;
+            for (size_t j = (i ? i - 1 : 0); j <= std::min(i + 1, nb - 1); ++j)
+                acc[j / 64] |= 1ull << (j % 64);
+        }
+    }
+
+    uint64_t start = 0;
+    for (size_t i = 0; i < nb; ++i) {
+        uint64_t len = blocks_[i].length;
+        if ((acc[i / 64] >> (i % 64)) & 1) {
+            if (!out.empty() && out.back().second == start) out.back().second += len;
+            else if (len > 0)                               out.push_back({ start, start + len });
+        }
+        start += len;
+    }
+    // Cola sin indexar (añadida al final tras construir)
+    if (docSize > start) {
+        if (!out.empty() && out.back().second == start) out.back().second = docSize;
+        else                                            out.push_back({ start, docSize });
+    }
+    for (auto& r : out) r.second = std::min(r.second, docSize);
+    while (!out.empty() && out.back().first >= out.back().second) out.pop_back();
+    return true;
+}
@@ -0,0 +1,150 @@
+#include "undolog.h"
+
+// ── Memoria ───────────────────────────────────────────────────────
+size_t UndoLog::Step::bytes() const {
+    return sizeof(Step) + deltas.capacity() * sizeof(Delta) +
+           removed.capacity() + inserted.capacity();
+}
+
+UndoLog::UndoLog(size_t budget)
+    : budget_(budget), bytes_(0), open_(false), grouping_(false), paused_(false)
+{
+}
+
+void UndoLog::setBudget(size_t bytes) {
+    budget_ = bytes;
+    enforceBudget();
+}
+
+void UndoLog::clear() {
+    undo_.clear();
+    redo_.clear();
+    bytes_ = 0;
+    open_  = false;
+}
+
+void UndoLog::clearRedo() {
+    for (const Step& s : redo_) bytes_ -= s.bytes();
+    redo_.clear();
+}
+
+// Primero lo más viejo de deshacer; si aún sobra, lo más lejano de rehacer
+void UndoLog::enforceBudget() {
+    while (bytes_ > budget_ && !undo_.empty()) {
+        bytes_ -= undo_.front().bytes();
+        undo_.pop_front();
+        if (undo_.empty()) open_ = false;
+    }
+    while (bytes_ > budget_ && !redo_.empty()) {
+        bytes_ -= redo_.front().bytes();
+        redo_.pop_front();
+    }
+}
+
+// ── Registro ──────────────────────────────────────────────────────
+// Fusiones sobre el último tramo `d` (lo puesto por d está al final de
+// s.inserted y lo quitado al final de s.removed):
+//  - escribir justo después de lo puesto        → se agrega a lo puesto
+//  - borrar el final de lo puesto (Backspace)   → se achica lo puesto
+//  - borrar justo antes de lo quitado (Backspace) / en el mismo lugar
+//    (Supr) sin nada puesto                      → se agrega a lo quitado
+//  - poner donde se quitó sin nada puesto        → reemplazo
+bool UndoLog::merge(Step& s, uint64_t offset, const char* removed, size_t removedLen,
+                    const char* inserted, size_t insertedLen) {
+    if (s.bulk || s.deltas.empty()) return false;
+    Delta& d = s.deltas.back();
+
+    if (removedLen == 0) {
+        if (offset == d.offset + d.inserted && (d.inserted > 0 || offset == d.offset)) {
+            s.inserted.append(inserted, insertedLen);
+            d.inserted += insertedLen;
+            return true;
+        }
+        return false;
+    }
+    if (insertedLen != 0) return false;
+
+    if (d.inserted > 0) {
+        if (offset < d.offset || offset + removedLen != d.offset + d.inserted) return false;
+        s.inserted.resize(s.inserted.size() - removedLen);
+        d.inserted -= removedLen;
+        if (d.inserted == 0 && d.removed == 0) s.deltas.pop_back();
+        return true;
+    }
+    if (offset + removedLen == d.offset) {
+        s.removed.insert(s.removed.size() - d.removed, removed, removedLen);
+        d.offset   = offset;
+        d.removed += removedLen;
+        return true;
+    }
+    if (offset == d.offset) {
+        s.removed.append(removed, removedLen);
+        d.removed += removedLen;
+        return true;
+    }
+    return false;
+}
+
+void UndoLog::record(uint64_t offset, const char* removed, size_t removedLen,
+                     const char* inserted, size_t insertedLen) {
+    if (paused_ || (removedLen == 0 && insertedLen == 0)) return;
+    clearRedo();
+
+    if (open_ && !undo_.empty()) {
+        Step& s = undo_.back();
+        bytes_ -= s.bytes();
+        bool merged = merge(s, offset, removed, removedLen, inserted, insertedLen);
+        if (!merged && grouping_) {
+            s.deltas.push_back({ offset, removedLen, insertedLen });
+            s.removed.append(removed, removedLen);
+            s.inserted.append(inserted, insertedLen);
+            merged = true;
+        }
+        bytes_ += s.bytes();
+        if (merged) {
+            enforceBudget();
+            return;
+        }
+    }
+
+    undo_.emplace_back();
+    Step& s = undo_.back();
+    s.deltas.push_back({ offset, removedLen, insertedLen });
+    if (removedLen)  s.removed.assign(removed, removedLen);
+    if (insertedLen) s.inserted.assign(inserted, insertedLen);
+    bytes_ += s.bytes();
+    open_ = true;
+    enforceBudget();
+}
+
+void UndoLog::recordBulk(Step&& step) {
+    if (paused_ || step.deltas.empty()) return;
+    clearRedo();
+    step.bulk = true;
+    undo_.push_back(std::move(step));
+    bytes_ += undo_.back().bytes();
+    open_ = false;
+    enforceBudget();
+}
+
+// ── Deshacer / rehacer ────────────────────────────────────────────
+const UndoLog::Step* UndoLog::undo() {
+    open_ = false;
+    // Un paso puede quedar vacío (escribir y borrarlo todo con Backspace)
+    while (!undo_.empty() && undo_.back().deltas.empty()) {
+        bytes_ -= undo_.back().bytes();
+        undo_.pop_back();
+    }
+    if (undo_.empty()) return nullptr;
+    redo_.push_back(std::move(undo_.back()));
+    undo_.pop_back();
+    return &redo_.back();
+}
+
+const UndoLog::Step* UndoLog::redo() {
+    open_ = false;
+    if (redo_.empty()) return nullptr;
+    undo_.push_back(std::move(redo_.back()));
+    redo_.pop_back();
+    return &undo_.back();
+}
@@ -0,0 +1,266 @@
+#include "wrapindex.h"
+#include "columnmap.h"
+#include "textbuffer.h"
+#include <cstring>
+#include <vector>
+
+// Hasta tantas líneas se miden con el ColumnMap, sin recorrer sus
+// bytes: teclear en una línea de 50 MB cuesta lo mismo que en una corta
+static const int kFewLines = 64;
+
+struct WrapIndex::Node {
+    int      rows;          // filas de cada línea del tramo
+    int      count;         // líneas del tramo
+    uint32_t prio;
+    Node*    left  = nullptr;
+    Node*    right = nullptr;
+    int      lines = 0;     // líneas del subárbol
+    int64_t  total = 0;     // filas del subárbol
+};
+
+// ── Helpers internos ──────────────────────────────────────────────
+template <typename N> static inline int     subLines(const N* n) { return n ? n->lines : 0; }
+template <typename N> static inline int64_t subTotal(const N* n) { return n ? n->total : 0; }
+
+// ── Constructor / Destructor ──────────────────────────────────────
+WrapIndex::WrapIndex() : root_(nullptr), width_(80), docLines_(0), seed_(0x9E3779B9u) {}
+
+WrapIndex::~WrapIndex() {
+    destroy(root_);
+}
+
+void WrapIndex::reset(int width) {
+    destroy(root_);
+    root_  = nullptr;
+    width_ = width > 0 ? width : 1;
+}
+
+int WrapIndex::lines() const {
+    return subLines(root_);
+}
+
+int64_t WrapIndex::totalRows() const {
+    return subTotal(root_);
+}
+
+// ── Treap ─────────────────────────────────────────────────────────
+uint32_t WrapIndex::nextPrio() {
+    // xorshift32, como en TextBuffer
+    seed_ ^= seed_ << 13;
+    seed_ ^= seed_ >> 17;
+    seed_ ^= seed_ << 5;
+    return seed_;
+}
+
+WrapIndex::Node* WrapIndex::newNode(int rows, int count) {
+    Node* n  = new Node();
+    n->rows  = rows;
+    n->count = count;
+    n->prio  = nextPrio();
+    update(n);
+    return n;
+}
+
+void WrapIndex::update(Node* t) {
+    t->lines = subLines(t->left) + t->count + subLines(t->right);
+    t->total = subTotal(t->left) + (int64_t)t->rows * t->count + subTotal(t->right);
+}
+
+WrapIndex::Node* WrapIndex::merge(Node* a, Node* b) {
+    if (!a) return b;
+    if (!b) return a;
+    if (a->prio > b->prio) {
+        a->right = merge(a->right, b);
+        update(a);
+        return a;
+    }
+    b->left = merge(a, b->left);
+    update(b);
+    return b;
+}
+
+// Separa en las primeras `lines` líneas y el resto, partiendo un tramo
+void WrapIndex::split(Node* t, int lines, Node*& l, Node*& r) {
+    if (!t) { l = r = nullptr; return; }
+
+    int ll = subLines(t->left);
+    if (lines <= ll) {
+        split(t->left, lines, l, t->left);
+        update(t);
+        r = t;
+    } else if (lines >= ll + t->count) {
+        split(t->right, lines - ll - t->count, t->right, r);
+        update(t);
+        l = t;
+    } else {
+        int   m    = lines - ll;
+        Node* tail = newNode(t->rows, t->count - m);
+        t->count = m;
+        Node* rest = t->right;
+        t->right = nullptr;
+        update(t);
+        l = t;
+        r = merge(tail, rest);
+    }
+}
+
+void WrapIndex::destroy(Node* t) {
+    if (!t) return;
+    destroy(t->left);
+    destroy(t->right);
+    delete t;
+}
+
+// Agrega líneas al final; si el último tramo tiene las mismas filas se
+// alarga en lugar de crear otro nodo
+WrapIndex::Node* WrapIndex::appendRun(Node* t, int rows, int count) {
+    Node* tail = t;
+    while (tail && tail->right) tail = tail->right;
+    if (tail && tail->rows == rows) {
+        for (Node* n = t; n; n = n->right) {
+            n->lines += count;
+            n->total += (int64_t)rows * count;
+        }
+        tail->count += count;
+        return t;
+    }
+    return merge(t, newNode(rows, count));
+}
+
+// ── Medición ──────────────────────────────────────────────────────
+// Tramos de filas de las líneas [from, to), recorriendo sus bytes una
+// vez. Una línea partida entre piezas se mide con el ColumnMap.
+static void measureLines(ColumnMap& cols, int from, int to, int width,
+                         std::vector<std::pair<int, int>>& runs) {
+    runs.clear();
+    if (from >= to) return;
+    const TextBuffer& buf = cols.buffer();
+    auto push = [&](uint64_t columns) {
+        int rows = WrapIndex::rowsFor(columns, width);
+        if (!runs.empty() && runs.back().first == rows) ++runs.back().second;
+        else runs.push_back({ rows, 1 });
+    };
+    uint64_t a = buf.lineStart(from);
+    uint64_t b = to < buf.lineCount() ? buf.lineStart(to) : buf.size();
+    int      line  = from;
+    bool     split = false;   // la línea en curso empezó en otra pieza
+    buf.forEachSpan(a, b - a, [&](const char* p, size_t n) {
+        size_t pos = 0;
+        while (pos < n) {
+            const char* nl = (const char*)memchr(p + pos, '\n', n - pos);
+            if (!nl) {
+                split = true;
+                return;
+            }
+            size_t end = (size_t)(nl - p);
+            if (split) {
+                push(cols.width(line));
+            } else {
+                size_t len = end - pos;
+                if (len > 0 && p[end - 1] == '\r') --len;
+                push(ColumnMap::columns(p + pos, len));
+            }
+            ++line;
+            split = false;
+            pos   = end + 1;
+        }
+    });
+    // La última línea del documento no termina en '\n'
+    if (to == buf.lineCount()) push(cols.width(to - 1));
+}
+
+void WrapIndex::measure(ColumnMap& cols, int upTo) {
+    const TextBuffer& buf = cols.buffer();
+    // La carga perezosa completó la que era la última línea
+    if (lines() > 0 && lines() == docLines_ && buf.lineCount() > docLines_) truncate(lines() - 1);
+    std::vector<std::pair<int, int>> runs;
+    measureLines(cols, lines(), upTo, width_, runs);
+    for (const auto& run : runs) root_ = appendRun(root_, run.first, run.second);
+    docLines_ = buf.lineCount();
+}
+
+bool WrapIndex::replaceLines(ColumnMap& cols, int row, int oldLines, int newLines) {
+    Node *l, *m, *r;
+    split(root_, row, l, m);
+    split(m, oldLines, m, r);
+    int64_t before = subTotal(m);
+    destroy(m);
+
+    Node* added = nullptr;
+    if (newLines <= kFewLines) {
+        for (int line = row; line < row + newLines; ++line)
+            added = appendRun(added, rowsFor(cols.width(line), width_), 1);
+    } else {
+        std::vector<std::pair<int, int>> runs;
+        measureLines(cols, row, row + newLines, width_, runs);
+        for (const auto& run : runs) added = appendRun(added, run.first, run.second);
+    }
+    int64_t after = subTotal(added);
+    root_ = merge(merge(l, added), r);
+    docLines_ += newLines - oldLines;
+    return before != after || oldLines != newLines;
+}
+
+void WrapIndex::truncate(int lines) {
+    Node *l, *r;
+    split(root_, lines, l, r);
+    destroy(r);
+    root_ = l;
+}
+
+// ── Consultas ─────────────────────────────────────────────────────
+int WrapIndex::rows(int line) const {
+    const Node* t = root_;
+    while (t) {
+        int ll = subLines(t->left);
+        if (line < ll) {
+            t = t->left;
+        } else if (line < ll + t->count) {
+            return t->rows;
+        } else {
+            line -= ll + t->count;
+            t = t->right;
+        }
+    }
+    return 1;
+}
+
+int64_t WrapIndex::rowsBefore(int line) const {
+    int64_t    acc = 0;
+    const Node* t  = root_;
+    while (t) {
+        int ll = subLines(t->left);
+        if (line <= ll) {
+            t = t->left;
+        } else if (line <= ll + t->count) {
+            return acc + subTotal(t->left) + (int64_t)t->rows * (line - ll);
+        } else {
+            acc  += subTotal(t->left) + (int64_t)t->rows * t->count;
+            line -= ll + t->count;
+            t = t->right;
+        }
+    }
+    return acc;
+}
+
+int WrapIndex::lineAtRow(int64_t row, int& sub) const {
+    int         base = 0;
+    const Node* t    = root_;
+    while (t) {
+        int64_t lt  = subTotal(t->left);
+        int64_t own = (int64_t)t->rows * t->count;
+        if (row < lt) {
+            t = t->left;
+        } else if (row < lt + own) {
+            row -= lt;
+            sub  = (int)(row % t->rows);
+            return base + subLines(t->left) + (int)(row / t->rows);
+        } else {
+            row  -= lt + own;
+            base += subLines(t->left) + t->count;
+            t = t->right;
+        }
+    }
+    sub = 0;
+    return base > 0 ? base - 1 : 0;
+}